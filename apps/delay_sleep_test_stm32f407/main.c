@@ -0,0 +1,231 @@
+/*******************************************************************************
+* File Name:    main.c
+*
+* Description:  This is the source code for the sleep delay test application
+* for STM32F407 MCU. It measures the accuracy of the sleeping delays
+* delay_us_sleep()/delay_ms_sleep() against the spinning delay_us()/delay_ms()
+* and delay_us_systick(), and the wakeup latency of WFI against spinning on the
+* timebase. Then it runs the spinning and the sleeping delays in turns, for
+* measuring the supply current of each.
+*
+* Related Document: See README.md
+*
+*******************************************************************************/
+#include <stdio.h>
+#include "stm32f4xx.h"
+#include "stm32f407xx.h"
+#include "bsp_aj_stm32f4.h"
+#include "rcc_aj_stm32f4.h"
+#include "timer_aj_stm32f4.h"
+#include "delay_aj_stm32f4.h"
+#include "utils_aj_stm32f4.h"
+#include "retarget_stdio_aj_stm32f4.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Number of samples of the wakeup latency */
+#define LATENCY_SAMPLES                     (64U)
+/* Time from the alignment to the timebase tick till the wakeup */
+#define LATENCY_WAKE_TICKS                  (100U)
+
+/* Length of each phase of the supply current test */
+#define CURRENT_PHASE_MILSEC                (5000U)
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+typedef enum delay_mode_e
+{
+    DELAY_MODE_SPIN,
+    DELAY_MODE_SYSTICK,
+    DELAY_MODE_SLEEP,
+} delay_mode_e_t;
+
+static const char *delay_mode_name[] = {"spin", "systick", "sleep"};
+
+/* Delays measured, in us */
+static const uint32_t delay_test_us[] = {10U, 49U, 50U, 100U, 1000U, 10000U, 100000U};
+
+static uint32_t cycles_per_usec = 0;
+
+/*******************************************************************************
+ * Function Name: delay_run()
+ *******************************************************************************
+ * Summary:
+ *  Runs a delay with the delay function of the mode, the ms functions are used
+ *  for the whole ms delays.
+ *
+ ******************************************************************************/
+static void delay_run(delay_mode_e_t mode, uint32_t us)
+{
+    bool whole_ms = (0U == (us % 1000U));
+
+    switch (mode)
+    {
+    case DELAY_MODE_SPIN:
+        (whole_ms) ? (delay_ms(us / 1000U)) : (delay_us(us));
+        break;
+    case DELAY_MODE_SYSTICK:
+        (whole_ms) ? (delay_ms_systick(us / 1000U)) : (delay_us_systick(us));
+        break;
+    default:
+        (whole_ms) ? (delay_ms_sleep(us / 1000U)) : (delay_us_sleep(us));
+        break;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: delay_accuracy_test()
+ *******************************************************************************
+ * Summary:
+ *  Measures each delay of each mode with the DWT cycle counter and prints the
+ *  error against the requested delay.
+ *
+ ******************************************************************************/
+static void delay_accuracy_test(void)
+{
+    uint32_t i = 0, start = 0, cycles = 0, expected = 0;
+    int32_t error = 0;
+    delay_mode_e_t mode = DELAY_MODE_SPIN;
+
+    for (mode = DELAY_MODE_SPIN; mode <= DELAY_MODE_SLEEP; mode++)
+    {
+        /* delay_us_systick() needs the SysTick period to be 1 us */
+        if (DELAY_MODE_SYSTICK == mode)
+        {
+            systick_config_init(0, cycles_per_usec);
+        }
+
+        for (i = 0; i < (sizeof(delay_test_us) / sizeof(delay_test_us[0])); i++)
+        {
+            start = cyccnt_get();
+            delay_run(mode, delay_test_us[i]);
+            cycles = cyccnt_get() - start;
+
+            expected = delay_test_us[i] * cycles_per_usec;
+            error = (int32_t)(cycles - expected);
+
+            printf("test=accuracy,mode=%s,delay_us=%u,cycles=%u,error_cycles=%d,error_ppm=%d\r\n",
+                   delay_mode_name[mode], (unsigned int)delay_test_us[i], (unsigned int)cycles,
+                   (int)error, (int)(((int64_t)error * 1000000) / (int64_t)expected));
+            printf_retarget_flush();
+        }
+
+        if (DELAY_MODE_SYSTICK == mode)
+        {
+            SysTick->CTRL = 0;
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: latency_sample()
+ *******************************************************************************
+ * Summary:
+ *  Returns the cycles from a timebase tick till the core resumes the thread,
+ *  waiting for the tick either in WFI with the wakeup compare or spinning on
+ *  get_time_us(). The wait is started on a tick edge, so the tick of the
+ *  wakeup is at a known cycle.
+ *
+ ******************************************************************************/
+static int32_t latency_sample(bool sleep)
+{
+    uint32_t cnt = TIMEBASE_TIM_INST->CNT;
+    uint32_t start = 0;
+    uint64_t wake_us = 0;
+
+    /* Align to a tick edge */
+    while (TIMEBASE_TIM_INST->CNT == cnt);
+
+    start = cyccnt_get();
+    wake_us = get_time_us() + LATENCY_WAKE_TICKS;
+
+    if (sleep)
+    {
+        timebase_wakeup_set(wake_us);
+        while (get_time_us() < wake_us)
+        {
+            __WFI();
+        }
+    }
+    else
+    {
+        while (get_time_us() < wake_us);
+    }
+
+    return (int32_t)((cyccnt_get() - start) - (LATENCY_WAKE_TICKS * cycles_per_usec));
+}
+
+/*******************************************************************************
+ * Function Name: latency_test()
+ *******************************************************************************
+ * Summary:
+ *  Prints the min, avg and max wakeup latency of WFI and of spinning.
+ *
+ ******************************************************************************/
+static void latency_test(bool sleep)
+{
+    uint32_t i = 0;
+    int32_t sample = 0, min = INT32_MAX, max = INT32_MIN, sum = 0;
+
+    for (i = 0; i < LATENCY_SAMPLES; i++)
+    {
+        sample = latency_sample(sleep);
+
+        min = (sample < min) ? (sample) : (min);
+        max = (sample > max) ? (sample) : (max);
+        sum += sample;
+    }
+
+    printf("test=wake_latency,mode=%s,samples=%u,min_cycles=%d,avg_cycles=%d,max_cycles=%d\r\n",
+           (sleep) ? ("sleep") : ("spin"), LATENCY_SAMPLES, (int)min,
+           (int)(sum / (int32_t)LATENCY_SAMPLES), (int)max);
+    printf_retarget_flush();
+}
+
+/*******************************************************************************
+ * Function Name: main()
+ *******************************************************************************
+ * Summary:
+ *  This is the main function. It prints the accuracy and the wakeup latency
+ *  results, then runs the spinning and the sleeping delay in turns.
+ *
+ * Parameters:
+ *
+ * Return :
+ *  int
+ *
+ ******************************************************************************/
+int main()
+{
+    /* Initialize the BSP */
+    stm32f4_bsp_init();
+
+    printf_retarget_uart_init();
+
+    /* The 1 MHz timebase wakes up the sleeping delays */
+    timebase_init();
+
+    cyccnt_init();
+    cycles_per_usec = get_ahb_clock() / 1000000U;
+
+    printf("\r\n# Sleep delay test, core_clock=%u\r\n", (unsigned int)get_ahb_clock());
+    printf_retarget_flush();
+
+    delay_accuracy_test();
+
+    latency_test(false);
+    latency_test(true);
+
+    while (1)
+    {
+        printf("# phase=spin for %u ms\r\n", CURRENT_PHASE_MILSEC);
+        printf_retarget_flush();
+        delay_ms(CURRENT_PHASE_MILSEC);
+
+        printf("# phase=sleep for %u ms\r\n", CURRENT_PHASE_MILSEC);
+        printf_retarget_flush();
+        delay_ms_sleep(CURRENT_PHASE_MILSEC);
+    }
+}
@@ -0,0 +1,128 @@
+/*******************************************************************************
+* File Name:    main.c
+*
+* Description:  This is the source code for the log router test application for
+* STM32F407 MCU. Records are routed to the printf UART, the crash ring in the
+* backup SRAM and a secondary UART, each with it's own level filter.
+*
+* Related Document: See README.md
+*
+*******************************************************************************/
+#include <stdio.h>
+#include "stm32f4xx.h"
+#include "stm32f407xx.h"
+#include "bsp_aj_stm32f4.h"
+#include "usart_aj_stm32f4.h"
+#include "delay_aj_stm32f4.h"
+#include "retarget_stdio_aj_stm32f4.h"
+#include "log_aj_stm32f4.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Secondary UART of the log */
+#define LOG_UART_INSTANCE                   (USART2)
+#define LOG_UART_TX_PORT                    (GPIOA)
+#define LOG_UART_TX_PIN                     (2)
+#define LOG_UART_RX_PORT                    (GPIOA)
+#define LOG_UART_RX_PIN                     (3)
+
+/* Size of the Tx ring of the secondary UART, must be a power of two */
+#define LOG_UART_RING_SIZE                  (512U)
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+uint8_t log_uart_ring[LOG_UART_RING_SIZE];
+
+/* Define the USART configs */
+usart_config_st_t usart2cfg = {
+    .compatmode = USART_COMPATIBLE_MODE_ASYNC,
+    .stopbits = USART_STOPBIT_1,
+    .txrxmode = USART_TXRX_MODE_RX_TX_BOTH_EN,
+    .hwflowctrl = USART_FLOWCTRL_NONE,
+    .instance = LOG_UART_INSTANCE,
+    .baudrate = 115200,
+    .wordlen = USART_WORD_LEN_8_BIT,
+    .oversample = USART_OVERSAMPLE_BY_16,
+    .parity_en = USART_PARITY_DISABLE,
+    .parity = 0,
+};
+
+/*******************************************************************************
+ * Function Name: main()
+ *******************************************************************************
+ * Summary:
+ *  This is the main function. It prints the crash ring of the previous run,
+ *  then logs records of all levels in a loop and resets the MCU every 100
+ *  loops. The debug records are removed at compile time unless LOG_MIN_LEVEL
+ *  is set to LOG_LEVEL_DEBUG in the build options.
+ *
+ * Parameters:
+ *
+ * Return :
+ *  int
+ *
+ ******************************************************************************/
+int main()
+{
+    log_stats_st_t stats;
+    uint32_t loop_cnt = 0, start = 0;
+
+    /* Initialize the BSP */
+    stm32f4_bsp_init();
+
+    printf_retarget_uart_init();
+
+    /* Secondary UART gets only the warnings and errors */
+    usart_config(&usart2cfg, LOG_UART_TX_PORT, LOG_UART_TX_PIN, LOG_UART_RX_PORT, LOG_UART_RX_PIN);
+    usart_init(&usart2cfg);
+    log_uart_sink_init(&usart2cfg, log_uart_ring, LOG_UART_RING_SIZE, LOG_LEVEL_WARN);
+
+    /* The crash ring keeps everything which is compiled in, the ring of the run
+     * before the reset is printed first.
+     */
+    if (log_ram_init(LOG_MIN_LEVEL))
+    {
+        printf("---- crash ring from before the reset ----\r\n");
+        log_ram_dump();
+        printf("------------------------------------------\r\n");
+        log_ram_clear();
+    }
+
+    LOG_INF("log test, min level %u", LOG_MIN_LEVEL);
+
+    /* Cost of a timestamp read, the call itself included */
+    start = cyccnt_get();
+    (void)timestamp_get();
+    LOG_INF("timestamp_get() %u cycles", cyccnt_get() - start);
+
+    while (1)
+    {
+        loop_cnt++;
+
+        LOG_DBG("loop %u", loop_cnt);
+
+        if (0U == (loop_cnt % 10U))
+        {
+            LOG_INF("loop %u done", loop_cnt);
+        }
+
+        if (0U == (loop_cnt % 50U))
+        {
+            log_get_stats(&stats);
+            LOG_WRN("loop %u, records=%u uart_drops=%u", loop_cnt, stats.record_cnt,
+                    stats.uart_drop_cnt);
+        }
+
+        /* Simulated crash, the records before it are printed after the reset */
+        if (0U == (loop_cnt % 100U))
+        {
+            LOG_ERR("loop %u, simulated crash, resetting", loop_cnt);
+            printf_retarget_flush();
+            NVIC_SystemReset();
+        }
+
+        delay_ms(100);
+    }
+}
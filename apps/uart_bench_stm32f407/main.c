@@ -0,0 +1,606 @@
+/*******************************************************************************
+* File Name:    main.c
+*
+* Description:  This is the source code for the UART throughput benchmark
+* application for STM32F407 MCU. It measures the Tx and Rx throughput, the CPU
+* cycles per byte and the CPU occupancy of each transfer mode of the USART lib,
+* at several baud rates with 16 and 8 oversampling, and the latency of the USART
+* interrupt event dispatch. The results are printed as "key=value" records.
+*
+* Related Document: See README.md
+*
+*******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "stm32f4xx.h"
+#include "stm32f407xx.h"
+#include "bsp_aj_stm32f4.h"
+#include "rcc_aj_stm32f4.h"
+#include "usart_aj_stm32f4.h"
+#include "utils_aj_stm32f4.h"
+#include "retarget_stdio_aj_stm32f4.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* UART under test, it's Tx (PA2) should be wired to it's Rx (PA3) */
+#define BENCH_USART_INSTANCE                (USART2)
+#define BENCH_USART_TX_PORT                 (GPIOA)
+#define BENCH_USART_TX_PIN                  (2)
+#define BENCH_USART_RX_PORT                 (GPIOA)
+#define BENCH_USART_RX_PIN                  (3)
+
+/* Size of the test frame, the Tx and Rx rings hold a whole frame */
+#define BENCH_FRAME_SIZE                    (1024U)
+#define BENCH_RING_SIZE                     (BENCH_FRAME_SIZE)
+/* DMA Rx ring, the callback consumes each half while the other is filled */
+#define BENCH_DMA_RX_RING_SIZE              (256U)
+
+/* Lines of the printf bench, BENCH_PRINTF_LINES * BENCH_PRINTF_LINE_LEN bytes */
+#define BENCH_PRINTF_LINES                  (16U)
+#define BENCH_PRINTF_LINE_LEN               (64U)
+
+/* Number of samples of the interrupt latency */
+#define BENCH_LATENCY_SAMPLES               (64U)
+
+/* Cycles of the free CPU work loop reference */
+#define BENCH_IDLE_REF_CYCLES               (1000000U)
+
+/* Extra wait for the Rx of a frame, in frame times */
+#define BENCH_RX_TIMEOUT_FRAMES             (4U)
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+/* Result of a transfer */
+typedef struct bench_result_st
+{
+    uint32_t bytes;             /* Bytes transferred */
+    uint32_t cycles;            /* Cycles from start till the last byte */
+    uint32_t cpu_permille;      /* CPU occupancy during the transfer */
+    uint32_t errors;            /* Bytes lost or corrupted */
+} bench_result_st_t;
+
+static const uint32_t bench_baud[] = {115200U, 460800U, 921600U, 2000000U};
+static const uint8_t bench_oversample[] = {USART_OVERSAMPLE_BY_16, USART_OVERSAMPLE_BY_8};
+
+uint8_t tx_frame[BENCH_FRAME_SIZE];
+uint8_t rx_frame[BENCH_FRAME_SIZE];
+uint8_t tx_ring[BENCH_RING_SIZE];
+uint8_t rx_ring[BENCH_RING_SIZE];
+uint8_t dma_rx_ring[BENCH_DMA_RX_RING_SIZE];
+
+/* Work loop iterations of the free CPU in BENCH_IDLE_REF_CYCLES */
+static uint32_t idle_ref = 0;
+
+static volatile bool dma_tx_done = false;
+static volatile bool dma_rx_done = false;
+static volatile uint32_t dma_rx_cnt = 0;
+static volatile uint32_t dma_rx_end = 0;
+
+static volatile uint32_t latency_start = 0;
+static volatile uint32_t latency_cycles = 0;
+static volatile bool latency_done = false;
+
+usart_config_st_t bench_usartcfg = {
+    .compatmode = USART_COMPATIBLE_MODE_ASYNC,
+    .stopbits = USART_STOPBIT_1,
+    .txrxmode = USART_TXRX_MODE_RX_TX_BOTH_EN,
+    .hwflowctrl = USART_FLOWCTRL_NONE,
+    .instance = BENCH_USART_INSTANCE,
+    .baudrate = 115200,
+    .wordlen = USART_WORD_LEN_8_BIT,
+    .oversample = USART_OVERSAMPLE_BY_16,
+    .parity_en = USART_PARITY_DISABLE,
+    .parity = 0,
+};
+
+/* Defined by the retarget lib, the printf bench runs on it */
+extern usart_config_st_t printf_usartcfg;
+
+/*******************************************************************************
+ * Function Name: idle_loop_run()
+ *******************************************************************************
+ * Summary:
+ *  Stand-in for application work, spins till the stop flag is set or the
+ *  cycle budget is over. The number of iterations it completes tells how much
+ *  of the CPU was left to the application.
+ *
+ * Parameters:
+ *  stop:        Flag to stop the loop
+ *  max_cycles:  Cycle budget of the loop
+ *
+ * Return :
+ *  uint32_t:    Number of loop iterations completed
+ *
+ ******************************************************************************/
+static uint32_t idle_loop_run(volatile bool *stop, uint32_t max_cycles)
+{
+    uint32_t iterations = 0;
+    uint32_t start = cyccnt_get();
+
+    while ((!(*stop)) && ((cyccnt_get() - start) < max_cycles))
+    {
+        iterations++;
+    }
+
+    return iterations;
+}
+
+/*******************************************************************************
+ * Function Name: bench_cpu_permille()
+ *******************************************************************************
+ * Summary:
+ *  Returns the CPU occupancy of a window in 1/1000 units, from the work loop
+ *  iterations done in the window against the rate of the free CPU.
+ *
+ * Parameters:
+ *  iterations:  Work loop iterations done in the window
+ *  cycles:      Length of the window
+ *
+ * Return :
+ *  uint32_t:    Occupancy, 0 - 1000
+ *
+ ******************************************************************************/
+static uint32_t bench_cpu_permille(uint32_t iterations, uint32_t cycles)
+{
+    uint32_t free_permille = 0;
+
+    if ((0U == cycles) || (0U == idle_ref))
+    {
+        return 1000U;
+    }
+
+    free_permille = (uint32_t)(((uint64_t)iterations * BENCH_IDLE_REF_CYCLES * 1000U) /
+                               ((uint64_t)idle_ref * cycles));
+
+    return (free_permille < 1000U) ? (1000U - free_permille) : (0U);
+}
+
+/*******************************************************************************
+ * Function Name: bench_report()
+ *******************************************************************************
+ * Summary:
+ *  Prints the record of a transfer. The throughput is in bytes/s, the CPU
+ *  cycles per byte are the occupied part of the transfer time per byte.
+ *
+ ******************************************************************************/
+static void bench_report(const char *mode, uint32_t baud, uint8_t oversample,
+                         const bench_result_st_t *res)
+{
+    uint32_t core_clock = get_ahb_clock();
+    uint32_t bps = 0, cpb = 0;
+
+    if ((0U != res->cycles) && (0U != res->bytes))
+    {
+        bps = (uint32_t)(((uint64_t)res->bytes * core_clock) / res->cycles);
+        cpb = (uint32_t)(((uint64_t)res->cycles * res->cpu_permille) / (1000U * (uint64_t)res->bytes));
+    }
+
+    printf("mode=%s,baud=%u,over8=%u,bytes=%u,cycles=%u,bytes_per_sec=%u,"
+           "cpu_permille=%u,cpu_cycles_per_byte=%u,errors=%u\r\n",
+           mode, (unsigned int)baud, (unsigned int)oversample, (unsigned int)res->bytes,
+           (unsigned int)res->cycles, (unsigned int)bps, (unsigned int)res->cpu_permille,
+           (unsigned int)cpb, (unsigned int)res->errors);
+
+    /* Keep the printf UART interrupt quiet during the next measurement */
+    printf_retarget_flush();
+}
+
+/*******************************************************************************
+ * Function Name: bench_rx_clear()
+ *******************************************************************************
+ * Summary:
+ *  Discards a byte and the overrun left in the Rx of the UART under test by the
+ *  Tx only benches, by reading SR followed by DR.
+ *
+ ******************************************************************************/
+static void bench_rx_clear(void)
+{
+    (void)BENCH_USART_INSTANCE->SR;
+    (void)BENCH_USART_INSTANCE->DR;
+}
+
+/*******************************************************************************
+ * Function Name: bench_rx_errors()
+ *******************************************************************************
+ * Summary:
+ *  Returns the number of bytes missing or different from the transmitted frame.
+ *
+ ******************************************************************************/
+static uint32_t bench_rx_errors(uint32_t rx_cnt)
+{
+    uint32_t i = 0, errors = BENCH_FRAME_SIZE - rx_cnt;
+
+    for (i = 0; i < rx_cnt; i++)
+    {
+        errors += (tx_frame[i] != rx_frame[i]) ? (1U) : (0U);
+    }
+
+    return errors;
+}
+
+/*******************************************************************************
+ * Function Name: dma_tx_done_cb()
+ *******************************************************************************
+ * Summary:
+ *  Called from the DMA ISR when the frame is transmitted.
+ *
+ ******************************************************************************/
+static void dma_tx_done_cb(usart_config_st_t *usart_cfg, uint8_t *tx_buff,
+                           usart_status_e_t status)
+{
+    dma_tx_done = true;
+}
+
+/*******************************************************************************
+ * Function Name: dma_rx_cb()
+ *******************************************************************************
+ * Summary:
+ *  Called from the ISR with the data received by DMA, copies it into the
+ *  receive frame and stamps the time of the last byte of the frame.
+ *
+ ******************************************************************************/
+static void dma_rx_cb(usart_config_st_t *usart_cfg, uint8_t *rx_data, uint16_t rx_data_size,
+                      bool frame_end)
+{
+    uint32_t cnt = dma_rx_cnt;
+
+    if (rx_data_size > (BENCH_FRAME_SIZE - cnt))
+    {
+        rx_data_size = (uint16_t)(BENCH_FRAME_SIZE - cnt);
+    }
+
+    memcpy(&rx_frame[cnt], rx_data, rx_data_size);
+    dma_rx_cnt = cnt + rx_data_size;
+
+    if (BENCH_FRAME_SIZE == dma_rx_cnt)
+    {
+        dma_rx_end = cyccnt_get();
+        dma_rx_done = true;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: latency_txe_cb()
+ *******************************************************************************
+ * Summary:
+ *  TXE event callback of the latency bench, the time from enabling the event
+ *  with TXE already set till here is the interrupt entry and dispatch latency.
+ *
+ ******************************************************************************/
+static void latency_txe_cb(usart_config_st_t *usart_cfg, uint32_t sr, void *cb_arg)
+{
+    latency_cycles = cyccnt_get() - latency_start;
+    usart_event_enable(usart_cfg, USART_EVENT_TXE, false);
+    latency_done = true;
+}
+
+/*******************************************************************************
+ * Function Name: bench_latency()
+ *******************************************************************************
+ * Summary:
+ *  Measures the latency of the USART event callback, from the interrupt
+ *  request to the first instruction of the callback, and prints the min, avg
+ *  and max in core cycles.
+ *
+ ******************************************************************************/
+static void bench_latency(void)
+{
+    uint32_t i = 0, min = UINT32_MAX, max = 0, sum = 0;
+
+    usart_register_callback(&bench_usartcfg, USART_EVENT_TXE, latency_txe_cb, NULL);
+
+    for (i = 0; i < BENCH_LATENCY_SAMPLES; i++)
+    {
+        latency_done = false;
+
+        /* TXE is set while the Tx is idle, the interrupt is raised on enable */
+        latency_start = cyccnt_get();
+        BENCH_USART_INSTANCE->CR1 |= USART_CR1_TXEIE_Msk;
+
+        while (!latency_done)
+            ;
+
+        min = (latency_cycles < min) ? (latency_cycles) : (min);
+        max = (latency_cycles > max) ? (latency_cycles) : (max);
+        sum += latency_cycles;
+    }
+
+    usart_register_callback(&bench_usartcfg, USART_EVENT_TXE, NULL, NULL);
+
+    printf("mode=isr_latency,samples=%u,min_cycles=%u,avg_cycles=%u,max_cycles=%u\r\n",
+           BENCH_LATENCY_SAMPLES, (unsigned int)min,
+           (unsigned int)(sum / BENCH_LATENCY_SAMPLES), (unsigned int)max);
+    printf_retarget_flush();
+}
+
+/*******************************************************************************
+ * Function Name: bench_tx_poll()
+ *******************************************************************************
+ * Summary:
+ *  Polling Tx with uart_transmit_blocking(), the CPU is occupied for the whole
+ *  frame.
+ *
+ ******************************************************************************/
+static void bench_tx_poll(bench_result_st_t *res)
+{
+    uint32_t start = cyccnt_get();
+
+    uart_transmit_blocking(&bench_usartcfg, tx_frame, BENCH_FRAME_SIZE,
+                           USART_TIMEOUT_WAIT_FOREVER, NULL);
+
+    res->cycles = cyccnt_get() - start;
+    res->bytes = BENCH_FRAME_SIZE;
+    res->cpu_permille = 1000U;
+    res->errors = 0;
+}
+
+/*******************************************************************************
+ * Function Name: bench_tx_async()
+ *******************************************************************************
+ * Summary:
+ *  Interrupt driven Tx with uart_write_async(), the frame is queued into the
+ *  Tx ring at once and sent by the TXE interrupt while the work loop runs.
+ *
+ ******************************************************************************/
+static void bench_tx_async(bench_result_st_t *res)
+{
+    uint32_t start = 0, iterations = 0;
+    volatile bool never_stop = false;
+
+    uart_write_async_init(&bench_usartcfg, tx_ring, BENCH_RING_SIZE);
+
+    start = cyccnt_get();
+    uart_write_async(&bench_usartcfg, tx_frame, BENCH_FRAME_SIZE);
+
+    while (!uart_tx_idle(&bench_usartcfg))
+    {
+        iterations += idle_loop_run(&never_stop, 1000U);
+    }
+
+    res->cycles = cyccnt_get() - start;
+    res->bytes = BENCH_FRAME_SIZE;
+    res->cpu_permille = bench_cpu_permille(iterations, res->cycles);
+    res->errors = 0;
+}
+
+/*******************************************************************************
+ * Function Name: bench_tx_dma()
+ *******************************************************************************
+ * Summary:
+ *  DMA Tx with uart_transmit_dma(), the work loop runs till the DMA completion
+ *  interrupt.
+ *
+ ******************************************************************************/
+static void bench_tx_dma(bench_result_st_t *res)
+{
+    uint32_t start = 0, iterations = 0;
+
+    dma_tx_done = false;
+
+    start = cyccnt_get();
+    uart_transmit_dma(&bench_usartcfg, tx_frame, BENCH_FRAME_SIZE);
+    iterations = idle_loop_run(&dma_tx_done, UINT32_MAX);
+
+    res->cycles = cyccnt_get() - start;
+    res->bytes = BENCH_FRAME_SIZE;
+    res->cpu_permille = bench_cpu_permille(iterations, res->cycles);
+    res->errors = 0;
+}
+
+/*******************************************************************************
+ * Function Name: bench_rx_ring()
+ *******************************************************************************
+ * Summary:
+ *  Interrupt driven Rx into the ring of uart_rx_ring_start(), the frame is
+ *  looped back from a DMA Tx. The occupancy is measured while the frame is in
+ *  flight, then the ring is read till the whole frame is received.
+ *
+ ******************************************************************************/
+static void bench_rx_ring(bench_result_st_t *res, uint32_t timeout_cycles)
+{
+    uint32_t start = 0, iterations = 0, window = 0, rx_cnt = 0;
+
+    bench_rx_clear();
+    uart_rx_ring_start(&bench_usartcfg, rx_ring, BENCH_RING_SIZE);
+
+    dma_tx_done = false;
+
+    start = cyccnt_get();
+    uart_transmit_dma(&bench_usartcfg, tx_frame, BENCH_FRAME_SIZE);
+    iterations = idle_loop_run(&dma_tx_done, timeout_cycles);
+    window = cyccnt_get() - start;
+
+    while ((rx_cnt < BENCH_FRAME_SIZE) && ((cyccnt_get() - start) < timeout_cycles))
+    {
+        rx_cnt += uart_read(&bench_usartcfg, &rx_frame[rx_cnt],
+                            (uint16_t)(BENCH_FRAME_SIZE - rx_cnt));
+    }
+
+    res->cycles = cyccnt_get() - start;
+
+    usart_event_enable(&bench_usartcfg, USART_EVENT_RXNE, false);
+
+    res->bytes = rx_cnt;
+    res->cpu_permille = bench_cpu_permille(iterations, window);
+    res->errors = bench_rx_errors(rx_cnt);
+}
+
+/*******************************************************************************
+ * Function Name: bench_rx_dma()
+ *******************************************************************************
+ * Summary:
+ *  DMA Rx with uart_rx_dma_start(), the frame is looped back from a DMA Tx and
+ *  the work loop runs till the last byte is delivered to the callback.
+ *
+ ******************************************************************************/
+static void bench_rx_dma(bench_result_st_t *res, uint32_t timeout_cycles)
+{
+    uint32_t start = 0, iterations = 0;
+
+    bench_rx_clear();
+
+    dma_rx_cnt = 0;
+    dma_rx_done = false;
+    dma_rx_end = 0;
+    uart_rx_dma_start(&bench_usartcfg, dma_rx_ring, BENCH_DMA_RX_RING_SIZE, dma_rx_cb);
+
+    start = cyccnt_get();
+    uart_transmit_dma(&bench_usartcfg, tx_frame, BENCH_FRAME_SIZE);
+    iterations = idle_loop_run(&dma_rx_done, timeout_cycles);
+
+    res->cycles = ((dma_rx_done) ? (dma_rx_end) : (cyccnt_get())) - start;
+
+    uart_rx_dma_stop(&bench_usartcfg);
+
+    res->bytes = dma_rx_cnt;
+    res->cpu_permille = bench_cpu_permille(iterations, res->cycles);
+    res->errors = bench_rx_errors(dma_rx_cnt);
+}
+
+/*******************************************************************************
+ * Function Name: bench_printf()
+ *******************************************************************************
+ * Summary:
+ *  Re-targeted printf() on the printf UART, at it's configured baud rate. The
+ *  time spent in the printf() calls, including the waits for ring space, is
+ *  counted as occupied, the drain of the ring after the calls is measured with
+ *  the work loop. The bench lines start with '#' so that they can be skipped
+ *  by a parser of the records.
+ *
+ ******************************************************************************/
+static void bench_printf(bench_result_st_t *res)
+{
+    uint32_t i = 0, start = 0, call_cycles = 0, drain_cycles = 0, iterations = 0;
+#if (PRINTF_RETARGET_MODE_BLOCKING != PRINTF_RETARGET_MODE)
+    volatile bool never_stop = false;
+#endif
+    char line[BENCH_PRINTF_LINE_LEN - 4U + 1U];
+
+    memset(line, '=', sizeof(line) - 1U);
+    line[sizeof(line) - 1U] = '\0';
+
+    printf_retarget_flush();
+
+    start = cyccnt_get();
+    for (i = 0; i < BENCH_PRINTF_LINES; i++)
+    {
+        /* "# " + line + "\r\n" is BENCH_PRINTF_LINE_LEN bytes */
+        printf("# %s\r\n", line);
+    }
+    call_cycles = cyccnt_get() - start;
+
+#if (PRINTF_RETARGET_MODE_BLOCKING != PRINTF_RETARGET_MODE)
+    while (!uart_tx_idle(&printf_usartcfg))
+    {
+        iterations += idle_loop_run(&never_stop, 1000U);
+    }
+#endif
+
+    res->cycles = cyccnt_get() - start;
+    drain_cycles = res->cycles - call_cycles;
+
+    res->bytes = BENCH_PRINTF_LINES * BENCH_PRINTF_LINE_LEN;
+    res->cpu_permille = (uint32_t)(((uint64_t)call_cycles * 1000U +
+                                    (uint64_t)bench_cpu_permille(iterations, drain_cycles) *
+                                    drain_cycles) / res->cycles);
+    res->errors = 0;
+}
+
+/*******************************************************************************
+ * Function Name: main()
+ *******************************************************************************
+ * Summary:
+ *  This is the main function. It measures the interrupt latency once, then
+ *  runs the Tx and Rx benches of each mode at each baud rate and oversampling,
+ *  and the printf bench, then stops.
+ *
+ * Parameters:
+ *
+ * Return :
+ *  int
+ *
+ ******************************************************************************/
+int main()
+{
+    bench_result_st_t res;
+    uint32_t b = 0, o = 0, frame_cycles = 0;
+    uint32_t core_clock = 0;
+    volatile bool never_stop = false;
+
+    /* Initialize the BSP */
+    stm32f4_bsp_init();
+
+    printf_retarget_uart_init();
+
+    cyccnt_init();
+    core_clock = get_ahb_clock();
+
+    /* Printable test pattern */
+    for (b = 0; b < BENCH_FRAME_SIZE; b++)
+    {
+        tx_frame[b] = (uint8_t)('A' + (b % 26U));
+    }
+
+    /* Config and initialize the UART under test and it's DMA Tx */
+    usart_config(&bench_usartcfg, BENCH_USART_TX_PORT, BENCH_USART_TX_PIN,
+                 BENCH_USART_RX_PORT, BENCH_USART_RX_PIN);
+    usart_init(&bench_usartcfg);
+    uart_dma_tx_init(&bench_usartcfg, dma_tx_done_cb);
+
+    printf("\r\n# UART bench, core_clock=%u, frame=%u bytes\r\n", (unsigned int)core_clock,
+           BENCH_FRAME_SIZE);
+    printf_retarget_flush();
+
+    /* Work rate of the free CPU, the reference of the occupancy */
+    idle_ref = idle_loop_run(&never_stop, BENCH_IDLE_REF_CYCLES);
+
+    bench_latency();
+
+    for (b = 0; b < (sizeof(bench_baud) / sizeof(bench_baud[0])); b++)
+    {
+        for (o = 0; o < sizeof(bench_oversample); o++)
+        {
+            bench_usartcfg.baudrate = bench_baud[b];
+            bench_usartcfg.oversample = bench_oversample[o];
+
+            /* Baud rate and oversampling are changed with the UART disabled */
+            usart_deinit(&bench_usartcfg);
+            if (USART_STATUS_SUCCESS != usart_config(&bench_usartcfg, BENCH_USART_TX_PORT,
+                                                     BENCH_USART_TX_PIN, BENCH_USART_RX_PORT,
+                                                     BENCH_USART_RX_PIN))
+            {
+                printf("# baud=%u over8=%u not supported\r\n", (unsigned int)bench_baud[b],
+                       (unsigned int)bench_oversample[o]);
+                continue;
+            }
+            usart_init(&bench_usartcfg);
+
+            /* Rx timeout, a few times the wire time of the frame at 10 bits per byte */
+            frame_cycles = (uint32_t)(((uint64_t)BENCH_FRAME_SIZE * 10U * core_clock) / bench_baud[b]);
+
+            bench_tx_poll(&res);
+            bench_report("tx_poll", bench_baud[b], bench_oversample[o], &res);
+
+            bench_tx_async(&res);
+            bench_report("tx_async", bench_baud[b], bench_oversample[o], &res);
+
+            bench_tx_dma(&res);
+            bench_report("tx_dma", bench_baud[b], bench_oversample[o], &res);
+
+            bench_rx_ring(&res, frame_cycles * BENCH_RX_TIMEOUT_FRAMES);
+            bench_report("rx_ring", bench_baud[b], bench_oversample[o], &res);
+
+            bench_rx_dma(&res, frame_cycles * BENCH_RX_TIMEOUT_FRAMES);
+            bench_report("rx_dma", bench_baud[b], bench_oversample[o], &res);
+        }
+    }
+
+    bench_printf(&res);
+    bench_report("printf", printf_usartcfg.baudrate, printf_usartcfg.oversample, &res);
+
+    printf("# done\r\n");
+
+    while (1);
+}
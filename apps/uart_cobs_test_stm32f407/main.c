@@ -0,0 +1,124 @@
+/*******************************************************************************
+* File Name:    main.c
+*
+* Description:  This is the source code for the UART COBS framing test
+* application for STM32F407 MCU. COBS frames received on the UART are decoded
+* as the bytes arrive and echoed back, re-encoded, to the sender.
+*
+* Related Document: See README.md
+*
+*******************************************************************************/
+#include "stm32f4xx.h"
+#include "stm32f407xx.h"
+#include "bsp_aj_stm32f4.h"
+#include "usart_aj_stm32f4.h"
+#include "cobs_aj_stm32f4.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define USART_INSTANCE                      (USART1)
+#define USART_TX_PORT                       (GPIOA)
+#define USART_TX_PIN                        (9)
+#define USART_RX_PORT                       (GPIOA)
+#define USART_RX_PIN                        (10)
+
+/* Size of the Rx ring, must be a power of two */
+#define UART_RX_RING_SIZE                   (256U)
+/* Max size of a decoded packet */
+#define COBS_PACKET_MAX_SIZE                (256U)
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+uint8_t rx_ring[UART_RX_RING_SIZE];
+uint8_t rx_chunk[UART_RX_RING_SIZE];
+
+/* Decoded packet and it's encoded echo */
+uint8_t packet_buff[COBS_PACKET_MAX_SIZE];
+uint8_t echo_buff[COBS_ENC_MAX_SIZE(COBS_PACKET_MAX_SIZE)];
+
+cobs_decoder_st_t cobs_dec;
+
+/* Define the USART configs */
+usart_config_st_t usart1cfg = {
+    .compatmode = USART_COMPATIBLE_MODE_ASYNC,
+    .stopbits = USART_STOPBIT_1,
+    .txrxmode = USART_TXRX_MODE_RX_TX_BOTH_EN,
+    .hwflowctrl = USART_FLOWCTRL_NONE,
+    .instance = USART_INSTANCE,
+    .baudrate = 115200,
+    .wordlen = USART_WORD_LEN_8_BIT,
+    .oversample = USART_OVERSAMPLE_BY_16,
+    .parity_en = USART_PARITY_DISABLE,
+    .parity = 0,
+};
+
+/*******************************************************************************
+ * Function Name: cobs_frame_cb()
+ *******************************************************************************
+ * Summary:
+ *  Called by the COBS decoder with each complete frame, echoes the frame back.
+ *
+ * Parameters:
+ *  cb_arg:      Pointer to USART configs
+ *  frame:       Decoded frame
+ *  frame_size:  Size of the decoded frame
+ *
+ * Return :
+ *  void
+ *
+ ******************************************************************************/
+static void cobs_frame_cb(void *cb_arg, uint8_t *frame, uint16_t frame_size)
+{
+    usart_config_st_t *usart_cfg = (usart_config_st_t *)cb_arg;
+    uint16_t enc_size = 0;
+
+    if (COBS_STATUS_SUCCESS == cobs_encode(frame, frame_size, echo_buff, sizeof(echo_buff),
+                                           &enc_size))
+    {
+        uart_transmit_blocking(usart_cfg, echo_buff, enc_size, USART_TIMEOUT_WAIT_FOREVER, NULL);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: main()
+ *******************************************************************************
+ * Summary:
+ *  This is the main function. It feeds the received bytes to the COBS decoder,
+ *  the frames are echoed from the decoder callback.
+ *
+ * Parameters:
+ *
+ * Return :
+ *  int
+ *
+ ******************************************************************************/
+int main()
+{
+    uint16_t rx_len = 0;
+
+    /* Initialize the BSP */
+    stm32f4_bsp_init();
+
+    usart_config_st_t *usart1cfg_ptr = &usart1cfg;
+
+    /* Config and initialize the USART channel */
+    usart_config(usart1cfg_ptr, USART_TX_PORT, USART_TX_PIN, USART_RX_PORT, USART_RX_PIN);
+    usart_init(usart1cfg_ptr);
+
+    cobs_decoder_init(&cobs_dec, packet_buff, COBS_PACKET_MAX_SIZE, cobs_frame_cb, usart1cfg_ptr);
+
+    /* Start the interrupt driven reception into the Rx ring */
+    uart_rx_ring_start(usart1cfg_ptr, rx_ring, UART_RX_RING_SIZE);
+
+    while(1)
+    {
+        /* Each byte is decoded once, frames complete on their delimiter */
+        rx_len = uart_read(usart1cfg_ptr, rx_chunk, UART_RX_RING_SIZE);
+        if(0U != rx_len)
+        {
+            cobs_decode(&cobs_dec, rx_chunk, rx_len);
+        }
+    }
+}
@@ -0,0 +1,214 @@
+/*******************************************************************************
+* File Name:    main.c
+*
+* Description:  This is the source code for the UART DMA transmit test
+* application for STM32F407 MCU. It measures the CPU occupancy of a frame
+* transmission using uart_transmit_blocking() and uart_transmit_dma(), and
+* sends a header/payload/trailer frame with the scatter-gather uart_transmit_v().
+*
+* Related Document: See README.md
+*
+*******************************************************************************/
+#include <stdio.h>
+#include "stm32f4xx.h"
+#include "stm32f407xx.h"
+#include "bsp_aj_stm32f4.h"
+#include "usart_aj_stm32f4.h"
+#include "utils_aj_stm32f4.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define USART_INSTANCE                      (USART1)
+#define USART_TX_PORT                       (GPIOA)
+#define USART_TX_PIN                        (9)
+#define USART_RX_PORT                       (GPIOA)
+#define USART_RX_PIN                        (10)
+
+/* Size of the test frame, 1 KB telemetry frame */
+#define TEST_FRAME_SIZE                     (1024U)
+#define REPORT_BUFF_SIZE                    (128U)
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+uint8_t tx_frame[TEST_FRAME_SIZE];
+char report_buff[REPORT_BUFF_SIZE];
+
+/* Header and trailer sent around the frame, without copying them together */
+uint8_t frame_header[] = "<frame>\r\n";
+uint8_t frame_trailer[] = "</frame>\r\n";
+uart_iovec_st_t frame_iov[] = {
+    {frame_header, sizeof(frame_header) - 1U},
+    {tx_frame, TEST_FRAME_SIZE},
+    {frame_trailer, sizeof(frame_trailer) - 1U},
+};
+
+volatile bool dma_tx_done = false;
+
+/*******************************************************************************
+ * Function Name: dma_tx_done_cb()
+ *******************************************************************************
+ * Summary:
+ *  Called from the DMA ISR when the frame is transmitted.
+ *
+ * Parameters:
+ *  usart_cfg:  Pointer to USART configs
+ *  tx_buff:    The transmitted buffer
+ *  status:     Transfer status
+ *
+ * Return :
+ *  void
+ *
+ ******************************************************************************/
+static void dma_tx_done_cb(usart_config_st_t *usart_cfg, uint8_t *tx_buff,
+                           usart_status_e_t status)
+{
+    dma_tx_done = true;
+}
+
+/*******************************************************************************
+ * Function Name: idle_loop_run()
+ *******************************************************************************
+ * Summary:
+ *  Stand-in for application work, spins till the stop flag is set or the
+ *  cycle budget is over. The number of iterations it completes tells how much
+ *  of the CPU was available to the application.
+ *
+ * Parameters:
+ *  stop:        Flag to stop the loop
+ *  max_cycles:  Cycle budget of the loop
+ *
+ * Return :
+ *  uint32_t:    Number of loop iterations completed
+ *
+ ******************************************************************************/
+static uint32_t idle_loop_run(volatile bool *stop, uint32_t max_cycles)
+{
+    uint32_t iterations = 0;
+    uint32_t start = cyccnt_get();
+
+    while ((!(*stop)) && ((cyccnt_get() - start) < max_cycles))
+    {
+        iterations++;
+    }
+
+    return iterations;
+}
+
+/*******************************************************************************
+ * Function Name: report()
+ *******************************************************************************
+ * Summary:
+ *  Sends a report line on the UART using the blocking transmit.
+ *
+ ******************************************************************************/
+static void report(usart_config_st_t *usart_cfg, int len)
+{
+    if (len > 0)
+    {
+        uart_transmit_blocking(usart_cfg, (uint8_t *)report_buff, (uint16_t)len,
+                               USART_TIMEOUT_WAIT_FOREVER, NULL);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: main()
+ *******************************************************************************
+ * Summary:
+ *  This is the main function. It transmits the same frame with blocking and
+ *  DMA transmit, and reports the cycles spent and CPU occupancy of each.
+ *
+ * Parameters:
+ *
+ * Return :
+ *  int
+ *
+ ******************************************************************************/
+int main()
+{
+    uint32_t start = 0, blocking_cycles = 0, dma_call_cycles = 0, dma_cycles = 0;
+    uint32_t idle_ref = 0, idle_dma = 0, dma_occupancy_permille = 0;
+    uint32_t dma_v_call_cycles = 0, dma_v_cycles = 0;
+    bool never_stop = false;
+
+    /* Initialize the BSP */
+    stm32f4_bsp_init();
+
+    /* Define the USART configs */
+    usart_config_st_t usart1cfg = {
+        .compatmode = USART_COMPATIBLE_MODE_ASYNC,
+        .stopbits = USART_STOPBIT_1,
+        .txrxmode = USART_TXRX_MODE_RX_TX_BOTH_EN,
+        .hwflowctrl = USART_FLOWCTRL_NONE,
+        .instance = USART_INSTANCE,
+        .baudrate = 115200,
+        .wordlen = USART_WORD_LEN_8_BIT,
+        .oversample = USART_OVERSAMPLE_BY_16,
+        .parity_en = USART_PARITY_DISABLE,
+        .parity = 0,
+    };
+
+    usart_config_st_t *usart1cfg_ptr = &usart1cfg;
+
+    /* Config and initialize the USART channel and it's DMA Tx */
+    usart_config(usart1cfg_ptr, USART_TX_PORT, USART_TX_PIN, USART_RX_PORT, USART_RX_PIN);
+    usart_init(usart1cfg_ptr);
+    uart_dma_tx_init(usart1cfg_ptr, dma_tx_done_cb);
+
+    cyccnt_init();
+
+    /* Printable test pattern, one line per 64 bytes */
+    for (uint32_t i = 0; i < TEST_FRAME_SIZE; i++)
+    {
+        tx_frame[i] = (uint8_t)(((i % 64U) < 62U) ? ('A' + (i % 26U)) : (((i % 64U) == 62U) ? '\r' : '\n'));
+    }
+
+    /* 1. Blocking transmit, the CPU is occupied for the whole frame */
+    start = cyccnt_get();
+    uart_transmit_blocking(usart1cfg_ptr, tx_frame, TEST_FRAME_SIZE,
+                           USART_TIMEOUT_WAIT_FOREVER, NULL);
+    blocking_cycles = cyccnt_get() - start;
+
+    /* 2. Reference, the work the CPU can do in the same time when free */
+    idle_ref = idle_loop_run(&never_stop, blocking_cycles);
+
+    /* 3. DMA transmit, the CPU runs the work loop till the frame is sent */
+    dma_tx_done = false;
+    start = cyccnt_get();
+    uart_transmit_dma(usart1cfg_ptr, tx_frame, TEST_FRAME_SIZE);
+    dma_call_cycles = cyccnt_get() - start;
+    idle_dma = idle_loop_run(&dma_tx_done, UINT32_MAX);
+    dma_cycles = cyccnt_get() - start;
+
+    /* Occupancy = 1 - (work rate during DMA / work rate of the free CPU) */
+    dma_occupancy_permille = (uint32_t)(((uint64_t)idle_dma * blocking_cycles * 1000U) /
+                                        ((uint64_t)idle_ref * dma_cycles));
+    dma_occupancy_permille = (dma_occupancy_permille < 1000U) ? (1000U - dma_occupancy_permille) : (0U);
+
+    /* 4. Scatter-gather DMA transmit of header, frame and trailer */
+    dma_tx_done = false;
+    start = cyccnt_get();
+    uart_transmit_v(usart1cfg_ptr, frame_iov, sizeof(frame_iov) / sizeof(frame_iov[0]));
+    dma_v_call_cycles = cyccnt_get() - start;
+    (void)idle_loop_run(&dma_tx_done, UINT32_MAX);
+    dma_v_cycles = cyccnt_get() - start;
+
+    /* Machine readable results, one "key=value" record per line */
+    report(usart1cfg_ptr, snprintf(report_buff, REPORT_BUFF_SIZE,
+                                   "\r\nmode=blocking,bytes=%u,cycles=%u,cpu_permille=1000\r\n",
+                                   TEST_FRAME_SIZE, (unsigned int)blocking_cycles));
+    report(usart1cfg_ptr, snprintf(report_buff, REPORT_BUFF_SIZE,
+                                   "mode=dma,bytes=%u,cycles=%u,call_cycles=%u,cpu_permille=%u\r\n",
+                                   TEST_FRAME_SIZE, (unsigned int)dma_cycles,
+                                   (unsigned int)dma_call_cycles,
+                                   (unsigned int)dma_occupancy_permille));
+    report(usart1cfg_ptr, snprintf(report_buff, REPORT_BUFF_SIZE,
+                                   "mode=dma_v,segments=%u,bytes=%u,cycles=%u,call_cycles=%u\r\n",
+                                   (unsigned int)(sizeof(frame_iov) / sizeof(frame_iov[0])),
+                                   (unsigned int)(sizeof(frame_header) + TEST_FRAME_SIZE +
+                                                  sizeof(frame_trailer) - 2U),
+                                   (unsigned int)dma_v_cycles, (unsigned int)dma_v_call_cycles));
+
+    while (1);
+}
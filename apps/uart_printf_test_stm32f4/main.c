@@ -8,20 +8,124 @@
 *
 *******************************************************************************/
 #include <stdio.h>
+#include <string.h>
 #include "stm32f4xx.h"
 #include "stm32f407xx.h"
 #include "bsp_aj_stm32f4.h"
 #include "usart_aj_stm32f4.h"
 #include "delay_aj_stm32f4.h"
+#include "utils_aj_stm32f4.h"
 #include "retarget_stdio_aj_stm32f4.h"
+#include "printf_lite_aj_stm32f4.h"
 
 
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* Number of calls averaged for the cycle count */
+#define PRINTF_BENCH_CALLS          (16U)
+
+/* Stack painted below the current SP for the stack usage, it should be less
+ * than the free stack (Stack_Size of the startup file is 0x400).
+ */
+#define PRINTF_BENCH_STACK_WORDS    (160U)
+#define PRINTF_BENCH_STACK_PAINT    (0xDEADBEEFU)
+
+
+/*******************************************************************************
+* Global Variables
+*******************************************************************************/
+typedef enum printf_bench_engine_e
+{
+    PRINTF_BENCH_LIBC,
+    PRINTF_BENCH_LITE,
+} printf_bench_engine_e_t;
+
+
+/*******************************************************************************
+ * Function Name: printf_bench_call()
+ *******************************************************************************
+ * Summary:
+ *  Prints the same line with either of the printf engines.
+ *
+ ******************************************************************************/
+static void printf_bench_call(printf_bench_engine_e_t engine, uint32_t idx)
+{
+    if (PRINTF_BENCH_LIBC == engine)
+    {
+        printf("bench %u: int = %d, hex = 0x%08X, float = %.3f\r\n",
+               idx, -141, 0xC0FFEEU, 235.893f);
+    }
+    else
+    {
+        printf_lite("bench %u: int = %d, hex = 0x%08X, float = %.3f\r\n",
+                    idx, -141, 0xC0FFEEU, LITE_F(235.893f));
+    }
+}
+
+/*******************************************************************************
+ * Function Name: printf_bench_cycles()
+ *******************************************************************************
+ * Summary:
+ *  Returns the average core cycles of a call, the output is flushed before each
+ *  call so that the time of the UART is not counted, only the formatting and
+ *  the queuing into the stdout ring.
+ *
+ ******************************************************************************/
+static uint32_t printf_bench_cycles(printf_bench_engine_e_t engine)
+{
+    uint32_t i = 0, start = 0, cycles = 0;
+
+    for (i = 0; i < PRINTF_BENCH_CALLS; i++)
+    {
+        printf_retarget_flush();
+
+        start = cyccnt_get();
+        printf_bench_call(engine, i);
+        cycles += cyccnt_get() - start;
+    }
+
+    printf_retarget_flush();
+
+    return cycles / PRINTF_BENCH_CALLS;
+}
+
+/*******************************************************************************
+ * Function Name: printf_bench_stack()
+ *******************************************************************************
+ * Summary:
+ *  Returns the stack used by a call in bytes, the stack below the current SP
+ *  is painted before the call and the untouched words are counted after it.
+ *
+ ******************************************************************************/
+static uint32_t printf_bench_stack(printf_bench_engine_e_t engine)
+{
+    volatile uint32_t *bottom = (volatile uint32_t *)(__get_MSP() - 32U) - PRINTF_BENCH_STACK_WORDS;
+    uint32_t i = 0;
+
+    for (i = 0; i < PRINTF_BENCH_STACK_WORDS; i++)
+    {
+        bottom[i] = PRINTF_BENCH_STACK_PAINT;
+    }
+
+    printf_bench_call(engine, 0);
+
+    for (i = 0; (i < PRINTF_BENCH_STACK_WORDS) && (PRINTF_BENCH_STACK_PAINT == bottom[i]); i++)
+        ;
+
+    printf_retarget_flush();
+
+    /* Includes the 32 bytes kept below SP and the frame of printf_bench_call() */
+    return (4U * (PRINTF_BENCH_STACK_WORDS - i)) + 32U;
+}
+
 /*******************************************************************************
  * Function Name: main()
  *******************************************************************************
  * Summary:
  *  This is the main function. It prints a message on the serial terminal using
- *  re-targeted printf().
+ *  re-targeted printf(), then compares the cycles per call and the stack usage
+ *  of printf() and printf_lite(), then echoes the lines typed on stdin.
  *
  * Parameters:
  *
@@ -31,18 +135,49 @@
  ******************************************************************************/
 int main()
 {
+    uint32_t libc_cycles = 0, lite_cycles = 0, libc_stack = 0, lite_stack = 0;
+    char line[PRINTF_RETARGET_STDIN_LINE_SIZE];
+    printf_retarget_stats_st_t stats;
+
     /* Initialize the BSP */
     stm32f4_bsp_init();
 
     printf_retarget_uart_init();
 
+    cyccnt_init();
+
     /* Clear screen and move cursor to terminal's home position (0,0). */
     printf("\x1b[1J\x1b[H");
 
     /* Print Hello world message, an integer and a float value. */
     printf("----------------------------------------------\r\n");
     printf("Hello World !!!   int = %d, float = %f\r\n", 141, 235.89324);
+    printf_lite("Hello Lite  !!!   int = %d, float = %f\r\n", 141, LITE_F(235.89324f));
     printf("----------------------------------------------\r\n");
 
-    while (1);
+    libc_stack = printf_bench_stack(PRINTF_BENCH_LIBC);
+    lite_stack = printf_bench_stack(PRINTF_BENCH_LITE);
+    libc_cycles = printf_bench_cycles(PRINTF_BENCH_LIBC);
+    lite_cycles = printf_bench_cycles(PRINTF_BENCH_LITE);
+
+    printf_lite("----------------------------------------------\r\n");
+    printf_lite("engine=printf cycles_per_call=%u stack_bytes=%u\r\n", libc_cycles, libc_stack);
+    printf_lite("engine=printf_lite cycles_per_call=%u stack_bytes=%u\r\n", lite_cycles, lite_stack);
+
+    printf_retarget_get_stats(&stats, true);
+    printf_lite("stdout mode=%u drop_bytes=%u drop_cnt=%u write_max_cycles=%u\r\n",
+                PRINTF_RETARGET_MODE, stats.drop_bytes, stats.drop_cnt, stats.write_max_cycles);
+    printf_lite("----------------------------------------------\r\n");
+
+    /* Echo console on stdin, the core sleeps in fgets() till Enter is pressed */
+    while (1)
+    {
+        printf("> ");
+
+        if (NULL != fgets(line, sizeof(line), stdin))
+        {
+            line[strcspn(line, "\n")] = '\0';
+            printf("line=%s\r\n", line);
+        }
+    }
 }
@@ -21,7 +21,8 @@
 #define USART_TX_PIN                        (9)
 #define USART_RX_PORT                       (GPIOA)
 #define USART_RX_PIN                        (10)
-#define UART_RX_INTR_INST                   (USART1_IRQn)
+/* Size of the Rx ring, must be a power of two */
+#define UART_RX_RING_SIZE                   (64U)
 
 
 /*******************************************************************************
@@ -30,32 +31,25 @@
 uint8_t tx_buff[] = "\x1b[1J\x1b[H\r\n======= UART RX IRQ test !!! =======\r\n\nStart typing to see echo -\r\n";
 uint8_t tx_buff_size = sizeof(tx_buff)/sizeof(tx_buff[0]);
 
-uint8_t rx_data = 0;
-bool rx_intr_flag = 0;
+/* Storage for the Rx ring, filled by the USART1 RX interrupt */
+uint8_t rx_ring[UART_RX_RING_SIZE];
 
+/* Data read from the Rx ring, for echo */
+uint8_t rx_data[UART_RX_RING_SIZE];
 
-/*******************************************************************************
- * Function Name: USART1_IRQHandler()
- *******************************************************************************
- * Summary:
- *  ISR for USART1 interrupt.
- *
- * Parameters:
- *  void
- *
- * Return :
- *  void
- *
- ******************************************************************************/
-void USART1_IRQHandler(void)
-{
-    /* If RX operation complete, received data can be safely read. */
-    if(USART1->SR & (1U << USART_SR_RXNE_Pos))
-    {
-        rx_data = USART1->DR;
-        rx_intr_flag = 1;
-    }
-}
+/* Define the USART configs */
+usart_config_st_t usart1cfg = {
+    .compatmode = USART_COMPATIBLE_MODE_ASYNC,
+    .stopbits = USART_STOPBIT_1,
+    .txrxmode = USART_TXRX_MODE_RX_TX_BOTH_EN,
+    .hwflowctrl = USART_FLOWCTRL_NONE,
+    .instance = USART_INSTANCE,
+    .baudrate = 115200,
+    .wordlen = USART_WORD_LEN_8_BIT,
+    .oversample = USART_OVERSAMPLE_BY_16,
+    .parity_en = USART_PARITY_DISABLE,
+    .parity = 0,
+};
 
 
 /*******************************************************************************
@@ -73,23 +67,11 @@ void USART1_IRQHandler(void)
  ******************************************************************************/
 int main()
 {
+    uint16_t rx_len = 0;
+
     /* Initialize the BSP */
     stm32f4_bsp_init();
 
-    /* Define the USART configs */
-    usart_config_st_t usart1cfg = {
-        .compatmode = USART_COMPATIBLE_MODE_ASYNC,
-        .stopbits = USART_STOPBIT_1,
-        .txrxmode = USART_TXRX_MODE_RX_TX_BOTH_EN,
-        .hwflowctrl = USART_FLOWCTRL_NONE,
-        .instance = USART_INSTANCE,
-        .baudrate = 115200,
-        .wordlen = USART_WORD_LEN_8_BIT,
-        .oversample = USART_OVERSAMPLE_BY_16,
-        .parity_en = USART_PARITY_DISABLE,
-        .parity = 0,
-    };
-
     usart_config_st_t *usart1cfg_ptr = &usart1cfg;
 
     /* Config the USART channel */
@@ -98,26 +80,26 @@ int main()
     /* Initialize the USART channel */
     usart_init(usart1cfg_ptr);
 
-    /* Initialize the UART RX interrupt */
-    uart_rx_interrupt_set(usart1cfg_ptr->instance, 1);
-
-    __disable_irq();
-
-    NVIC_SetPriority(UART_RX_INTR_INST, 3);
-
-    NVIC_EnableIRQ(UART_RX_INTR_INST);
-
-    __enable_irq();
+    /* Start the interrupt driven reception into the Rx ring, this also
+     * enables the UART RX interrupt in NVIC, USART1_IRQHandler is provided by
+     * the USART lib.
+     */
+    uart_rx_ring_start(usart1cfg_ptr, rx_ring, UART_RX_RING_SIZE);
 
     /* Transmit intro message */
-    uart_transmit_blocking(usart1cfg_ptr, tx_buff, tx_buff_size, 0);
+    uart_transmit_blocking(usart1cfg_ptr, tx_buff, tx_buff_size,
+                           USART_TIMEOUT_WAIT_FOREVER, NULL);
 
     while(1)
     {
-        if(1 == rx_intr_flag)
+        /* Echo everything received since the last read, bursts are kept in
+         * the Rx ring while the echo of the previous data is ongoing.
+         */
+        rx_len = uart_read(usart1cfg_ptr, rx_data, UART_RX_RING_SIZE);
+        if(0U != rx_len)
         {
-            uart_transmit_blocking(usart1cfg_ptr, &rx_data, 1, 0);
-            rx_intr_flag = 0;
+            uart_transmit_blocking(usart1cfg_ptr, rx_data, rx_len,
+                                   USART_TIMEOUT_WAIT_FOREVER, NULL);
         }
     }
 }
@@ -7,6 +7,7 @@
 * Related Document: See README.md
 *
 *******************************************************************************/
+#include <stdio.h>
 #include "stm32f4xx.h"
 #include "stm32f407xx.h"
 #include "bsp_aj_stm32f4.h"
@@ -21,6 +22,13 @@
 #define USART_RX_PORT						(GPIOA)
 #define USART_RX_PIN						(10)
 
+/* 1: the baud rate is detected from a 'U' sent by the PC, before the message,
+ * the app waits for it. 0: the fixed baud rate of the configs.
+ */
+#ifndef USART_AUTOBAUD_EN
+#define USART_AUTOBAUD_EN					(0U)
+#endif
+
 
 /*******************************************************************************
  * Global Variables
@@ -31,6 +39,17 @@ uint8_t tx_buff_size = sizeof(tx_buff)/sizeof(tx_buff[0]);
 const uint8_t rx_buff_size = 1;
 uint8_t rx_buff[rx_buff_size] = {0};
 
+#if (0U != USART_AUTOBAUD_EN)
+/* TIM1 CH3 is on the USART1 Rx pin PA10, with AF1 */
+const usart_autobaud_cfg_st_t autobaud_cfg = {
+    .TIMx = TIM1,
+    .tim_channel = 3,
+    .tim_af = 1,
+};
+
+char baud_msg[48];
+#endif
+
 /*******************************************************************************
  * Function Name: main()
  *******************************************************************************
@@ -46,6 +65,10 @@ uint8_t rx_buff[rx_buff_size] = {0};
  ******************************************************************************/
 int main()
 {
+#if (0U != USART_AUTOBAUD_EN)
+    uint32_t measured_baud = 0;
+#endif
+
     /* Initialize the BSP */
     stm32f4_bsp_init();
 
@@ -71,8 +94,25 @@ int main()
     /* Initialize the USART channel */
     usart_init(usart1cfg_ptr);
 
+#if (0U != USART_AUTOBAUD_EN)
+    /* Wait for the PC to send 'U' at any rate, the rate is locked on it */
+    while (USART_STATUS_SUCCESS != usart_autobaud_detect(usart1cfg_ptr, USART_RX_PORT,
+                                                         USART_RX_PIN, &autobaud_cfg,
+                                                         USART_TIMEOUT_WAIT_FOREVER,
+                                                         &measured_baud))
+    {
+    }
+
+    uart_transmit_blocking(usart1cfg_ptr, (uint8_t *)baud_msg,
+                           (uint16_t)snprintf(baud_msg, sizeof(baud_msg),
+                                              "\r\nbaud=%u measured=%u\r\n",
+                                              usart1cfg_ptr->baudrate, measured_baud),
+                           USART_TIMEOUT_WAIT_FOREVER, NULL);
+#endif
+
     /* Transmit Hello world message */
-    uart_transmit_blocking(usart1cfg_ptr, tx_buff, tx_buff_size, 0);
+    uart_transmit_blocking(usart1cfg_ptr, tx_buff, tx_buff_size,
+                           USART_TIMEOUT_WAIT_FOREVER, NULL);
 
     delay_ms(200);
 
@@ -80,9 +120,11 @@ int main()
     {
         /* Receive single character from the keyboard press. For this the
          * size of rx_buff kept as "1". */
-        uart_receive_poll(usart1cfg_ptr, rx_buff, rx_buff_size, 0);
+        uart_receive_poll(usart1cfg_ptr, rx_buff, rx_buff_size,
+                          USART_TIMEOUT_WAIT_FOREVER, NULL);
 
         /* Transmit back (echo) the received character, to the serial COM port */
-        uart_transmit_blocking(usart1cfg_ptr, rx_buff, rx_buff_size, 0);
+        uart_transmit_blocking(usart1cfg_ptr, rx_buff, rx_buff_size,
+                               USART_TIMEOUT_WAIT_FOREVER, NULL);
     }
 }
@@ -26,6 +26,9 @@
 void stm32f4_bsp_init(void)
 {
     delay_init(DELAY_TIM_INST);
+
+    /* 64-bit DWT timestamp for the logs and traces, also starts the timebase */
+    timestamp_init();
 }
 
 /* End of File */
@@ -35,6 +35,10 @@
 #define PRINTF_UART_HWFLOWCTRL              (USART_FLOWCTRL_NONE)
 #define PRINTF_UART_INSTANCE                (USART1)
 #define PRINTF_UART_BAUDRATE                (115200)
+/* Kernel clock of the printf UART (APB2 for USART1) as set up in SystemInit(),
+ * only used for the compile time check of the baud rate error.
+ */
+#define PRINTF_UART_CLOCK_VAL               ((uint32_t)100000000)
 #define PRINTF_UART_WORDLEN                 (USART_WORD_LEN_8_BIT)
 #define PRINTF_UART_OVERSAMPLE              (USART_OVERSAMPLE_BY_16)
 #define PRINTF_UART_PARITY_EN               (USART_PARITY_DISABLE)
@@ -0,0 +1,249 @@
+/*******************************************************************************
+ * File Name: cobs_aj_stm32f4.c
+ *
+ * Description:
+ * The file contains function definition(s) for the COBS (Consistent Overhead
+ * Byte Stuffing) packet framing used over the USART links.
+ *
+ * Related Document: See README.md
+ *
+ *******************************************************************************/
+#include "cobs_aj_stm32f4.h"
+
+/*******************************************************************************
+ * Function Name: cobs_encode()
+ ********************************************************************************
+ * Summary:
+ *   Encodes a packet into a COBS frame, terminated by the COBS_FRAME_DELIM.
+ *   Each zero byte of the packet is replaced by the distance to the next zero,
+ *   runs of 254 non-zero bytes get an extra code byte.
+ *
+ * Parameters:
+ *   packet:         Pointer to the packet
+ *   packet_size:    Size of the packet
+ *   enc_buff:       Buffer for the encoded frame, must not overlap the packet
+ *   enc_buff_size:  Size of the buffer, COBS_ENC_MAX_SIZE(packet_size) is enough
+ *   enc_size:       Returns the size of the encoded frame, with the delimiter
+ *
+ * Return :
+ *   cobs_status_e_t:    COBS_STATUS_OVERFLOW if the buffer is too small
+ *
+ *******************************************************************************/
+cobs_status_e_t cobs_encode(const uint8_t *packet, uint16_t packet_size, uint8_t *enc_buff,
+                            uint16_t enc_buff_size, uint16_t *enc_size)
+{
+    uint32_t code_pos = 0, out = 1;
+    uint16_t i = 0;
+    uint8_t code = 1;
+
+    if (((NULL == packet) && (0U != packet_size)) || (NULL == enc_buff) || (NULL == enc_size))
+    {
+        return COBS_STATUS_BAD_PARAM;
+    }
+
+    if ((uint32_t)enc_buff_size < COBS_ENC_MAX_SIZE((uint32_t)packet_size))
+    {
+        return COBS_STATUS_OVERFLOW;
+    }
+
+    for (i = 0; i < packet_size; i++)
+    {
+        if (COBS_FRAME_DELIM == packet[i])
+        {
+            enc_buff[code_pos] = code;
+            code_pos = out++;
+            code = 1;
+        }
+        else
+        {
+            enc_buff[out++] = packet[i];
+            code++;
+
+            /* Max run length, close the block */
+            if (0xFFU == code)
+            {
+                enc_buff[code_pos] = code;
+                code_pos = out++;
+                code = 1;
+            }
+        }
+    }
+
+    enc_buff[code_pos] = code;
+    enc_buff[out++] = COBS_FRAME_DELIM;
+
+    *enc_size = (uint16_t)out;
+
+    return COBS_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: cobs_decoder_init()
+ ********************************************************************************
+ * Summary:
+ *   Initializes the incremental decoder, frames longer than the buffer are
+ *   discarded and counted as errors.
+ *
+ * Parameters:
+ *   dec:                Pointer to the decoder
+ *   frame_buff:         Buffer for the decoded frame
+ *   frame_buff_size:    Size of the buffer, the max decoded frame size
+ *   frame_cb:           Called with each complete frame
+ *   cb_arg:             Argument passed to the callback
+ *
+ * Return :
+ *   cobs_status_e_t:    Status of the operation
+ *
+ *******************************************************************************/
+cobs_status_e_t cobs_decoder_init(cobs_decoder_st_t *dec, uint8_t *frame_buff,
+                                  uint16_t frame_buff_size, cobs_frame_cb_t frame_cb,
+                                  void *cb_arg)
+{
+    if ((NULL == dec) || (NULL == frame_buff) || (0U == frame_buff_size) || (NULL == frame_cb))
+    {
+        return COBS_STATUS_BAD_PARAM;
+    }
+
+    dec->buff = frame_buff;
+    dec->buff_size = frame_buff_size;
+    dec->frame_cb = frame_cb;
+    dec->cb_arg = cb_arg;
+    dec->frame_cnt = 0;
+    dec->err_cnt = 0;
+
+    cobs_decoder_reset(dec);
+
+    return COBS_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: cobs_decoder_reset()
+ ********************************************************************************
+ * Summary:
+ *   Drops the partly received frame, the decoder waits for the next frame.
+ *
+ * Parameters:
+ *   dec:            Pointer to the decoder
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+void cobs_decoder_reset(cobs_decoder_st_t *dec)
+{
+    dec->len = 0;
+    /* No zero is inserted before the first block */
+    dec->code = 0xFFU;
+    dec->remaining = 0;
+    dec->in_frame = false;
+    dec->discard = false;
+}
+
+/*******************************************************************************
+ * Function Name: cobs_decode_byte()
+ ********************************************************************************
+ * Summary:
+ *   Decodes one received byte, in constant time. The zero implied by the end
+ *   of a block is only stored when the next block starts, as the last block of
+ *   a frame has none, so the frame is complete as soon as the delimiter is
+ *   received. Safe to be called from ISR, ex: the USART Rx callback.
+ *
+ * Parameters:
+ *   dec:            Pointer to the decoder
+ *   byte:           Received byte
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+void cobs_decode_byte(cobs_decoder_st_t *dec, uint8_t byte)
+{
+    if (COBS_FRAME_DELIM == byte)
+    {
+        if (dec->in_frame && !dec->discard)
+        {
+            /* Delimiter inside a block means a truncated frame */
+            if (0U == dec->remaining)
+            {
+                dec->frame_cnt++;
+                dec->frame_cb(dec->cb_arg, dec->buff, dec->len);
+            }
+            else
+            {
+                dec->err_cnt++;
+            }
+        }
+
+        cobs_decoder_reset(dec);
+        return;
+    }
+
+    if (dec->discard)
+    {
+        return;
+    }
+
+    dec->in_frame = true;
+
+    if (0U == dec->remaining)
+    {
+        /* Code byte, the previous block ended with a zero unless it was a
+         * max length block.
+         */
+        if (0xFFU != dec->code)
+        {
+            if (dec->len >= dec->buff_size)
+            {
+                dec->discard = true;
+                dec->err_cnt++;
+                return;
+            }
+
+            dec->buff[dec->len++] = 0U;
+        }
+
+        dec->code = byte;
+        dec->remaining = (uint8_t)(byte - 1U);
+    }
+    else
+    {
+        if (dec->len >= dec->buff_size)
+        {
+            dec->discard = true;
+            dec->err_cnt++;
+            return;
+        }
+
+        dec->buff[dec->len++] = byte;
+        dec->remaining--;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cobs_decode()
+ ********************************************************************************
+ * Summary:
+ *   Decodes a chunk of received bytes, the frame callback is called for each
+ *   frame completed in the chunk. Suits the chunks handed by uart_read() and
+ *   by the DMA Rx callback of the USART lib.
+ *
+ * Parameters:
+ *   dec:            Pointer to the decoder
+ *   data:           Received bytes
+ *   data_size:      Number of received bytes
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+void cobs_decode(cobs_decoder_st_t *dec, const uint8_t *data, uint16_t data_size)
+{
+    uint16_t i = 0;
+
+    for (i = 0; i < data_size; i++)
+    {
+        cobs_decode_byte(dec, data[i]);
+    }
+}
+
+/* End of File */
@@ -0,0 +1,85 @@
+/*******************************************************************************
+* File Name: cobs_aj_stm32f4.h
+*
+* Description:
+* The file contains function declaration(s) for the COBS (Consistent Overhead
+* Byte Stuffing) packet framing used over the USART links.
+*
+* The module is plain C with no device dependency, so the same files build on
+* a Linux host for unit tests and benchmarks.
+*
+* Related Document: See README.md
+*
+*******************************************************************************/
+#ifndef COBS_AJ_STM32F4
+#define COBS_AJ_STM32F4
+
+/*******************************************************************************
+* Header Files
+*******************************************************************************/
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* Frame delimiter, the encoded data never contains it */
+#define COBS_FRAME_DELIM                    (0x00U)
+
+/* Max size of an encoded frame, including the delimiter, for a packet size.
+ * One code byte per 254 bytes of packet, plus the first code byte and the
+ * delimiter.
+ */
+#define COBS_ENC_MAX_SIZE(size)             ((size) + ((size) / 254U) + 2U)
+
+/*******************************************************************************
+* Global Variables
+*******************************************************************************/
+typedef enum cobs_status_e
+{
+    COBS_STATUS_SUCCESS,
+    COBS_STATUS_BAD_PARAM,
+    COBS_STATUS_OVERFLOW,
+} cobs_status_e_t;
+
+/* Called by the decoder with each complete frame, the frame is decoded in the
+ * decoder buffer and is valid only during the call.
+ */
+typedef void (*cobs_frame_cb_t)(void *cb_arg, uint8_t *frame, uint16_t frame_size);
+
+/* Incremental decoder state, the frame is decoded in place while the bytes are
+ * received, so no second pass is needed once the delimiter arrives.
+ */
+typedef struct cobs_decoder_st
+{
+    uint8_t *buff;
+    uint16_t buff_size;
+    uint16_t len;
+    uint8_t code;
+    uint8_t remaining;
+    bool in_frame;
+    bool discard;
+    cobs_frame_cb_t frame_cb;
+    void *cb_arg;
+    uint32_t frame_cnt;
+    uint32_t err_cnt;
+} cobs_decoder_st_t;
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+cobs_status_e_t cobs_encode(const uint8_t *packet, uint16_t packet_size, uint8_t *enc_buff,
+                            uint16_t enc_buff_size, uint16_t *enc_size);
+
+cobs_status_e_t cobs_decoder_init(cobs_decoder_st_t *dec, uint8_t *frame_buff,
+                                  uint16_t frame_buff_size, cobs_frame_cb_t frame_cb,
+                                  void *cb_arg);
+
+void cobs_decoder_reset(cobs_decoder_st_t *dec);
+
+void cobs_decode_byte(cobs_decoder_st_t *dec, uint8_t byte);
+
+void cobs_decode(cobs_decoder_st_t *dec, const uint8_t *data, uint16_t data_size);
+
+#endif /* COBS_AJ_STM32F4 */
@@ -8,12 +8,277 @@
  *
  *******************************************************************************/
 #include "delay_aj_stm32f4.h"
+#include "utils_aj_stm32f4.h"
+#include "rcc_aj_stm32f4.h"
+
+#if (DELAY_BACKEND_DWT == DELAY_BACKEND)
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Largest step of a spin on the 32-bit cycle counter, longer delays are done
+ * in steps of this size from the same start, so there is no drift.
+ */
+#define DELAY_DWT_STEP_CYCLES                   (0x80000000U)
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+/* Core cycles per us and per ms, set by delay_init() from the core clock */
+static uint32_t delay_cycles_per_usec = 0;
+static uint32_t delay_cycles_per_milsec = 0;
+
+/*******************************************************************************
+ * Function Name: delay_dwt_spin()
+ ********************************************************************************
+ * Summary:
+ *  Spins till the specified number of cycles have passed since the start value
+ *  of the DWT cycle counter.
+ *
+ * Parameters:
+ *  start:   Cycle counter value at the start of the delay
+ *  cycles:  Length of the delay in core cycles
+ *
+ * Return :
+ *  void
+ *
+ *******************************************************************************/
+static void delay_dwt_spin(uint32_t start, uint64_t cycles)
+{
+    while (cycles > DELAY_DWT_STEP_CYCLES)
+    {
+        while ((DWT->CYCCNT - start) < DELAY_DWT_STEP_CYCLES);
+
+        start += DELAY_DWT_STEP_CYCLES;
+        cycles -= DELAY_DWT_STEP_CYCLES;
+    }
+
+    while ((DWT->CYCCNT - start) < (uint32_t)cycles);
+}
+
+/*******************************************************************************
+ * Function Name: delay_init()
+ ********************************************************************************
+ * Summary:
+ *  Initializes the delay routines, enables the DWT cycle counter and computes
+ *  the cycles per us and per ms from the current core clock. Should be called
+ *  again if the core clock is changed.
+ *
+ * Parameters:
+ *  TIMx:    Not used by the DWT backend, the timer is left free.
+ *
+ * Return :
+ *  void
+ *
+ *******************************************************************************/
+void delay_init(TIM_TypeDef *TIMx)
+{
+    /* The core and it's cycle counter run from HCLK */
+    uint32_t core_clock = get_ahb_clock();
+
+    (void)TIMx;
+
+    cyccnt_init();
+
+    delay_cycles_per_usec = (core_clock + 500000U) / 1000000U;
+    delay_cycles_per_milsec = (core_clock + 500U) / 1000U;
+}
+
+/*******************************************************************************
+ * Function Name: delay_us()
+ ********************************************************************************
+ * Summary:
+ *   Function to produce micro-seconds delay. The cycle counter is read once on
+ *   entry, the time to compute the deadline is a part of the delay.
+ *
+ * Parameters:
+ *  us:      Number of micro-seconds to delay.
+ *
+ * Return :
+ *  void
+ *
+ *******************************************************************************/
+void delay_us(uint32_t us)
+{
+    uint32_t start = DWT->CYCCNT;
+
+    delay_dwt_spin(start, (uint64_t)us * delay_cycles_per_usec);
+}
+
+/*******************************************************************************
+ * Function Name: delay_ms()
+ ********************************************************************************
+ * Summary:
+ *   Function to produce milli-seconds delay.
+ *
+ * Parameters:
+ *   ms:      Number of milli-seconds to delay.
+ *
+ * Return :
+ *  void
+ *
+ *******************************************************************************/
+void delay_ms(uint32_t ms)
+{
+    uint32_t start = DWT->CYCCNT;
+
+    delay_dwt_spin(start, (uint64_t)ms * delay_cycles_per_milsec);
+}
+
+#else /* DELAY_BACKEND_TIM */
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+/* Timer of the delays, it's counter mask, and it's counter ticks per ms and
+ * fixed overhead of a delay in ticks, set by delay_init()
+ */
+static TIM_TypeDef *delay_tim = DELAY_TIM_INST;
+static uint32_t delay_tim_cnt_mask = 0xFFFFU;
+static uint32_t delay_tim_ticks_per_milsec = 0;
+static uint32_t delay_tim_calib_ticks = 0;
+
+/*******************************************************************************
+ * Function Name: delay_tim_spin()
+ ********************************************************************************
+ * Summary:
+ *  Spins till the specified number of counter ticks have passed since the start
+ *  value of the counter. The counter is read at least once per wrap, so an
+ *  interrupt during the delay should be shorter than the wrap of the counter.
+ *
+ * Parameters:
+ *  start:   Counter value at the start of the delay
+ *  ticks:   Length of the delay in counter ticks
+ *
+ * Return :
+ *  void
+ *
+ *******************************************************************************/
+static void delay_tim_spin(uint32_t start, uint64_t ticks)
+{
+    uint32_t last = start, now = 0, elapsed = 0;
+
+    while (true)
+    {
+        now = delay_tim->CNT;
+        elapsed = (now - last) & delay_tim_cnt_mask;
+
+        if (elapsed >= ticks)
+        {
+            break;
+        }
+
+        ticks -= elapsed;
+        last = now;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: delay_tim_ticks()
+ ********************************************************************************
+ * Summary:
+ *  Returns the ticks to spin for a delay, less the calibrated overhead.
+ *
+ *******************************************************************************/
+static __inline uint64_t delay_tim_ticks(uint64_t ticks)
+{
+    return (ticks > delay_tim_calib_ticks) ? (ticks - delay_tim_calib_ticks) : (0U);
+}
+
+/*******************************************************************************
+ * Function Name: delay_tim_calib_measure()
+ ********************************************************************************
+ * Summary:
+ *  Returns the length of delay_us() in HCLK cycles, measured with SysTick
+ *  running from HCLK with the max reload.
+ *
+ *******************************************************************************/
+static uint32_t delay_tim_calib_measure(uint32_t us)
+{
+    uint32_t start = SysTick->VAL;
+
+    delay_us(us);
+
+    return (start - SysTick->VAL) & SysTick_LOAD_RELOAD_Msk;
+}
+
+/*******************************************************************************
+ * Function Name: delay_tim_calibrate()
+ ********************************************************************************
+ * Summary:
+ *  Calibrates the delays against SysTick, which runs from HCLK. Two delays of
+ *  DELAY_TIM_CALIB_MILSEC and 5 times it are measured, their difference gives
+ *  the counter rate in HCLK cycles, which corrects a timer clock that is not
+ *  the one read from the RCC registers, and the rest of the short delay gives
+ *  the fixed overhead of a delay. The SysTick configs are saved and restored,
+ *  the current period of a running SysTick is restarted.
+ *
+ * Parameters:
+ *  hclk:    HCLK in Hz
+ *
+ * Return :
+ *  void
+ *
+ *******************************************************************************/
+static void delay_tim_calibrate(uint32_t hclk)
+{
+    uint32_t systick_ctrl = SysTick->CTRL;
+    uint32_t systick_load = SysTick->LOAD;
+    uint32_t primask = __get_PRIMASK();
+    uint32_t short_cycles = 0, long_cycles = 0, diff_cycles = 0, overhead_cycles = 0;
+    uint64_t ticks_per_milsec = 0;
+
+    __disable_irq();
+
+    SysTick->CTRL = 0;
+    SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+
+    delay_tim_calib_ticks = 0;
+
+    /* The first call also loads the code into the flash cache */
+    (void)delay_tim_calib_measure(DELAY_TIM_CALIB_MILSEC * 1000U);
+    short_cycles = delay_tim_calib_measure(DELAY_TIM_CALIB_MILSEC * 1000U);
+    long_cycles = delay_tim_calib_measure(5U * DELAY_TIM_CALIB_MILSEC * 1000U);
+
+    SysTick->CTRL = 0;
+    SysTick->LOAD = systick_load;
+    SysTick->VAL = 0;
+    SysTick->CTRL = systick_ctrl;
+
+    if (long_cycles > short_cycles)
+    {
+        /* The long delay spun 4 ms more counter ticks, in diff_cycles */
+        diff_cycles = long_cycles - short_cycles;
+        ticks_per_milsec = (((uint64_t)hclk * 4U * delay_tim_ticks_per_milsec) +
+                            (500U * (uint64_t)diff_cycles)) / (1000U * (uint64_t)diff_cycles);
+
+        if ((0U != ticks_per_milsec) && (ticks_per_milsec <= 0xFFFFFFFFU))
+        {
+            delay_tim_ticks_per_milsec = (uint32_t)ticks_per_milsec;
+        }
+
+        /* Overhead is the short delay less it's length at the measured rate */
+        if ((short_cycles * 4U) > diff_cycles)
+        {
+            overhead_cycles = short_cycles - (diff_cycles / 4U);
+            delay_tim_calib_ticks = (uint32_t)(((uint64_t)overhead_cycles *
+                                                delay_tim_ticks_per_milsec) / (hclk / 1000U));
+        }
+    }
+
+    __set_PRIMASK(primask);
+}
 
 /*******************************************************************************
  * Function Name: delay_init()
  ********************************************************************************
  * Summary:
- *  Initializes the timer instance for the delay routines.
+ *  Initializes the timer instance for the delay routines. The timer clock is
+ *  read from the RCC registers, including the x2 of the timers when the APB
+ *  prescaler is not 1, and the prescaler is computed for the highest counter
+ *  clock not above DELAY_TIM_TICK_HZ_MAX. The counter runs free over it's full
+ *  range, then the delays are calibrated against SysTick. Should be called
+ *  again if the clocks are changed.
  *
  * Parameters:
  *  TIMx:    Timer instance.
@@ -24,41 +289,51 @@
  *******************************************************************************/
 void delay_init(TIM_TypeDef *TIMx)
 {
-    /*
-     * Configs for the TIMx to be enabled for delay function, this function
-     * assumes that the system clock is at 100 MHz.
-     */
+    uint32_t tim_clock = get_timer_clock(TIMx);
+    uint32_t prescaler = (tim_clock + DELAY_TIM_TICK_HZ_MAX - 1U) / DELAY_TIM_TICK_HZ_MAX;
+
     general_timer_configs_t timx_configs = {
         .count_direction = DELAY_TIM_INST_DIRECTION,
         .auto_reload_preload_enable = 0,
         .repetition_counter = 0,
-        /*
-         * We want TIMx to run at 100 MHz, system clock will be at 100 MHz(PLL),
-         * hence the no prescaler.
-         */
         .prescaler = 0,
         .clock_division = 0,
-        /*
-         * We want the timer to count till ticks corresponding to 1us, at 100 MHz
-         * frequency of TIMx, it would mean:
-         * 1 sec   -->   100 x 1e6 counter ticks
-         * 1 usec  -->   100 ticks
-         */
-        .period = DELAY_TIM_INST_PERIOD - 1,
+        .period = 0xFFFFU,
     };
 
+    /* The prescaler register divides by 1 to 65536 */
+    prescaler = (0U == prescaler) ? (1U) : (prescaler);
+    prescaler = (prescaler > 0x10000U) ? (0x10000U) : (prescaler);
+
+    /* TIM2 and TIM5 have a 32-bit counter */
+    delay_tim = TIMx;
+    delay_tim_cnt_mask = ((TIM2 == TIMx) || (TIM5 == TIMx)) ? (0xFFFFFFFFU) : (0xFFFFU);
+    delay_tim_ticks_per_milsec = ((tim_clock / prescaler) + 500U) / 1000U;
+    delay_tim_ticks_per_milsec = (0U == delay_tim_ticks_per_milsec) ? (1U) : (delay_tim_ticks_per_milsec);
+
+    timx_configs.prescaler = (uint16_t)(prescaler - 1U);
+    timx_configs.period = delay_tim_cnt_mask;
+
     /* Config TIMx for delay operations */
     general_timer_config(TIMx, &timx_configs);
+    TIMx->CR1 &= ~TIM_CR1_DIR_Msk;
+
+    /* Load the prescaler now, the update event also sets UIF which is cleared */
+    TIMx->EGR = TIM_EGR_UG_Msk;
+    TIMx->SR = (uint32_t)(~TIM_SR_UIF_Msk);
 
     /* Start the TIMx with previously configured settings */
     timer_init(TIMx);
+
+    delay_tim_calibrate(get_ahb_clock());
 }
 
 /*******************************************************************************
  * Function Name: delay_us()
  ********************************************************************************
  * Summary:
- *   Function to produce micro-seconds delay.
+ *   Function to produce micro-seconds delay. The counter is read once on entry,
+ *   the time to compute the deadline is a part of the delay.
  *
  * Parameters:
  *  us:      Number of micro-seconds to delay.
@@ -69,16 +344,10 @@ void delay_init(TIM_TypeDef *TIMx)
  *******************************************************************************/
 void delay_us(uint32_t us)
 {
-    uint32_t i;
+    uint32_t start = delay_tim->CNT;
 
-    for (i = 0; i < us; i++)
-    {
-        /* Wait for UIF to be set. This will generate 1 ms delay */
-        while ((DELAY_TIM_INST->SR & TIM_SR_UIF) == 0);
-
-        /* Reset UIF */
-        DELAY_TIM_INST->SR &= ~TIM_SR_UIF;
-    }
+    delay_tim_spin(start, delay_tim_ticks((((uint64_t)us * delay_tim_ticks_per_milsec) + 500U) /
+                                          1000U));
 }
 
 /*******************************************************************************
@@ -86,9 +355,6 @@ void delay_us(uint32_t us)
  ********************************************************************************
  * Summary:
  *   Function to produce milli-seconds delay.
- * 
- *   NOTE: The delay produced by this function has some constant error of approx
- * 	 4%, more analysis is required for improving this accuracy. "TO DO".
  *
  * Parameters:
  *   ms:      Number of milli-seconds to delay.
@@ -99,13 +365,113 @@ void delay_us(uint32_t us)
  *******************************************************************************/
 void delay_ms(uint32_t ms)
 {
-    uint32_t i;
+    uint32_t start = delay_tim->CNT;
 
-    ms *= 1000;
+    delay_tim_spin(start, delay_tim_ticks((uint64_t)ms * delay_tim_ticks_per_milsec));
+}
+
+#endif /* DELAY_BACKEND */
 
-    for (i = 0; i < ms; i++)
+/*******************************************************************************
+ * Function Name: delay_sleep_until()
+ ********************************************************************************
+ * Summary:
+ *  Sleeps with WFI till DELAY_SLEEP_WAKE_EARLY_US before the end time, woken
+ *  up by the timebase wakeup compare, then spins till the end time. Other
+ *  interrupts also wake up the core, it goes back to sleep till the wakeup
+ *  time.
+ *
+ * Parameters:
+ *  end_us:  End of the delay, in the get_time_us() timebase
+ *
+ * Return :
+ *  void
+ *
+ *******************************************************************************/
+static void delay_sleep_until(uint64_t end_us)
+{
+    uint64_t wake_us = end_us - DELAY_SLEEP_WAKE_EARLY_US;
+    uint32_t primask = __get_PRIMASK();
+
+    timebase_wakeup_set(wake_us);
+
+    /* The time is checked with IRQs masked, so the wakeup interrupt can not
+     * fire between the check and WFI, it stays pending and WFI returns.
+     */
+    __disable_irq();
+
+    while (get_time_us() < wake_us)
     {
-        DELAY_TIM_INST->CNT = DELAY_TIM_INST_MILI_CALIB_CNT_VAL;
-        delay_us(1);
+        __WFI();
+        __enable_irq();
+        __disable_irq();
     }
+
+    __set_PRIMASK(primask);
+
+    while (get_time_us() < end_us);
 }
+
+/*******************************************************************************
+ * Function Name: delay_us_sleep()
+ ********************************************************************************
+ * Summary:
+ *   Function to produce micro-seconds delay with the core sleeping, accurate to
+ *   the 1 us tick of the timebase. Delays shorter than DELAY_SLEEP_MIN_US, or
+ *   all delays if the timebase is not started with timebase_init(), are spun
+ *   with delay_us().
+ *
+ *   NOTE: The wakeup needs the timebase interrupt, with IRQs masked by PRIMASK
+ *   the core still wakes up but the delay ends on the next check of the time
+ *   after the wakeup time.
+ *
+ * Parameters:
+ *  us:      Number of micro-seconds to delay.
+ *
+ * Return :
+ *  void
+ *
+ *******************************************************************************/
+void delay_us_sleep(uint32_t us)
+{
+    uint64_t start_us = 0;
+
+    if ((us < DELAY_SLEEP_MIN_US) || (!timebase_is_running()))
+    {
+        delay_us(us);
+        return;
+    }
+
+    start_us = get_time_us();
+    delay_sleep_until(start_us + us);
+}
+
+/*******************************************************************************
+ * Function Name: delay_ms_sleep()
+ ********************************************************************************
+ * Summary:
+ *   Function to produce milli-seconds delay with the core sleeping, see
+ *   delay_us_sleep().
+ *
+ * Parameters:
+ *   ms:      Number of milli-seconds to delay.
+ *
+ * Return :
+ *  void
+ *
+ *******************************************************************************/
+void delay_ms_sleep(uint32_t ms)
+{
+    uint64_t start_us = 0;
+
+    if (!timebase_is_running())
+    {
+        delay_ms(ms);
+        return;
+    }
+
+    start_us = get_time_us();
+    delay_sleep_until(start_us + ((uint64_t)ms * 1000U));
+}
+
+/* End of File */
@@ -22,17 +22,51 @@
 /*******************************************************************************
  * Macros
  *******************************************************************************/
-/* TIMx instance reserved for the delay related functions */
+/* Delay backends, selected at build time with DELAY_BACKEND
+ *  - DWT: the DWT cycle counter is read once and the CPU spins till the
+ *         deadline computed from the core clock, accurate to a few cycles and
+ *         no timer is used.
+ *  - TIM: the DELAY_TIM_INST counter runs free at a clock computed from the
+ *         RCC registers and the CPU spins till the deadline in counter ticks,
+ *         the rate and the fixed overhead are calibrated against SysTick by
+ *         delay_init().
+ */
+#define DELAY_BACKEND_DWT                       (0U)
+#define DELAY_BACKEND_TIM                       (1U)
+
+#ifndef DELAY_BACKEND
+#define DELAY_BACKEND                           (DELAY_BACKEND_DWT)
+#endif
+
+/* TIMx instance reserved for the delay related functions, TIM backend only */
 #define DELAY_TIM_INST                          (TIM2)
-/* Delay timer's count Direction */
-#define DELAY_TIM_INST_DIRECTION                (1)
-/* Delay Timer period */
-#define DELAY_TIM_INST_PERIOD                   (100)
-/* Timer period calib value to correct the generated millisecond delay, this
- * value was experimentally determined and, requires some more analysis, for
- * higher accuracy.
+/* Delay timer's count Direction, up counting */
+#define DELAY_TIM_INST_DIRECTION                (0)
+/* Max counter clock of the delay timer, the prescaler is computed for the
+ * highest clock not above it. A 16-bit counter at 10 MHz wraps in 6.5 ms, an
+ * interrupt during a delay should be shorter than the wrap.
+ */
+#ifndef DELAY_TIM_TICK_HZ_MAX
+#define DELAY_TIM_TICK_HZ_MAX                   (10000000U)
+#endif
+/* Length of the short calibration delay, the long one is 5 times it. The long
+ * delay in HCLK cycles should fit the 24-bit SysTick, ex: upto 99 ms at 168 MHz.
  */
-#define DELAY_TIM_INST_MILI_CALIB_CNT_VAL       (60)
+#define DELAY_TIM_CALIB_MILSEC                  (1U)
+
+/* Sleep delays: delays shorter than this are spun with delay_us(), the wake
+ * up from WFI and it's ISR cost more than spinning a short delay.
+ */
+#ifndef DELAY_SLEEP_MIN_US
+#define DELAY_SLEEP_MIN_US                      (50U)
+#endif
+
+/* Sleep delays: the core is woken up this early and spins the rest of the
+ * delay, covers the wakeup latency so the delay does not end late.
+ */
+#ifndef DELAY_SLEEP_WAKE_EARLY_US
+#define DELAY_SLEEP_WAKE_EARLY_US               (2U)
+#endif
 
 /*******************************************************************************
  * Function Prototypes
@@ -40,5 +74,7 @@
 void delay_init(TIM_TypeDef *TIMx);
 void delay_us(uint32_t us);
 void delay_ms(uint32_t ms);
+void delay_us_sleep(uint32_t us);
+void delay_ms_sleep(uint32_t ms);
 
 #endif /* End of File */
@@ -0,0 +1,240 @@
+/*******************************************************************************
+ * File Name: dma_aj_stm32f4.c
+ *
+ * Description:
+ * The file contains function definition(s) for DMA peripheral of STM32F407.
+ *
+ * Related Document: See README.md
+ *
+ *******************************************************************************/
+#include "dma_aj_stm32f4.h"
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+/* Bit offset of each stream's flags inside DMA_xISR/DMA_xIFCR, streams 0..3
+ * use the low registers and 4..7 the high registers with the same offsets.
+ */
+static const uint8_t dma_flag_offset[4] = {0U, 6U, 16U, 22U};
+
+/* Stream IRQ numbers, these are not contiguous in the vector table */
+static const IRQn_Type dma_stream_irqn[2][8] = {
+    {DMA1_Stream0_IRQn, DMA1_Stream1_IRQn, DMA1_Stream2_IRQn, DMA1_Stream3_IRQn,
+     DMA1_Stream4_IRQn, DMA1_Stream5_IRQn, DMA1_Stream6_IRQn, DMA1_Stream7_IRQn},
+    {DMA2_Stream0_IRQn, DMA2_Stream1_IRQn, DMA2_Stream2_IRQn, DMA2_Stream3_IRQn,
+     DMA2_Stream4_IRQn, DMA2_Stream5_IRQn, DMA2_Stream6_IRQn, DMA2_Stream7_IRQn},
+};
+
+/*******************************************************************************
+ * Function Name: dma_stream_locate()
+ ********************************************************************************
+ * Summary:
+ *   Finds the DMA controller number and the stream number of a stream, using
+ *   pointer arithmatic on the memory mapped addresses of the stream registers,
+ *   see file "stm32f407xx.h" for these base addresses.
+ *
+ * Parameters:
+ *   stream:     DMA stream instance
+ *   dma_num:    Set to 0 for DMA1 and 1 for DMA2
+ *   stream_num: Set to the stream number [0, 7]
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void dma_stream_locate(DMA_Stream_TypeDef *stream, uint32_t *dma_num,
+                              uint32_t *stream_num)
+{
+    if (stream >= DMA2_Stream0)
+    {
+        *dma_num = 1U;
+        *stream_num = (uint32_t)(stream - DMA2_Stream0);
+    }
+    else
+    {
+        *dma_num = 0U;
+        *stream_num = (uint32_t)(stream - DMA1_Stream0);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: dma_stream_config()
+ ********************************************************************************
+ * Summary:
+ *   Configures a DMA stream, the stream is disabled first and left disabled,
+ *   use dma_stream_start() to start a transfer.
+ *
+ *   NOTE: The FIFO is not used, the stream works in direct mode.
+ *
+ * Parameters:
+ *   stream:     DMA stream instance
+ *   dma_cfg:    Pointer to DMA stream configs
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+void dma_stream_config(DMA_Stream_TypeDef *stream, dma_stream_config_st_t *dma_cfg)
+{
+    uint32_t dma_num = 0, stream_num = 0;
+
+    dma_stream_locate(stream, &dma_num, &stream_num);
+
+    /* Enable the DMA controller clock */
+    RCC->AHB1ENR |= (uint32_t)(1U << (RCC_AHB1ENR_DMA1EN_Pos + dma_num));
+
+    /* Stream must be disabled before it's registers can be programmed */
+    dma_stream_stop(stream);
+
+    stream->CR = (uint32_t)(((uint32_t)dma_cfg->channel << DMA_SxCR_CHSEL_Pos) |
+                            ((uint32_t)dma_cfg->priority << DMA_SxCR_PL_Pos) |
+                            ((uint32_t)dma_cfg->mem_size << DMA_SxCR_MSIZE_Pos) |
+                            ((uint32_t)dma_cfg->periph_size << DMA_SxCR_PSIZE_Pos) |
+                            ((uint32_t)dma_cfg->mem_inc << DMA_SxCR_MINC_Pos) |
+                            ((uint32_t)dma_cfg->periph_inc << DMA_SxCR_PINC_Pos) |
+                            ((uint32_t)dma_cfg->circular << DMA_SxCR_CIRC_Pos) |
+                            ((uint32_t)dma_cfg->direction << DMA_SxCR_DIR_Pos) |
+                            ((uint32_t)dma_cfg->tc_intr_en << DMA_SxCR_TCIE_Pos) |
+                            ((uint32_t)dma_cfg->ht_intr_en << DMA_SxCR_HTIE_Pos) |
+                            ((uint32_t)dma_cfg->te_intr_en << DMA_SxCR_TEIE_Pos));
+
+    /* Direct mode, FIFO disabled */
+    stream->FCR &= (uint32_t)(~(DMA_SxFCR_DMDIS_Msk));
+
+    dma_stream_clear_flags(stream, DMA_FLAG_ALL);
+}
+
+/*******************************************************************************
+ * Function Name: dma_stream_start()
+ ********************************************************************************
+ * Summary:
+ *   Programs the addresses and data count of a configured stream and enables
+ *   it. Safe to be called from ISR, the stream is expected to be disabled.
+ *
+ * Parameters:
+ *   stream:         DMA stream instance
+ *   periph_addr:    Peripheral data register address
+ *   mem_addr:       Memory buffer address
+ *   count:          Number of data items to transfer
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+void dma_stream_start(DMA_Stream_TypeDef *stream, uint32_t periph_addr,
+                      uint32_t mem_addr, uint16_t count)
+{
+    stream->PAR = periph_addr;
+    stream->M0AR = mem_addr;
+    stream->NDTR = count;
+
+    /* Stale flags of the previous transfer would block the enable */
+    dma_stream_clear_flags(stream, DMA_FLAG_ALL);
+
+    stream->CR |= (1U << DMA_SxCR_EN_Pos);
+}
+
+/*******************************************************************************
+ * Function Name: dma_stream_stop()
+ ********************************************************************************
+ * Summary:
+ *   Disables the stream and waits till the ongoing data item is finished.
+ *
+ * Parameters:
+ *   stream:     DMA stream instance
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+void dma_stream_stop(DMA_Stream_TypeDef *stream)
+{
+    stream->CR &= (uint32_t)(~(DMA_SxCR_EN_Msk));
+
+    /* EN reads back as 1 till the current data item is transferred */
+    while (stream->CR & DMA_SxCR_EN_Msk)
+        ;
+}
+
+/*******************************************************************************
+ * Function Name: dma_stream_get_flags()
+ ********************************************************************************
+ * Summary:
+ *   Reads the event flags of a stream, normalized to DMA_FLAG_xxx positions.
+ *
+ * Parameters:
+ *   stream:     DMA stream instance
+ *
+ * Return :
+ *   uint32_t:   OR of DMA_FLAG_xxx values set for the stream
+ *
+ *******************************************************************************/
+uint32_t dma_stream_get_flags(DMA_Stream_TypeDef *stream)
+{
+    uint32_t dma_num = 0, stream_num = 0;
+    DMA_TypeDef *dma = DMA1;
+    uint32_t isr = 0;
+
+    dma_stream_locate(stream, &dma_num, &stream_num);
+    dma = (0U == dma_num) ? (DMA1) : (DMA2);
+    isr = (stream_num < 4U) ? (dma->LISR) : (dma->HISR);
+
+    return (uint32_t)((isr >> dma_flag_offset[stream_num % 4U]) & DMA_FLAG_ALL);
+}
+
+/*******************************************************************************
+ * Function Name: dma_stream_clear_flags()
+ ********************************************************************************
+ * Summary:
+ *   Clears the specified event flags of a stream.
+ *
+ * Parameters:
+ *   stream:     DMA stream instance
+ *   flags:      OR of DMA_FLAG_xxx values to be cleared
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+void dma_stream_clear_flags(DMA_Stream_TypeDef *stream, uint32_t flags)
+{
+    uint32_t dma_num = 0, stream_num = 0;
+    DMA_TypeDef *dma = DMA1;
+
+    dma_stream_locate(stream, &dma_num, &stream_num);
+    dma = (0U == dma_num) ? (DMA1) : (DMA2);
+
+    /* Flag clear registers are write 1 to clear, no read-modify-write needed */
+    if (stream_num < 4U)
+    {
+        dma->LIFCR = (uint32_t)((flags & DMA_FLAG_ALL) << dma_flag_offset[stream_num]);
+    }
+    else
+    {
+        dma->HIFCR = (uint32_t)((flags & DMA_FLAG_ALL) << dma_flag_offset[stream_num - 4U]);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: dma_stream_get_irqn()
+ ********************************************************************************
+ * Summary:
+ *   Returns the NVIC interrupt number of a stream.
+ *
+ * Parameters:
+ *   stream:     DMA stream instance
+ *
+ * Return :
+ *   IRQn_Type:  Interrupt number of the stream
+ *
+ *******************************************************************************/
+IRQn_Type dma_stream_get_irqn(DMA_Stream_TypeDef *stream)
+{
+    uint32_t dma_num = 0, stream_num = 0;
+
+    dma_stream_locate(stream, &dma_num, &stream_num);
+
+    return dma_stream_irqn[dma_num][stream_num];
+}
+
+/* End of File */
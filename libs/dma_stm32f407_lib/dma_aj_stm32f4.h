@@ -0,0 +1,101 @@
+/*******************************************************************************
+* File Name: dma_aj_stm32f4.h
+*
+* Description:
+* The file contains function declaration(s) for DMA peripheral of STM32f407.
+*
+* Related Document: See README.md
+*
+*******************************************************************************/
+#ifndef DMA_AJ_STM32F4
+#define DMA_AJ_STM32F4
+
+/*******************************************************************************
+* Header Files
+*******************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32f4xx.h"
+
+#ifdef  __STM32F407xx_H
+#include "stm32f407xx.h"
+#endif  /* __STM32F407xx_H */
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* Stream event flags, normalized to the bit positions of stream 0 in the
+ * DMA_LISR/DMA_LIFCR registers, the stream specific offset is handled
+ * internally.
+ */
+#define DMA_FLAG_FEIF                       (1U << 0U)
+#define DMA_FLAG_DMEIF                      (1U << 2U)
+#define DMA_FLAG_TEIF                       (1U << 3U)
+#define DMA_FLAG_HTIF                       (1U << 4U)
+#define DMA_FLAG_TCIF                       (1U << 5U)
+#define DMA_FLAG_ALL                        (DMA_FLAG_FEIF | DMA_FLAG_DMEIF | \
+                                             DMA_FLAG_TEIF | DMA_FLAG_HTIF | \
+                                             DMA_FLAG_TCIF)
+
+/* Data item size, for peripheral and memory side */
+#define DMA_DATA_SIZE_BYTE                  (0U)
+#define DMA_DATA_SIZE_HALF_WORD             (1U)
+#define DMA_DATA_SIZE_WORD                  (2U)
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+typedef enum dma_dir_e
+{
+    DMA_DIR_PERIPH_TO_MEM,
+    DMA_DIR_MEM_TO_PERIPH,
+    DMA_DIR_MEM_TO_MEM,
+} dma_dir_e_t;
+
+typedef enum dma_priority_e
+{
+    DMA_PRIORITY_LOW,
+    DMA_PRIORITY_MEDIUM,
+    DMA_PRIORITY_HIGH,
+    DMA_PRIORITY_VERY_HIGH,
+} dma_priority_e_t;
+
+typedef struct dma_stream_config_st
+{
+    dma_dir_e_t direction;
+    dma_priority_e_t priority;
+    uint8_t channel;
+    uint8_t periph_size;
+    uint8_t mem_size;
+    bool periph_inc;
+    bool mem_inc;
+    bool circular;
+    bool tc_intr_en;
+    bool ht_intr_en;
+    bool te_intr_en;
+} dma_stream_config_st_t;
+
+/*******************************************************************************
+ * Function Prototypes
+ *******************************************************************************/
+void dma_stream_config(DMA_Stream_TypeDef *stream, dma_stream_config_st_t *dma_cfg);
+void dma_stream_start(DMA_Stream_TypeDef *stream, uint32_t periph_addr,
+                      uint32_t mem_addr, uint16_t count);
+void dma_stream_stop(DMA_Stream_TypeDef *stream);
+uint32_t dma_stream_get_flags(DMA_Stream_TypeDef *stream);
+void dma_stream_clear_flags(DMA_Stream_TypeDef *stream, uint32_t flags);
+IRQn_Type dma_stream_get_irqn(DMA_Stream_TypeDef *stream);
+
+/*******************************************************************************
+ * Function Name: dma_stream_get_count()
+ ********************************************************************************
+ * Summary:
+ *   Returns the number of data items still to be transferred by the stream.
+ *
+ *******************************************************************************/
+static __inline uint16_t dma_stream_get_count(DMA_Stream_TypeDef *stream)
+{
+    return (uint16_t)stream->NDTR;
+}
+
+#endif /* DMA_AJ_STM32F4 */
@@ -0,0 +1,441 @@
+/*******************************************************************************
+* File Name: log_aj_stm32f4.c
+*
+* Description:
+* The file contains definitions for the log router of the STM32f407 libs.
+*
+* A record is formatted once, on the stack of the caller, only if at least one
+* sink passes it's level, and is then written to each sink which passes it.
+* The record is formatted with vsnprintf_lite() of retarget_stdio, reentrant
+* and without the libc printf, see printf_lite_aj_stm32f4.c for the supported
+* conversions. All the sinks are non-blocking except the printf sink in the
+* BLOCKING mode of retarget_stdio, so the logging can be used from thread and
+* ISRs.
+*
+* Related Document: See README.md
+*
+*******************************************************************************/
+#include <string.h>
+#include "log_aj_stm32f4.h"
+#include "printf_lite_aj_stm32f4.h"
+
+/*******************************************************************************
+* Global Variables
+*******************************************************************************/
+/* Level filter of each sink, the RAM and UART sinks are off till initialized */
+static uint8_t log_sink_level[LOG_SINK_NUM] = {
+    LOG_MIN_LEVEL,
+    LOG_LEVEL_NONE,
+    LOG_LEVEL_NONE,
+};
+
+/* Lowest level passed by any sink, records below it are not formatted */
+static uint8_t log_level_active = LOG_MIN_LEVEL;
+
+/* Will be initialized by the log_uart_sink_init() */
+static usart_config_st_t *log_usartcfg_ptr = NULL;
+
+/* RAM crash ring, the oldest records are overwritten */
+#if (0U != LOG_RAM_IN_BKPSRAM)
+static log_ram_st_t *const log_ram = (log_ram_st_t *)BKPSRAM_BASE;
+#else
+#if defined(__CC_ARM)
+static log_ram_st_t log_ram_noinit __attribute__((section(".noinit"), zero_init));
+#else
+static log_ram_st_t log_ram_noinit __attribute__((section(".noinit")));
+#endif
+static log_ram_st_t *const log_ram = &log_ram_noinit;
+#endif
+
+static log_stats_st_t log_stats;
+
+static const char log_level_tag[LOG_LEVEL_NONE] = {'-', 'D', 'I', 'W', 'E'};
+
+/*******************************************************************************
+* Function Name: log_ram_write()
+********************************************************************************
+* Summary:
+*   Writes a record into the RAM crash ring, overwriting the oldest data. The
+*   head is moved after the data is written, so a reset in between loses only
+*   the record being written. Must be called with IRQs masked.
+*
+* Parameters:
+*   buff:           Record
+*   size:           Size of the record, upto LOG_RECORD_MAX_SIZE
+*
+* Return :
+*   void
+*
+*******************************************************************************/
+static void log_ram_write(const char *buff, uint32_t size)
+{
+    uint32_t head = log_ram->head;
+    uint32_t offset = head & (LOG_RAM_RING_SIZE - 1U);
+    uint32_t first = LOG_RAM_RING_SIZE - offset;
+
+    if (first >= size)
+    {
+        memcpy(&log_ram->ring[offset], buff, size);
+    }
+    else
+    {
+        memcpy(&log_ram->ring[offset], buff, first);
+        memcpy(&log_ram->ring[0], &buff[first], size - first);
+    }
+
+    log_ram->head = head + size;
+}
+
+/*******************************************************************************
+* Function Name: log_vwrite()
+********************************************************************************
+* Summary:
+*   Formats a record and routes it to the sinks which pass it's level. The
+*   record is prefixed with it's timestamp in seconds, to the us, and it's level
+*   tag, and ends with "\r\n". Called by the
+*   LOG_x() macros, see log_write().
+*
+* Parameters:
+*   level:          Level of the record, LOG_LEVEL_DEBUG to LOG_LEVEL_ERROR
+*   fmt:            Format string
+*   args:           Arguments for the format
+*
+* Return :
+*   void
+*
+*******************************************************************************/
+void log_vwrite(uint32_t level, const char *fmt, va_list args)
+{
+    char record[LOG_RECORD_MAX_SIZE];
+    int32_t len = 0, prefix_len = 0;
+    uint32_t primask = 0;
+#if (0U != LOG_TIMESTAMP)
+    uint64_t usec = 0;
+    uint32_t sec = 0;
+#endif
+
+    if ((level < log_level_active) || (level >= LOG_LEVEL_NONE))
+    {
+        return;
+    }
+
+#if (0U != LOG_TIMESTAMP)
+    /* Taken first, the conversion and formatting are not part of the time */
+    usec = timestamp_to_usec(timestamp_get());
+    sec = (uint32_t)(usec / 1000000U);
+
+    prefix_len = snprintf_lite(record, LOG_RECORD_MAX_SIZE, "%5u.%06u %c ", sec,
+                               (uint32_t)(usec - ((uint64_t)sec * 1000000U)),
+                               log_level_tag[level]);
+#else
+    record[0] = log_level_tag[level];
+    record[1] = ' ';
+    prefix_len = 2;
+#endif
+
+    /* Room is kept for the "\r\n" */
+    len = vsnprintf_lite(&record[prefix_len], LOG_RECORD_MAX_SIZE - 2U - (uint32_t)prefix_len,
+                         fmt, args);
+    if (len < 0)
+    {
+        return;
+    }
+
+    len += prefix_len;
+    if (len > (int32_t)(LOG_RECORD_MAX_SIZE - 3U))
+    {
+        len = (int32_t)(LOG_RECORD_MAX_SIZE - 3U);
+    }
+
+    record[len++] = '\r';
+    record[len++] = '\n';
+
+    /* The RAM ring and the UART Tx ring have a single producer, serialize the
+     * thread and ISR callers.
+     */
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    log_stats.record_cnt++;
+
+    if (level >= log_sink_level[LOG_SINK_RAM])
+    {
+        log_ram_write(record, (uint32_t)len);
+    }
+
+    if ((level >= log_sink_level[LOG_SINK_UART]) &&
+        (USART_STATUS_SUCCESS != uart_write_async(log_usartcfg_ptr, (uint8_t *)record,
+                                                  (uint16_t)len)))
+    {
+        log_stats.uart_drop_cnt++;
+    }
+
+    __set_PRIMASK(primask);
+
+    /* Not in the masked section, the BLOCKING mode of the printf sink waits */
+    if (level >= log_sink_level[LOG_SINK_PRINTF])
+    {
+        (void)printf_retarget_write((uint8_t *)record, (uint16_t)len);
+    }
+}
+
+/*******************************************************************************
+* Function Name: log_write()
+********************************************************************************
+* Summary:
+*   Formats a record and routes it to the sinks which pass it's level. Use the
+*   LOG_x() macros, which remove the records below LOG_MIN_LEVEL at compile
+*   time. Can be called from thread and ISRs.
+*
+* Parameters:
+*   level:          Level of the record, LOG_LEVEL_DEBUG to LOG_LEVEL_ERROR
+*   fmt:            Format string
+*   ...:            Arguments for the format
+*
+* Return :
+*   void
+*
+*******************************************************************************/
+void log_write(uint32_t level, const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    log_vwrite(level, fmt, args);
+    va_end(args);
+}
+
+/*******************************************************************************
+* Function Name: log_sink_set_level()
+********************************************************************************
+* Summary:
+*   Sets the level filter of a sink, records of lower level are not written to
+*   the sink. Records below LOG_MIN_LEVEL are never written, as they are
+*   removed at compile time.
+*
+* Parameters:
+*   sink:           Log sink
+*   level:          Lowest level written to the sink, LOG_LEVEL_NONE for none
+*
+* Return :
+*   result_funct_e_t:   Function completion status.
+*
+*******************************************************************************/
+result_funct log_sink_set_level(log_sink_e_t sink, uint32_t level)
+{
+    uint32_t i = 0;
+    uint8_t min_level = LOG_LEVEL_NONE;
+
+    if ((sink >= LOG_SINK_NUM) || (level < LOG_LEVEL_DEBUG) || (level > LOG_LEVEL_NONE))
+    {
+        return RESULT_FUNCT_STATUS_BAD_PARAM;
+    }
+
+    if ((LOG_SINK_UART == sink) && (NULL == log_usartcfg_ptr))
+    {
+        return RESULT_FUNCT_STATUS_FAIL;
+    }
+
+    log_sink_level[sink] = (uint8_t)level;
+
+    for (i = 0; i < LOG_SINK_NUM; i++)
+    {
+        if (log_sink_level[i] < min_level)
+        {
+            min_level = log_sink_level[i];
+        }
+    }
+
+    log_level_active = min_level;
+
+    return RESULT_FUNCT_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: log_uart_sink_init()
+********************************************************************************
+* Summary:
+*   Initializes the secondary UART sink, the records are queued into the Tx ring
+*   of the UART and sent in background by the USART TXE interrupt, a record is
+*   dropped and counted if the ring is full. The UART should be configured
+*   already with usart_config() and usart_init(), and must not be the printf
+*   UART.
+*
+* Parameters:
+*   usart_cfg:      Pointer to USART configs
+*   tx_ring:        Storage for the Tx ring
+*   tx_ring_size:   Size of the storage, a power of two
+*   level:          Lowest level written to the sink
+*
+* Return :
+*   result_funct_e_t:   Function completion status.
+*
+*******************************************************************************/
+result_funct log_uart_sink_init(usart_config_st_t *usart_cfg, uint8_t *tx_ring,
+                                uint16_t tx_ring_size, uint32_t level)
+{
+    result_funct res = RESULT_FUNCT_STATUS_SUCCESS;
+
+    res = uart_write_async_init(usart_cfg, tx_ring, tx_ring_size);
+    if (RESULT_FUNCT_STATUS_SUCCESS != res)
+    {
+        return res;
+    }
+
+    log_usartcfg_ptr = usart_cfg;
+
+    return log_sink_set_level(LOG_SINK_UART, level);
+}
+
+/*******************************************************************************
+* Function Name: log_ram_init()
+********************************************************************************
+* Summary:
+*   Initializes the RAM crash ring and enables it's sink. The ring survives
+*   the reset, a valid ring of the same build found on the boot is kept, so
+*   the records before a watchdog reset or hard fault can be printed with
+*   log_ram_dump(). The hot path of the sink is a copy into the ring, there is
+*   no UART traffic.
+*
+*   With LOG_RAM_IN_BKPSRAM, the backup SRAM clock and write access are enabled
+*   here. The ring also survives the power off if VBAT is powered and the backup
+*   regulator is enabled (PWR_CSR BRE), which is left to the application.
+*
+* Parameters:
+*   level:          Lowest level written to the ring
+*
+* Return :
+*   bool:           true if a ring from before the reset was found
+*
+*******************************************************************************/
+bool log_ram_init(uint32_t level)
+{
+    bool found = false;
+    uint32_t primask = 0;
+
+#if (0U != LOG_RAM_IN_BKPSRAM)
+    RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+    PWR->CR |= PWR_CR_DBP;
+    RCC->AHB1ENR |= RCC_AHB1ENR_BKPSRAMEN;
+
+    /* Delay after the RCC peripheral clock enabling */
+    (void)RCC->AHB1ENR;
+#endif
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    found = ((LOG_RAM_MAGIC == log_ram->magic) && (LOG_RAM_RING_SIZE == log_ram->size));
+    if (!found)
+    {
+        log_ram->size = LOG_RAM_RING_SIZE;
+        log_ram->head = 0;
+        log_ram->magic = LOG_RAM_MAGIC;
+    }
+
+    __set_PRIMASK(primask);
+
+    (void)log_sink_set_level(LOG_SINK_RAM, level);
+
+    return (found && (0U != log_ram->head));
+}
+
+/*******************************************************************************
+* Function Name: log_ram_dump()
+********************************************************************************
+* Summary:
+*   Writes the content of the RAM crash ring to the printf UART, oldest record
+*   first, and waits till it is sent. If the ring has wrapped, the partly
+*   overwritten oldest record is skipped.
+*
+* Parameters:
+*   void
+*
+* Return :
+*   void
+*
+*******************************************************************************/
+void log_ram_dump(void)
+{
+    uint8_t chunk[LOG_RECORD_MAX_SIZE];
+    uint32_t head = log_ram->head;
+    uint32_t idx = 0, len = 0;
+
+    if (LOG_RAM_MAGIC != log_ram->magic)
+    {
+        return;
+    }
+
+    if (head > LOG_RAM_RING_SIZE)
+    {
+        idx = head - LOG_RAM_RING_SIZE;
+
+        while ((idx < head) && ('\n' != log_ram->ring[idx & (LOG_RAM_RING_SIZE - 1U)]))
+        {
+            idx++;
+        }
+        idx++;
+    }
+
+    while (idx < head)
+    {
+        for (len = 0; (len < LOG_RECORD_MAX_SIZE) && (idx < head); len++, idx++)
+        {
+            chunk[len] = log_ram->ring[idx & (LOG_RAM_RING_SIZE - 1U)];
+        }
+
+        /* The ring is drained before each chunk, so no chunk is dropped in the
+         * DROP mode behind the earlier output.
+         */
+        printf_retarget_flush();
+        (void)printf_retarget_write(chunk, (uint16_t)len);
+    }
+
+    printf_retarget_flush();
+}
+
+/*******************************************************************************
+* Function Name: log_ram_clear()
+********************************************************************************
+* Summary:
+*   Clears the RAM crash ring.
+*
+* Parameters:
+*   void
+*
+* Return :
+*   void
+*
+*******************************************************************************/
+void log_ram_clear(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    log_ram->head = 0;
+    __set_PRIMASK(primask);
+}
+
+/*******************************************************************************
+* Function Name: log_get_stats()
+********************************************************************************
+* Summary:
+*   Returns the number of records routed and dropped.
+*
+* Parameters:
+*   stats:          Filled with the statistics
+*
+* Return :
+*   void
+*
+*******************************************************************************/
+void log_get_stats(log_stats_st_t *stats)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    *stats = log_stats;
+    __set_PRIMASK(primask);
+}
+
+/* End of File */
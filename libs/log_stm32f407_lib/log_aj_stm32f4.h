@@ -0,0 +1,150 @@
+/*******************************************************************************
+* File Name: log_aj_stm32f4.h
+*
+* Description:
+* The file contains declarations for the log router of the STM32f407 libs. A
+* log record is formatted once and routed to the sinks, the printf UART, a RAM
+* crash ring and a secondary UART, each sink has it's own level filter.
+*
+* Related Document: See README.md
+*
+*******************************************************************************/
+#ifndef LOG_AJ_STM32F4
+#define LOG_AJ_STM32F4
+
+/*******************************************************************************
+* Header Files
+*******************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+
+#include "stm32f4xx.h"
+
+#ifdef  __STM32F407xx_H
+#include "stm32f407xx.h"
+#endif  /* __STM32F407xx_H */
+
+#include "usart_aj_stm32f4.h"
+#include "retarget_stdio_aj_stm32f4.h"
+#include "utils_aj_stm32f4.h"
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* Log levels, in the increasing order of severity */
+#define LOG_LEVEL_DEBUG                     (1U)
+#define LOG_LEVEL_INFO                      (2U)
+#define LOG_LEVEL_WARN                      (3U)
+#define LOG_LEVEL_ERROR                     (4U)
+/* Sink level which passes no record */
+#define LOG_LEVEL_NONE                      (5U)
+
+/* Records below this level are removed at compile time, the LOG_x() call and
+ * it's arguments produce no code. Define it in the build options, ex: a debug
+ * build with LOG_MIN_LEVEL=1 and a production build with the default.
+ */
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL                       (LOG_LEVEL_INFO)
+#endif
+
+/* Max size of a formatted record, longer records are truncated */
+#ifndef LOG_RECORD_MAX_SIZE
+#define LOG_RECORD_MAX_SIZE                 (96U)
+#endif
+
+/* 1: each record is prefixed with the DWT timestamp, see timestamp_get() */
+#ifndef LOG_TIMESTAMP
+#define LOG_TIMESTAMP                       (1U)
+#endif
+
+/* Size of the RAM crash ring, a power of two, upto 2048 in the backup SRAM */
+#ifndef LOG_RAM_RING_SIZE
+#define LOG_RAM_RING_SIZE                   (1024U)
+#endif
+
+/* Storage of the RAM crash ring, which survives a reset
+ *  1: the 4 KB backup SRAM, also survives the power off with VBAT, see
+ *     log_ram_init()
+ *  0: the ".noinit" section of the RAM, must be an UNINIT region in the
+ *     scatter file, ex: "RW_NOINIT 0x2001F000 UNINIT 0x1000 { *(.noinit) }"
+ */
+#ifndef LOG_RAM_IN_BKPSRAM
+#define LOG_RAM_IN_BKPSRAM                  (1U)
+#endif
+
+#if ((0U != LOG_RAM_IN_BKPSRAM) && (LOG_RAM_RING_SIZE > 2048U))
+#error "LOG_RAM_RING_SIZE does not fit in the backup SRAM"
+#endif
+
+/* Marks a valid crash ring, "LOGR" */
+#define LOG_RAM_MAGIC                       (0x52474F4CU)
+
+/* Logging macros, the arguments are not evaluated when the level is removed */
+#if (LOG_LEVEL_DEBUG >= LOG_MIN_LEVEL)
+#define LOG_DBG(...)                        (log_write(LOG_LEVEL_DEBUG, __VA_ARGS__))
+#else
+#define LOG_DBG(...)                        ((void)0)
+#endif
+
+#if (LOG_LEVEL_INFO >= LOG_MIN_LEVEL)
+#define LOG_INF(...)                        (log_write(LOG_LEVEL_INFO, __VA_ARGS__))
+#else
+#define LOG_INF(...)                        ((void)0)
+#endif
+
+#if (LOG_LEVEL_WARN >= LOG_MIN_LEVEL)
+#define LOG_WRN(...)                        (log_write(LOG_LEVEL_WARN, __VA_ARGS__))
+#else
+#define LOG_WRN(...)                        ((void)0)
+#endif
+
+#if (LOG_LEVEL_ERROR >= LOG_MIN_LEVEL)
+#define LOG_ERR(...)                        (log_write(LOG_LEVEL_ERROR, __VA_ARGS__))
+#else
+#define LOG_ERR(...)                        ((void)0)
+#endif
+
+/*******************************************************************************
+* Global Variables
+*******************************************************************************/
+typedef enum log_sink_e
+{
+    LOG_SINK_PRINTF,        /* Re-targetted stdout, see retarget_stdio */
+    LOG_SINK_RAM,           /* RAM crash ring, see log_ram_init() */
+    LOG_SINK_UART,          /* Secondary UART, see log_uart_sink_init() */
+    LOG_SINK_NUM,
+} log_sink_e_t;
+
+/* RAM crash ring, kept over the reset */
+typedef struct log_ram_st
+{
+    uint32_t magic;
+    uint32_t size;          /* A ring of another build is not used */
+    uint32_t head;          /* Bytes written, wraps at 2^32 */
+    uint8_t ring[LOG_RAM_RING_SIZE];
+} log_ram_st_t;
+
+typedef struct log_stats_st
+{
+    uint32_t record_cnt;    /* Records routed to at least one sink */
+    uint32_t uart_drop_cnt; /* Records dropped by the secondary UART sink */
+} log_stats_st_t;
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+void log_write(uint32_t level, const char *fmt, ...);
+void log_vwrite(uint32_t level, const char *fmt, va_list args);
+
+result_funct log_sink_set_level(log_sink_e_t sink, uint32_t level);
+result_funct log_uart_sink_init(usart_config_st_t *usart_cfg, uint8_t *tx_ring,
+                                uint16_t tx_ring_size, uint32_t level);
+
+bool log_ram_init(uint32_t level);
+void log_ram_dump(void);
+void log_ram_clear(void);
+
+void log_get_stats(log_stats_st_t *stats);
+
+#endif /* LOG_AJ_STM32F4 */
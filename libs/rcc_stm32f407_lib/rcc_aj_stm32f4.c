@@ -48,6 +48,16 @@
 #include "rcc_aj_stm32f4.h"
 #include "bsp_aj_stm32f4.h"
 
+/*******************************************************************************
+ * Global Variables
+ ******************************************************************************/
+/* Right shift of the clock for each value of the HPRE field of RCC_CFGR */
+static const uint8_t ahb_prescaler_shift[16] = {0, 0, 0, 0, 0, 0, 0, 0,
+                                                1, 2, 3, 4, 6, 7, 8, 9};
+
+/* Right shift of the clock for each value of the PPRE1/PPRE2 fields of RCC_CFGR */
+static const uint8_t apb_prescaler_shift[8] = {0, 0, 0, 0, 1, 2, 3, 4};
+
 /*******************************************************************************
 * Function Name: MCO_Config
 ********************************************************************************
@@ -441,6 +451,103 @@ uint32_t get_systemcore_clock(void)
   return SystemCoreClock;
 }
 
+/*******************************************************************************
+* Function Name: get_ahb_clock
+********************************************************************************
+* Summary:
+*       Returns the AHB bus clock (HCLK) value from the pre-programmed RCC
+*       registers.
+*
+* Parameters:
+*   void
+*
+* Return :
+*  uint32_t:         AHB clock value.
+*
+*******************************************************************************/
+uint32_t get_ahb_clock(void)
+{
+    uint32_t hpre = (RCC->CFGR & RCC_CFGR_HPRE_Msk) >> RCC_CFGR_HPRE_Pos;
+
+    return (get_systemcore_clock() >> ahb_prescaler_shift[hpre]);
+}
+
+/*******************************************************************************
+* Function Name: get_apb1_clock
+********************************************************************************
+* Summary:
+*       Returns the APB1 bus clock (PCLK1) value from the pre-programmed RCC
+*       registers. USART2/3 and UART4/5 are clocked from PCLK1.
+*
+* Parameters:
+*   void
+*
+* Return :
+*  uint32_t:         APB1 clock value.
+*
+*******************************************************************************/
+uint32_t get_apb1_clock(void)
+{
+    uint32_t ppre1 = (RCC->CFGR & RCC_CFGR_PPRE1_Msk) >> RCC_CFGR_PPRE1_Pos;
+
+    return (get_ahb_clock() >> apb_prescaler_shift[ppre1]);
+}
+
+/*******************************************************************************
+* Function Name: get_apb2_clock
+********************************************************************************
+* Summary:
+*       Returns the APB2 bus clock (PCLK2) value from the pre-programmed RCC
+*       registers. USART1/6 are clocked from PCLK2.
+*
+* Parameters:
+*   void
+*
+* Return :
+*  uint32_t:         APB2 clock value.
+*
+*******************************************************************************/
+uint32_t get_apb2_clock(void)
+{
+    uint32_t ppre2 = (RCC->CFGR & RCC_CFGR_PPRE2_Msk) >> RCC_CFGR_PPRE2_Pos;
+
+    return (get_ahb_clock() >> apb_prescaler_shift[ppre2]);
+}
+
+/*******************************************************************************
+* Function Name: get_timer_clock
+********************************************************************************
+* Summary:
+*       Returns the counter clock of a timer before it's prescaler, from the
+*       pre-programmed RCC registers. TIM1/8/9/10/11 are clocked from APB2 and
+*       the others from APB1, the timer clock is twice the APB clock if the APB
+*       prescaler is not 1.
+*
+* Parameters:
+*   TIMx:            Pointer to TIMx Base address.
+*
+* Return :
+*  uint32_t:         Timer clock value.
+*
+*******************************************************************************/
+uint32_t get_timer_clock(TIM_TypeDef *TIMx)
+{
+    uint32_t ppre = 0, pclk = 0;
+
+    if ((TIM1 == TIMx) || (TIM8 == TIMx) || (TIM9 == TIMx) || (TIM10 == TIMx) ||
+        (TIM11 == TIMx))
+    {
+        ppre = (RCC->CFGR & RCC_CFGR_PPRE2_Msk) >> RCC_CFGR_PPRE2_Pos;
+        pclk = get_apb2_clock();
+    }
+    else
+    {
+        ppre = (RCC->CFGR & RCC_CFGR_PPRE1_Msk) >> RCC_CFGR_PPRE1_Pos;
+        pclk = get_apb1_clock();
+    }
+
+    return (0U == apb_prescaler_shift[ppre]) ? (pclk) : (2U * pclk);
+}
 
 /* To Do */
 void systick_deconfig()
@@ -222,5 +222,9 @@ int systick_config_init(uint32_t interrupt_mode, uint32_t ticks);
 void delay_us_systick(uint32_t us_delay);
 void delay_ms_systick(uint32_t ms_delay);
 uint32_t get_systemcore_clock(void);
+uint32_t get_ahb_clock(void);
+uint32_t get_apb1_clock(void);
+uint32_t get_apb2_clock(void);
+uint32_t get_timer_clock(TIM_TypeDef *TIMx);
 
 #endif /* End of File */
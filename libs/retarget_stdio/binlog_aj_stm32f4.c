@@ -0,0 +1,139 @@
+/*******************************************************************************
+ * File Name: binlog_aj_stm32f4.c
+ *
+ * Description:
+ *   The file contains definitions for the deferred binary logging.
+ *
+ *   Each record is the 32-bit address of it's format string followed by the
+ *   argument words, in the little endian order of the core, framed with COBS
+ *   so that the host can re-sync at any frame delimiter.
+ *
+ * Related Document: See README.md
+ *
+ ******************************************************************************/
+#include "binlog_aj_stm32f4.h"
+
+/*******************************************************************************
+ * Global Variables
+ ******************************************************************************/
+/* Will be initialized by the binlog_init() */
+static usart_config_st_t *binlog_usartcfg_ptr = NULL;
+
+static binlog_stats_st_t binlog_stats;
+
+/*******************************************************************************
+ * Function Name: binlog_init()
+ *******************************************************************************
+ * Summary:
+ *  Initializes the binary log on a UART, the records are queued into the Tx
+ *  ring of the UART and sent in background by the USART TXE interrupt. The UART
+ *  should be configured already with usart_config() and usart_init().
+ *
+ *  NOTE: The binary records can't be mixed with text on the same UART, use a
+ *  UART other than the printf UART or a build without the printf output.
+ *
+ * Parameters:
+ *  usart_cfg:      Pointer to USART configs
+ *  tx_ring:        Storage for the Tx ring
+ *  tx_ring_size:   Size of the storage, a power of two
+ *
+ * Return :
+ *  result_funct_e_t:   Function completion status.
+ *
+ ******************************************************************************/
+result_funct binlog_init(usart_config_st_t *usart_cfg, uint8_t *tx_ring, uint16_t tx_ring_size)
+{
+  result_funct res = RESULT_FUNCT_STATUS_SUCCESS;
+
+  res = uart_write_async_init(usart_cfg, tx_ring, tx_ring_size);
+  if (RESULT_FUNCT_STATUS_SUCCESS != res)
+  {
+    return res;
+  }
+
+  binlog_stats.record_cnt = 0;
+  binlog_stats.drop_cnt = 0;
+  binlog_usartcfg_ptr = usart_cfg;
+
+  return res;
+}
+
+/*******************************************************************************
+ * Function Name: binlog_write()
+ *******************************************************************************
+ * Summary:
+ *  Queues a log record, called by the BINLOGx() macros. No formatting is done
+ *  on the target, the record is dropped and counted if the Tx ring is full, so
+ *  the call never waits for the UART. Can be called from thread and ISRs, the
+ *  record is queued with IRQs masked.
+ *
+ * Parameters:
+ *  fmt:            Format string, in the BINLOG_FMT_SECTION
+ *  argc:           Number of argument words, upto BINLOG_ARGS_MAX
+ *  a0 - a3:        Argument words
+ *
+ * Return :
+ *  void
+ *
+ ******************************************************************************/
+void binlog_write(const char *fmt, uint32_t argc, uint32_t a0, uint32_t a1,
+                  uint32_t a2, uint32_t a3)
+{
+  uint32_t record[1U + BINLOG_ARGS_MAX];
+  uint8_t frame[COBS_ENC_MAX_SIZE(BINLOG_RECORD_MAX_SIZE)];
+  uint16_t frame_size = 0;
+  uint32_t primask = 0;
+
+  if ((NULL == binlog_usartcfg_ptr) || (argc > BINLOG_ARGS_MAX))
+  {
+    return;
+  }
+
+  record[0] = (uint32_t)fmt;
+  record[1] = a0;
+  record[2] = a1;
+  record[3] = a2;
+  record[4] = a3;
+
+  (void)cobs_encode((uint8_t *)record, (uint16_t)(4U * (1U + argc)), frame, sizeof(frame),
+                    &frame_size);
+
+  /* The Tx ring has a single producer, serialize the thread and ISR callers */
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  if (USART_STATUS_SUCCESS == uart_write_async(binlog_usartcfg_ptr, frame, frame_size))
+  {
+    binlog_stats.record_cnt++;
+  }
+  else
+  {
+    binlog_stats.drop_cnt++;
+  }
+
+  __set_PRIMASK(primask);
+}
+
+/*******************************************************************************
+ * Function Name: binlog_get_stats()
+ *******************************************************************************
+ * Summary:
+ *  Returns the number of records queued and dropped.
+ *
+ * Parameters:
+ *  stats:          Filled with the statistics
+ *
+ * Return :
+ *  void
+ *
+ ******************************************************************************/
+void binlog_get_stats(binlog_stats_st_t *stats)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  *stats = binlog_stats;
+  __set_PRIMASK(primask);
+}
+
+/* End of File */
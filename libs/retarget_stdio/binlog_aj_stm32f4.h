@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * File Name: binlog_aj_stm32f4.h
+ *
+ * Description:
+ *   The file contains declarations for the deferred binary logging. The format
+ *   strings stay in flash, only the address of the format string and the raw
+ *   argument words are sent on the UART, the text is re-created on the host by
+ *   tools/binlog_decoder using the ELF image of the application.
+ *
+ * Related Document: See README.md
+ *
+ ******************************************************************************/
+#ifndef BINLOG_AJ_STM32F4
+#define BINLOG_AJ_STM32F4
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+#ifdef __STM32F407xx_H
+#include "stm32f407xx.h"
+#endif
+
+#include "usart_aj_stm32f4.h"
+#include "cobs_aj_stm32f4.h"
+#include "utils_aj_stm32f4.h"
+
+
+/*******************************************************************************
+ * Macros
+ ******************************************************************************/
+/* Section holding the format strings, read by the host decoder */
+#define BINLOG_FMT_SECTION                  "binlog_fmt"
+
+/* Max number of 32-bit argument words of a record */
+#define BINLOG_ARGS_MAX                     (4U)
+
+/* Record: format string address followed by the argument words, little endian */
+#define BINLOG_RECORD_MAX_SIZE              (4U * (1U + BINLOG_ARGS_MAX))
+
+/* Declares the format string of a log call in the format string section */
+#define BINLOG_FMT_DECL(fmt)                                                        \
+        static const char binlog_fmt[]                                              \
+        __attribute__((section(BINLOG_FMT_SECTION), used)) = (fmt)
+
+/* Log calls, the arguments are sent as 32-bit words. Integers and characters
+ * are passed as is, floats with BINLOG_F() and strings only if they are in
+ * flash, ex: BINLOG2("adc ch%u = %f\n", ch, BINLOG_F(volt));
+ */
+#define BINLOG0(fmt)                                                                \
+        do { BINLOG_FMT_DECL(fmt);                                                  \
+             binlog_write(binlog_fmt, 0U, 0U, 0U, 0U, 0U); } while (0)
+
+#define BINLOG1(fmt, a0)                                                            \
+        do { BINLOG_FMT_DECL(fmt);                                                  \
+             binlog_write(binlog_fmt, 1U, (uint32_t)(a0), 0U, 0U, 0U); } while (0)
+
+#define BINLOG2(fmt, a0, a1)                                                        \
+        do { BINLOG_FMT_DECL(fmt);                                                  \
+             binlog_write(binlog_fmt, 2U, (uint32_t)(a0), (uint32_t)(a1),           \
+                          0U, 0U); } while (0)
+
+#define BINLOG3(fmt, a0, a1, a2)                                                    \
+        do { BINLOG_FMT_DECL(fmt);                                                  \
+             binlog_write(binlog_fmt, 3U, (uint32_t)(a0), (uint32_t)(a1),           \
+                          (uint32_t)(a2), 0U); } while (0)
+
+#define BINLOG4(fmt, a0, a1, a2, a3)                                                \
+        do { BINLOG_FMT_DECL(fmt);                                                  \
+             binlog_write(binlog_fmt, 4U, (uint32_t)(a0), (uint32_t)(a1),           \
+                          (uint32_t)(a2), (uint32_t)(a3)); } while (0)
+
+/* Float argument as it's IEEE-754 bits, no promotion to double */
+#define BINLOG_F(val)                       (binlog_float_bits((float)(val)))
+
+
+/*******************************************************************************
+ * Global Variables
+ ******************************************************************************/
+/* Statistics of the binary log */
+typedef struct binlog_stats_st
+{
+  uint32_t record_cnt;
+  uint32_t drop_cnt;
+} binlog_stats_st_t;
+
+
+/*******************************************************************************
+ * Function Prototypes
+ ******************************************************************************/
+result_funct binlog_init(usart_config_st_t *usart_cfg, uint8_t *tx_ring, uint16_t tx_ring_size);
+
+void binlog_write(const char *fmt, uint32_t argc, uint32_t a0, uint32_t a1,
+                  uint32_t a2, uint32_t a3);
+
+void binlog_get_stats(binlog_stats_st_t *stats);
+
+/*******************************************************************************
+ * Function Name: binlog_float_bits()
+ *******************************************************************************
+ * Summary:
+ *  Returns the IEEE-754 bits of a float, for a BINLOG_F() argument.
+ *
+ ******************************************************************************/
+static __inline uint32_t binlog_float_bits(float val)
+{
+  union
+  {
+    float f;
+    uint32_t u;
+  } conv;
+
+  conv.f = val;
+
+  return conv.u;
+}
+
+#endif   /* BINLOG_AJ_STM32F4 */   /* End of File */
@@ -0,0 +1,542 @@
+/*******************************************************************************
+ * File Name: printf_lite_aj_stm32f4.c
+ *
+ * Description:
+ *   The file contains definitions for the light weight printf engine.
+ *
+ *   Supported conversions: %d %i %u %x %X %c %s %p %f %%, with the flags '-'
+ *   and '0', field width and precision (for %f and %s), both capped at
+ *   PRINTF_LITE_FIELD_MAX. The length modifiers 'l' and 'h' are accepted and
+ *   ignored, all integers are 32-bit. %f takes a float passed with LITE_F()
+ *   and is formatted in single precision fixed point.
+ *
+ *   There is no static or heap state, the output is built in a chunk on the
+ *   caller's stack and written with printf_retarget_write(), so the engine
+ *   can be used from ISRs. snprintf_lite()/vsnprintf_lite() format to a
+ *   buffer of the caller instead, ex: for the records of the log lib.
+ *
+ * Related Document: See README.md
+ *
+ ******************************************************************************/
+#include "printf_lite_aj_stm32f4.h"
+
+/*******************************************************************************
+ * Global Variables
+ ******************************************************************************/
+/* Output of a call, on the caller's stack, a chunk for stdout or the buffer
+ * of the caller.
+ */
+typedef struct lite_out_st
+{
+  uint8_t buff[PRINTF_LITE_CHUNK_SIZE];
+  uint16_t len;
+  int total;
+  bool to_dst;
+  char *dst;
+  size_t dst_size;
+} lite_out_st_t;
+
+/* Conversion specification */
+typedef struct lite_spec_st
+{
+  uint16_t width;
+  uint16_t prec;
+  bool left;
+  bool zero_pad;
+  bool has_prec;
+} lite_spec_st_t;
+
+static const uint32_t lite_pow10[PRINTF_LITE_FLOAT_PREC_MAX + 1U] = {
+  1U, 10U, 100U, 1000U, 10000U, 100000U, 1000000U,
+};
+
+static const char lite_hex_lower[] = "0123456789abcdef";
+static const char lite_hex_upper[] = "0123456789ABCDEF";
+
+/*******************************************************************************
+ * Function Name: lite_putc()
+ *******************************************************************************
+ * Summary:
+ *  Adds a character to the output chunk, writes the chunk once it is full. To
+ *  a buffer, the characters past it's size are counted and not stored.
+ *
+ ******************************************************************************/
+static void lite_putc(lite_out_st_t *out, char ch)
+{
+  if (out->to_dst)
+  {
+    if (((size_t)out->total + 1U) < out->dst_size)
+    {
+      out->dst[out->total] = ch;
+    }
+    out->total++;
+    return;
+  }
+
+  out->buff[out->len++] = (uint8_t)ch;
+  out->total++;
+
+  if (out->len >= PRINTF_LITE_CHUNK_SIZE)
+  {
+    (void)printf_retarget_write(out->buff, out->len);
+    out->len = 0;
+  }
+}
+
+/*******************************************************************************
+ * Function Name: lite_field_digit()
+ *******************************************************************************
+ * Summary:
+ *  Adds a digit to a field width or precision, capped at PRINTF_LITE_FIELD_MAX
+ *  so that a long number does not wrap.
+ *
+ ******************************************************************************/
+static uint16_t lite_field_digit(uint16_t val, char digit)
+{
+  uint32_t next = ((uint32_t)val * 10U) + (uint32_t)(digit - '0');
+
+  return (uint16_t)((next > PRINTF_LITE_FIELD_MAX) ? (PRINTF_LITE_FIELD_MAX) : (next));
+}
+
+/*******************************************************************************
+ * Function Name: lite_pad()
+ *******************************************************************************
+ * Summary:
+ *  Adds the padding character count times.
+ *
+ ******************************************************************************/
+static void lite_pad(lite_out_st_t *out, char ch, int32_t count)
+{
+  while (count-- > 0)
+  {
+    lite_putc(out, ch);
+  }
+}
+
+/*******************************************************************************
+ * Function Name: lite_put_field()
+ *******************************************************************************
+ * Summary:
+ *  Adds a converted field with the padding of the field width. The zero
+ *  padding goes between the sign and the digits.
+ *
+ * Parameters:
+ *  out:            Output chunk
+ *  spec:           Conversion specification
+ *  sign:           Sign character, '\0' for none
+ *  str:            Converted field without the sign
+ *  len:            Length of the field
+ *
+ * Return :
+ *  void
+ *
+ ******************************************************************************/
+static void lite_put_field(lite_out_st_t *out, const lite_spec_st_t *spec, char sign,
+                           const char *str, uint32_t len)
+{
+  int32_t pad = (int32_t)spec->width - (int32_t)len - (('\0' != sign) ? 1 : 0);
+
+  if (!spec->left && !spec->zero_pad)
+  {
+    lite_pad(out, ' ', pad);
+  }
+
+  if ('\0' != sign)
+  {
+    lite_putc(out, sign);
+  }
+
+  if (!spec->left && spec->zero_pad)
+  {
+    lite_pad(out, '0', pad);
+  }
+
+  while (len-- > 0U)
+  {
+    lite_putc(out, *str++);
+  }
+
+  if (spec->left)
+  {
+    lite_pad(out, ' ', pad);
+  }
+}
+
+/*******************************************************************************
+ * Function Name: lite_utoa()
+ *******************************************************************************
+ * Summary:
+ *  Converts an unsigned integer to digits, written backwards from the end of
+ *  the buffer.
+ *
+ * Parameters:
+ *  val:            Value to convert
+ *  base:           10 or 16
+ *  digits:         Digit characters of the base
+ *  end:            End of the buffer, the digits are written before it
+ *  min_digits:     Min number of digits, leading zeros added
+ *
+ * Return :
+ *  char *          Start of the digits
+ *
+ ******************************************************************************/
+static char *lite_utoa(uint32_t val, uint32_t base, const char *digits, char *end,
+                       uint32_t min_digits)
+{
+  char *p = end;
+
+  do
+  {
+    *--p = digits[val % base];
+    val /= base;
+  } while ((0U != val) || ((uint32_t)(end - p) < min_digits));
+
+  return p;
+}
+
+/*******************************************************************************
+ * Function Name: lite_put_float()
+ *******************************************************************************
+ * Summary:
+ *  Adds a float in fixed point, computed with single precision operations
+ *  only. Values of magnitude 2^32 and above are printed as "ovf".
+ *
+ * Parameters:
+ *  out:            Output chunk
+ *  spec:           Conversion specification
+ *  bits:           IEEE-754 bits of the float
+ *
+ * Return :
+ *  void
+ *
+ ******************************************************************************/
+static void lite_put_float(lite_out_st_t *out, const lite_spec_st_t *spec, uint32_t bits)
+{
+  char num[24];
+  char *end = &num[sizeof(num)];
+  char *p = end;
+  char sign = (bits & 0x80000000U) ? ('-') : ('\0');
+  uint32_t prec = (spec->has_prec) ? (spec->prec) : (PRINTF_LITE_FLOAT_PREC_DEF);
+  uint32_t int_part = 0, frac_part = 0;
+  float val = 0.0f;
+  union
+  {
+    uint32_t u;
+    float f;
+  } conv;
+
+  conv.u = bits & 0x7FFFFFFFU;
+  val = conv.f;
+
+  if (prec > PRINTF_LITE_FLOAT_PREC_MAX)
+  {
+    prec = PRINTF_LITE_FLOAT_PREC_MAX;
+  }
+
+  /* Exponent all ones: inf or nan */
+  if (0x7F800000U == (conv.u & 0x7F800000U))
+  {
+    lite_put_field(out, spec, sign, (conv.u & 0x007FFFFFU) ? ("nan") : ("inf"), 3U);
+    return;
+  }
+
+  if (val >= 4294967296.0f)
+  {
+    lite_put_field(out, spec, sign, "ovf", 3U);
+    return;
+  }
+
+  int_part = (uint32_t)val;
+  frac_part = (uint32_t)(((val - (float)int_part) * (float)lite_pow10[prec]) + 0.5f);
+
+  /* Rounding carried into the integer part */
+  if (frac_part >= lite_pow10[prec])
+  {
+    frac_part -= lite_pow10[prec];
+    int_part++;
+  }
+
+  if (0U != prec)
+  {
+    p = lite_utoa(frac_part, 10U, lite_hex_lower, p, prec);
+    *--p = '.';
+  }
+
+  p = lite_utoa(int_part, 10U, lite_hex_lower, p, 1U);
+
+  lite_put_field(out, spec, sign, p, (uint32_t)(end - p));
+}
+
+/*******************************************************************************
+ * Function Name: lite_format()
+ *******************************************************************************
+ * Summary:
+ *  Formats to the output, see the file description for the supported
+ *  conversions.
+ *
+ ******************************************************************************/
+static void lite_format(lite_out_st_t *out, const char *fmt, va_list args)
+{
+  lite_spec_st_t spec;
+  char num[12];
+  char *end = &num[sizeof(num)];
+  char *p = NULL;
+  const char *str = NULL;
+  uint32_t uval = 0, len = 0;
+  int32_t ival = 0;
+  char sign = '\0';
+
+  while ('\0' != *fmt)
+  {
+    if ('%' != *fmt)
+    {
+      lite_putc(out, *fmt++);
+      continue;
+    }
+
+    fmt++;
+
+    spec.width = 0;
+    spec.prec = 0;
+    spec.left = false;
+    spec.zero_pad = false;
+    spec.has_prec = false;
+
+    /* Flags */
+    while (('-' == *fmt) || ('0' == *fmt))
+    {
+      spec.left = spec.left || ('-' == *fmt);
+      spec.zero_pad = spec.zero_pad || ('0' == *fmt);
+      fmt++;
+    }
+
+    /* Field width and precision */
+    while ((*fmt >= '0') && (*fmt <= '9'))
+    {
+      spec.width = lite_field_digit(spec.width, *fmt++);
+    }
+
+    if ('.' == *fmt)
+    {
+      fmt++;
+      spec.has_prec = true;
+      while ((*fmt >= '0') && (*fmt <= '9'))
+      {
+        spec.prec = lite_field_digit(spec.prec, *fmt++);
+      }
+    }
+
+    /* Length modifiers, all integers are 32-bit */
+    while (('l' == *fmt) || ('h' == *fmt))
+    {
+      fmt++;
+    }
+
+    sign = '\0';
+
+    switch (*fmt)
+    {
+    case 'd':
+    case 'i':
+      ival = va_arg(args, int32_t);
+      uval = (uint32_t)ival;
+      if (ival < 0)
+      {
+        sign = '-';
+        uval = 0U - uval;
+      }
+      p = lite_utoa(uval, 10U, lite_hex_lower, end, 1U);
+      lite_put_field(out, &spec, sign, p, (uint32_t)(end - p));
+      break;
+
+    case 'u':
+      p = lite_utoa(va_arg(args, uint32_t), 10U, lite_hex_lower, end, 1U);
+      lite_put_field(out, &spec, sign, p, (uint32_t)(end - p));
+      break;
+
+    case 'x':
+      p = lite_utoa(va_arg(args, uint32_t), 16U, lite_hex_lower, end, 1U);
+      lite_put_field(out, &spec, sign, p, (uint32_t)(end - p));
+      break;
+
+    case 'X':
+      p = lite_utoa(va_arg(args, uint32_t), 16U, lite_hex_upper, end, 1U);
+      lite_put_field(out, &spec, sign, p, (uint32_t)(end - p));
+      break;
+
+    case 'p':
+      p = lite_utoa(va_arg(args, uint32_t), 16U, lite_hex_lower, end, 8U);
+      lite_put_field(out, &spec, sign, p, (uint32_t)(end - p));
+      break;
+
+    case 'c':
+      num[0] = (char)va_arg(args, int);
+      lite_put_field(out, &spec, sign, num, 1U);
+      break;
+
+    case 's':
+      str = va_arg(args, const char *);
+      if (NULL == str)
+      {
+        str = "(null)";
+      }
+      for (len = 0; ('\0' != str[len]) && ((!spec.has_prec) || (len < spec.prec)); len++)
+        ;
+      spec.zero_pad = false;
+      lite_put_field(out, &spec, sign, str, len);
+      break;
+
+    case 'f':
+      lite_put_float(out, &spec, va_arg(args, uint32_t));
+      break;
+
+    case '%':
+      lite_putc(out, '%');
+      break;
+
+    case '\0':
+      /* Incomplete specification at the end of the format */
+      fmt--;
+      break;
+
+    default:
+      /* Unsupported conversion, printed as is */
+      lite_putc(out, '%');
+      lite_putc(out, *fmt);
+      break;
+    }
+
+    fmt++;
+  }
+}
+
+/*******************************************************************************
+ * Function Name: vprintf_lite()
+ *******************************************************************************
+ * Summary:
+ *  Formats and writes to the re-targetted stdout, see the file description for
+ *  the supported conversions. Reentrant, can be called from ISRs.
+ *
+ * Parameters:
+ *  fmt:            Format string
+ *  args:           Arguments for the format
+ *
+ * Return :
+ *  int             Number of characters formatted
+ *
+ ******************************************************************************/
+int vprintf_lite(const char *fmt, va_list args)
+{
+  lite_out_st_t out;
+
+  out.len = 0;
+  out.total = 0;
+  out.to_dst = false;
+  out.dst = NULL;
+  out.dst_size = 0;
+
+  lite_format(&out, fmt, args);
+
+  if (0U != out.len)
+  {
+    (void)printf_retarget_write(out.buff, out.len);
+  }
+
+  return out.total;
+}
+
+/*******************************************************************************
+ * Function Name: vsnprintf_lite()
+ *******************************************************************************
+ * Summary:
+ *  Formats to a buffer, like vsnprintf(), with the conversions of
+ *  vprintf_lite(). The output is truncated to size - 1 characters and is
+ *  always terminated, unless size is 0. Reentrant, can be called from ISRs.
+ *
+ * Parameters:
+ *  buff:           Buffer for the output, can be NULL if size is 0
+ *  size:           Size of the buffer
+ *  fmt:            Format string
+ *  args:           Arguments for the format
+ *
+ * Return :
+ *  int             Number of characters formatted, without the terminating
+ *                  null, the output is truncated if it is size or more.
+ *
+ ******************************************************************************/
+int vsnprintf_lite(char *buff, size_t size, const char *fmt, va_list args)
+{
+  lite_out_st_t out;
+
+  out.len = 0;
+  out.total = 0;
+  out.to_dst = true;
+  out.dst = buff;
+  out.dst_size = size;
+
+  lite_format(&out, fmt, args);
+
+  if (0U != size)
+  {
+    buff[((size_t)out.total < size) ? ((size_t)out.total) : (size - 1U)] = '\0';
+  }
+
+  return out.total;
+}
+
+/*******************************************************************************
+ * Function Name: printf_lite()
+ *******************************************************************************
+ * Summary:
+ *  Formats and writes to the re-targetted stdout, see vprintf_lite().
+ *
+ * Parameters:
+ *  fmt:            Format string
+ *  ...:            Arguments for the format
+ *
+ * Return :
+ *  int             Number of characters formatted
+ *
+ ******************************************************************************/
+int printf_lite(const char *fmt, ...)
+{
+  va_list args;
+  int len = 0;
+
+  va_start(args, fmt);
+  len = vprintf_lite(fmt, args);
+  va_end(args);
+
+  return len;
+}
+
+/*******************************************************************************
+ * Function Name: snprintf_lite()
+ *******************************************************************************
+ * Summary:
+ *  Formats to a buffer, see vsnprintf_lite().
+ *
+ * Parameters:
+ *  buff:           Buffer for the output, can be NULL if size is 0
+ *  size:           Size of the buffer
+ *  fmt:            Format string
+ *  ...:            Arguments for the format
+ *
+ * Return :
+ *  int             Number of characters formatted, without the terminating
+ *                  null
+ *
+ ******************************************************************************/
+int snprintf_lite(char *buff, size_t size, const char *fmt, ...)
+{
+  va_list args;
+  int len = 0;
+
+  va_start(args, fmt);
+  len = vsnprintf_lite(buff, size, fmt, args);
+  va_end(args);
+
+  return len;
+}
+
+/* End of File */
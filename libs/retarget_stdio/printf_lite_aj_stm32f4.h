@@ -0,0 +1,73 @@
+/*******************************************************************************
+ * File Name: printf_lite_aj_stm32f4.h
+ *
+ * Description:
+ *   The file contains declarations for the light weight printf engine, which
+ *   writes to the re-targetted stdout, or to a buffer, without the toolchain's
+ *   libc printf.
+ *
+ * Related Document: See README.md
+ *
+ ******************************************************************************/
+#ifndef PRINTF_LITE_AJ_STM32F4
+#define PRINTF_LITE_AJ_STM32F4
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+#include "retarget_stdio_aj_stm32f4.h"
+
+
+/*******************************************************************************
+ * Macros
+ ******************************************************************************/
+/* Size of the on-stack chunk, the output is written to stdout in chunks of
+ * upto this size. It is the main part of the stack used by a call.
+ */
+#ifndef PRINTF_LITE_CHUNK_SIZE
+#define PRINTF_LITE_CHUNK_SIZE              (32U)
+#endif
+
+/* Max field width and precision, larger values are capped to it */
+#define PRINTF_LITE_FIELD_MAX               (1024U)
+
+/* Default and max precision of %f, a float has ~7 significant digits */
+#define PRINTF_LITE_FLOAT_PREC_DEF          (6U)
+#define PRINTF_LITE_FLOAT_PREC_MAX          (6U)
+
+/* Float argument for %f, passed as it's IEEE-754 bits so the variadic call
+ * does not promote it to double, ex: printf_lite("%.2f\n", LITE_F(temp));
+ */
+#define LITE_F(val)                         (printf_lite_float_bits((float)(val)))
+
+
+/*******************************************************************************
+ * Function Prototypes
+ ******************************************************************************/
+int printf_lite(const char *fmt, ...);
+int vprintf_lite(const char *fmt, va_list args);
+int snprintf_lite(char *buff, size_t size, const char *fmt, ...);
+int vsnprintf_lite(char *buff, size_t size, const char *fmt, va_list args);
+
+/*******************************************************************************
+ * Function Name: printf_lite_float_bits()
+ *******************************************************************************
+ * Summary:
+ *  Returns the IEEE-754 bits of a float, for a LITE_F() argument.
+ *
+ ******************************************************************************/
+static __inline uint32_t printf_lite_float_bits(float val)
+{
+  union
+  {
+    float f;
+    uint32_t u;
+  } conv;
+
+  conv.f = val;
+
+  return conv.u;
+}
+
+#endif   /* PRINTF_LITE_AJ_STM32F4 */   /* End of File */
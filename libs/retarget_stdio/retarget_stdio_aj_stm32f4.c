@@ -8,6 +8,7 @@
  *
  ******************************************************************************/
 #include <stdio.h>
+#include <string.h>
 #include "stm32f4xx.h"
 #include "stm32f407xx.h"
 #include "retarget_stdio_aj_stm32f4.h"
@@ -15,7 +16,45 @@
 /*******************************************************************************
  * Global Variables
  ******************************************************************************/
+/* Build fails if the printf UART baud rate can't be generated accurately */
+USART_BAUD_STATIC_CHECK(printf_uart_baud_check, PRINTF_UART_CLOCK_VAL, PRINTF_UART_BAUDRATE);
+
+#if (PRINTF_RETARGET_MODE_BLOCKING == PRINTF_RETARGET_MODE)
 static uint8_t print_buff_size = 1;
+#endif
+
+#if (PRINTF_RETARGET_MODE_BLOCKING != PRINTF_RETARGET_MODE)
+/* Staging buffer for the stdout, queued to the Tx ring as a whole */
+static uint8_t stdout_line_buff[PRINTF_RETARGET_LINE_SIZE];
+static uint16_t stdout_line_len = 0;
+
+/* Tx ring of the printf UART, drained by the USART TXE interrupt */
+static uint8_t stdout_tx_ring[PRINTF_RETARGET_RING_SIZE];
+#endif
+
+#if (0U != PRINTF_RETARGET_STDIN)
+/* Line being edited by the RXNE interrupt, handed over to fgetc() as a whole
+ * once the line ends, the interrupt does not touch it till it is consumed.
+ */
+static uint8_t stdin_line_buff[PRINTF_RETARGET_STDIN_LINE_SIZE];
+static volatile uint16_t stdin_line_len = 0;
+static volatile bool stdin_line_ready = false;
+static uint16_t stdin_read_idx = 0;
+
+/* Last received character was CR, a LF after it is the same line end */
+static bool stdin_last_cr = false;
+
+/* Characters received while a completed line is not consumed yet */
+static volatile uint32_t stdin_drop_cnt = 0;
+#endif
+
+/* Write statistics, see printf_retarget_get_stats() */
+static printf_retarget_stats_st_t stdout_stats;
+
+#if (PRINTF_RETARGET_MODE_DROP == PRINTF_RETARGET_MODE)
+/* Bytes dropped since the last drop marker */
+static uint32_t stdout_drop_pend = 0;
+#endif
 
 /* Will be initialized by the printf_retarget_uart_init() */
 static usart_config_st_t *retarg_usartcfg_ptr = NULL;
@@ -48,6 +87,311 @@ usart_config_st_t printf_usartcfg = {
     .parity = PRINTF_UART_PARITY,
 };
 
+#if (PRINTF_RETARGET_MODE_BLOCKING != PRINTF_RETARGET_MODE)
+#if (PRINTF_RETARGET_MODE_BUFFERED == PRINTF_RETARGET_MODE)
+/*******************************************************************************
+ * Function Name: stdout_ring_put()
+ *******************************************************************************
+ * Summary:
+ *  Queues data into the Tx ring of the printf UART in the BUFFERED mode. The
+ *  ring has a single producer, so the data is queued with IRQs masked, this
+ *  keeps the writes from thread and ISRs whole and in order. Waiting for space
+ *  is only done in thread context with IRQs enabled, as the ring is drained by
+ *  an ISR.
+ *
+ * Parameters:
+ *  buff:           Data to queue
+ *  size:           Size of the data
+ *
+ * Return :
+ *  bool            true if the data is queued
+ *
+ ******************************************************************************/
+static bool stdout_ring_put(const uint8_t *buff, uint16_t size)
+{
+  usart_status_e_t status = USART_STATUS_SUCCESS;
+  uint32_t primask = 0;
+
+  if (NULL == retarg_usartcfg_ptr)
+  {
+    return false;
+  }
+
+  do
+  {
+    primask = __get_PRIMASK();
+    __disable_irq();
+    status = uart_write_async(retarg_usartcfg_ptr, (uint8_t *)buff, size);
+    __set_PRIMASK(primask);
+  } while ((UART_STATUS_TRANSMIT_BUSY == status) &&
+           (0U == primask) && (0U == __get_IPSR()));
+
+  return (USART_STATUS_SUCCESS == status);
+}
+#endif
+
+#if (PRINTF_RETARGET_MODE_DROP == PRINTF_RETARGET_MODE)
+/*******************************************************************************
+ * Function Name: stdout_drop_marker_put()
+ *******************************************************************************
+ * Summary:
+ *  Queues the marker "[N bytes dropped]" of the pending drops, if the ring has
+ *  space for it. Called with IRQs masked.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return :
+ *  bool            true if no drop is pending any more
+ *
+ ******************************************************************************/
+static bool stdout_drop_marker_put(void)
+{
+  static const char marker_head[] = "[";
+  static const char marker_tail[] = " bytes dropped]\r\n";
+  char marker[32];
+  char digits[10];
+  uint16_t len = 0, digit_cnt = 0;
+  uint32_t pend = stdout_drop_pend;
+
+  if (0U == pend)
+  {
+    return true;
+  }
+
+  memcpy(marker, marker_head, sizeof(marker_head) - 1U);
+  len = sizeof(marker_head) - 1U;
+
+  do
+  {
+    digits[digit_cnt++] = (char)('0' + (pend % 10U));
+    pend /= 10U;
+  } while (0U != pend);
+
+  while (0U != digit_cnt)
+  {
+    marker[len++] = digits[--digit_cnt];
+  }
+
+  memcpy(&marker[len], marker_tail, sizeof(marker_tail) - 1U);
+  len += sizeof(marker_tail) - 1U;
+
+  if (USART_STATUS_SUCCESS == uart_write_async(retarg_usartcfg_ptr, (uint8_t *)marker, len))
+  {
+    stdout_drop_pend = 0;
+  }
+
+  return (0U == stdout_drop_pend);
+}
+
+/*******************************************************************************
+ * Function Name: stdout_tx_idle_handler()
+ *******************************************************************************
+ * Summary:
+ *  Tx idle callback of the printf UART, called from the USART ISR once the
+ *  ring is drained. Queues the pending drop marker, so the drops at the end of
+ *  a burst are reported without waiting for the next write.
+ *
+ ******************************************************************************/
+static void stdout_tx_idle_handler(usart_config_st_t *usart_cfg)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  (void)usart_cfg;
+
+  __disable_irq();
+  (void)stdout_drop_marker_put();
+  __set_PRIMASK(primask);
+}
+
+/*******************************************************************************
+ * Function Name: stdout_drop_put()
+ *******************************************************************************
+ * Summary:
+ *  Queues data into the Tx ring in the DROP mode, the data is dropped and
+ *  counted if it does not fit. After a drop, the marker "[N bytes dropped]"
+ *  is queued before the next data, or once the ring is drained.
+ *
+ * Parameters:
+ *  buff:           Data to queue
+ *  size:           Size of the data
+ *
+ * Return :
+ *  bool            true if the data is queued
+ *
+ ******************************************************************************/
+static bool stdout_drop_put(const uint8_t *buff, uint16_t size)
+{
+  uint32_t primask = 0;
+  bool queued = false;
+
+  if (NULL == retarg_usartcfg_ptr)
+  {
+    return false;
+  }
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  /* Data is not queued till the marker is, the drop is reported in order */
+  if (stdout_drop_marker_put() &&
+      (USART_STATUS_SUCCESS == uart_write_async(retarg_usartcfg_ptr, (uint8_t *)buff, size)))
+  {
+    queued = true;
+  }
+  else
+  {
+    stdout_drop_pend += size;
+    stdout_stats.drop_bytes += size;
+    stdout_stats.drop_cnt++;
+  }
+
+  __set_PRIMASK(primask);
+
+  return queued;
+}
+#endif
+#endif
+
+/*******************************************************************************
+ * Function Name: stdout_write()
+ *******************************************************************************
+ * Summary:
+ *  Writes data to the UART as per PRINTF_RETARGET_MODE, and records the worst
+ *  case time of a write.
+ *
+ * Parameters:
+ *  buff:           Data to write
+ *  size:           Size of the data
+ *
+ * Return :
+ *  uint16_t        Number of bytes written, 0 if dropped
+ *
+ ******************************************************************************/
+static uint16_t stdout_write(const uint8_t *buff, uint16_t size)
+{
+  uint16_t tx_size = 0;
+  uint32_t start = cyccnt_get();
+  uint32_t cycles = 0;
+
+#if (PRINTF_RETARGET_MODE_BLOCKING == PRINTF_RETARGET_MODE)
+  if (NULL == retarg_usartcfg_ptr)
+  {
+    return 0U;
+  }
+
+  uart_transmit_blocking(retarg_usartcfg_ptr, (uint8_t *)buff, size,
+                         USART_TIMEOUT_WAIT_FOREVER, &tx_size);
+#elif (PRINTF_RETARGET_MODE_DROP == PRINTF_RETARGET_MODE)
+  tx_size = (stdout_drop_put(buff, size)) ? (size) : (0U);
+#else
+  tx_size = (stdout_ring_put(buff, size)) ? (size) : (0U);
+#endif
+
+  /* Worst case time of a write, a racing writer may lose an update */
+  cycles = cyccnt_get() - start;
+  if (cycles > stdout_stats.write_max_cycles)
+  {
+    stdout_stats.write_max_cycles = cycles;
+  }
+
+  return tx_size;
+}
+
+#if (PRINTF_RETARGET_MODE_BLOCKING != PRINTF_RETARGET_MODE)
+/*******************************************************************************
+ * Function Name: stdout_push()
+ *******************************************************************************
+ * Summary:
+ *  Queues the staged stdout data into the Tx ring of the printf UART.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return :
+ *  void
+ *
+ ******************************************************************************/
+static void stdout_push(void)
+{
+  if (0U != stdout_line_len)
+  {
+    (void)stdout_write(stdout_line_buff, stdout_line_len);
+  }
+
+  stdout_line_len = 0;
+}
+#endif
+
+/*******************************************************************************
+ * Function Name: printf_retarget_write()
+ *******************************************************************************
+ * Summary:
+ *  Writes data to the re-targetted stdout, as per PRINTF_RETARGET_MODE. In the
+ *  BUFFERED mode waits for the ring to have space, except when called from an
+ *  ISR or with IRQs masked, in the DROP mode the data is dropped if the ring
+ *  is full. Safe to be called from thread and ISRs in the BUFFERED and DROP
+ *  modes, the data is not mixed with the other writers.
+ *
+ *  In thread mode the output staged by printf() is queued first, so a
+ *  printf() without a new line stays in order with the writes. The staging
+ *  buffer belongs to the thread, the writes from ISRs leave it as it is.
+ *
+ * Parameters:
+ *  buff:           Data to write
+ *  size:           Size of the data, upto PRINTF_RETARGET_RING_SIZE
+ *
+ * Return :
+ *  uint16_t        Number of bytes written, 0 if dropped
+ *
+ ******************************************************************************/
+uint16_t printf_retarget_write(const uint8_t *buff, uint16_t size)
+{
+#if (PRINTF_RETARGET_MODE_BLOCKING != PRINTF_RETARGET_MODE)
+  if ((0U != stdout_line_len) && (0U == __get_IPSR()))
+  {
+    stdout_push();
+  }
+#endif
+
+  return stdout_write(buff, size);
+}
+
+/*******************************************************************************
+ * Function Name: printf_retarget_get_stats()
+ *******************************************************************************
+ * Summary:
+ *  Returns the write statistics of the stdout, the bytes and writes dropped
+ *  in the DROP mode, and the worst case time of printf_retarget_write() in core
+ *  cycles, measured on the DWT cycle counter. A write is a line or a chunk
+ *  of PRINTF_RETARGET_LINE_SIZE from printf(), or a chunk of printf_lite().
+ *
+ * Parameters:
+ *  stats:          Filled with the statistics
+ *  reset:          true to reset the statistics after reading
+ *
+ * Return :
+ *  void
+ *
+ ******************************************************************************/
+void printf_retarget_get_stats(printf_retarget_stats_st_t *stats, bool reset)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+
+  *stats = stdout_stats;
+
+  if (reset)
+  {
+    stdout_stats.drop_bytes = 0;
+    stdout_stats.drop_cnt = 0;
+    stdout_stats.write_max_cycles = 0;
+  }
+
+  __set_PRIMASK(primask);
+}
+
 /*******************************************************************************
  * Function Name: fputc()
  *******************************************************************************
@@ -67,15 +411,285 @@ usart_config_st_t printf_usartcfg = {
  ******************************************************************************/
 int fputc(int ch, FILE *stream)
 {
-  uart_transmit_blocking(retarg_usartcfg_ptr, (uint8_t *)&ch, print_buff_size, 0);
+#if (PRINTF_RETARGET_MODE_BLOCKING == PRINTF_RETARGET_MODE)
+  uart_transmit_blocking(retarg_usartcfg_ptr, (uint8_t *)&ch, print_buff_size,
+                         USART_TIMEOUT_WAIT_FOREVER, NULL);
+#else
+  /* Only stage the character, the UART is touched once per line or chunk */
+  stdout_line_buff[stdout_line_len++] = (uint8_t)ch;
+
+  if ((stdout_line_len >= PRINTF_RETARGET_LINE_SIZE) ||
+      ((0U != PRINTF_RETARGET_LINE_BUFFERED) && ('\n' == ch)))
+  {
+    stdout_push();
+  }
+#endif
+
+  return ch;
+}
+
+#if (0U != PRINTF_RETARGET_STDIN)
+/*******************************************************************************
+ * Function Name: stdin_echo()
+ *******************************************************************************
+ * Summary:
+ *  Echoes the line editing output on stdout, called from the RXNE interrupt.
+ *
+ ******************************************************************************/
+static __inline void stdin_echo(const char *str, uint16_t len)
+{
+#if (0U != PRINTF_RETARGET_STDIN_ECHO)
+  (void)printf_retarget_write((const uint8_t *)str, len);
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: stdin_rxne_handler()
+ *******************************************************************************
+ * Summary:
+ *  RXNE event handler of the printf UART, edits the stdin line. CR, LF and
+ *  CR LF end the line and are stored as a single '\n', backspace and DEL
+ *  erase the last character. The completed line is handed over to fgetc(),
+ *  characters received before it is consumed are dropped and counted.
+ *
+ * Parameters:
+ *  usart_cfg:      Pointer to USART configs
+ *  sr:             USART_SR read on the interrupt entry
+ *  cb_arg:         Not used
+ *
+ * Return :
+ *  void
+ *
+ ******************************************************************************/
+static void stdin_rxne_handler(usart_config_st_t *usart_cfg, uint32_t sr, void *cb_arg)
+{
+  /* Reading DR clears RXNE, and ORE as SR was read before */
+  char ch = (char)usart_cfg->instance->DR;
+  bool last_cr = stdin_last_cr;
+  uint16_t len = stdin_line_len;
+
+  (void)sr;
+  (void)cb_arg;
+
+  stdin_last_cr = ('\r' == ch);
+
+  if (stdin_line_ready)
+  {
+    stdin_drop_cnt++;
+    return;
+  }
+
+  if (('\r' == ch) || ('\n' == ch))
+  {
+    if (last_cr && ('\n' == ch))
+    {
+      return;
+    }
+
+    stdin_line_buff[len++] = (uint8_t)'\n';
+    stdin_line_len = len;
+    stdin_line_ready = true;
+    stdin_echo("\r\n", 2U);
+  }
+  else if (('\b' == ch) || (0x7F == ch))
+  {
+    if (0U != len)
+    {
+      stdin_line_len = (uint16_t)(len - 1U);
+      stdin_echo("\b \b", 3U);
+    }
+  }
+  else if (len < (PRINTF_RETARGET_STDIN_LINE_SIZE - 1U))
+  {
+    /* Last place of the buffer is kept for the '\n' */
+    stdin_line_buff[len++] = (uint8_t)ch;
+    stdin_line_len = len;
+    stdin_echo(&ch, 1U);
+  }
+  else
+  {
+    stdin_drop_cnt++;
+  }
+}
+
+/*******************************************************************************
+ * Function Name: fgetc()
+ *******************************************************************************
+ * Summary:
+ *  Defines the "fgetc" function used by "fgets" and "scanf". Returns the next
+ *  character of the completed stdin line, the core sleeps with WFI till the
+ *  RXNE interrupt completes a line, so the UART is not polled. The staged
+ *  stdout is queued before waiting, so a prompt without a new line is seen.
+ *  Must be called in thread mode.
+ *
+ * Parameters:
+ *  stream:         File stream to read, only stdin is supported.
+ *
+ * Return :
+ *  int             The character read, EOF if stdin is not initialized.
+ *
+ ******************************************************************************/
+int fgetc(FILE *stream)
+{
+  int ch = 0;
+
+  (void)stream;
+
+  if (NULL == retarg_usartcfg_ptr)
+  {
+    return EOF;
+  }
+
+  /* Line fully read, the line is released to the RXNE interrupt here and not
+   * on the last character, so that __backspace() can return it.
+   */
+  if (stdin_line_ready && (stdin_read_idx >= stdin_line_len))
+  {
+    stdin_read_idx = 0;
+    stdin_line_len = 0;
+    __DMB();
+    stdin_line_ready = false;
+  }
+
+  if (!stdin_line_ready)
+  {
+#if (PRINTF_RETARGET_MODE_BLOCKING != PRINTF_RETARGET_MODE)
+    stdout_push();
+#endif
+
+    while (!stdin_line_ready)
+    {
+      __WFI();
+    }
+  }
+
+  ch = (int)stdin_line_buff[stdin_read_idx++];
+
   return ch;
 }
 
+/*******************************************************************************
+ * Function Name: __backspace()
+ *******************************************************************************
+ * Summary:
+ *  Returns the last character read by fgetc() to stdin, used by "scanf" of
+ *  the ARM C library to un-read the character which ends a conversion.
+ *
+ * Parameters:
+ *  stream:         File stream, only stdin is supported.
+ *
+ * Return :
+ *  int             0 on success, EOF if there is no character to return.
+ *
+ ******************************************************************************/
+int __backspace(FILE *stream)
+{
+  (void)stream;
+
+  if (0U == stdin_read_idx)
+  {
+    return EOF;
+  }
+
+  stdin_read_idx--;
+
+  return 0;
+}
+
+/*******************************************************************************
+ * Function Name: printf_retarget_stdin_drop_cnt()
+ *******************************************************************************
+ * Summary:
+ *  Returns the number of stdin characters dropped, received while a completed
+ *  line was not consumed or beyond PRINTF_RETARGET_STDIN_LINE_SIZE.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return :
+ *  uint32_t        Number of characters dropped
+ *
+ ******************************************************************************/
+uint32_t printf_retarget_stdin_drop_cnt(void)
+{
+  return stdin_drop_cnt;
+}
+#endif
+
+/*******************************************************************************
+ * Function Name: fflush()
+ *******************************************************************************
+ * Summary:
+ *  Defines the "fflush" function for the re-targetted stdout, see
+ *  printf_retarget_flush().
+ *
+ * Parameters:
+ *  stream:         File stream to flush, only stdout is buffered.
+ *
+ * Return :
+ *  int             0 on success.
+ *
+ ******************************************************************************/
+int fflush(FILE *stream)
+{
+  if ((NULL == stream) || (&__stdout == stream))
+  {
+    printf_retarget_flush();
+  }
+
+  return 0;
+}
+
+/*******************************************************************************
+ * Function Name: printf_retarget_flush()
+ *******************************************************************************
+ * Summary:
+ *  Queues the staged stdout data and waits till all the queued data is sent
+ *  out on the UART line. Waits for ring space even in the DROP mode, as the
+ *  flush is an explicit request of the caller. Must not be called from an ISR
+ *  with priority equal or higher than USART_IRQ_PRIORITY.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return :
+ *  void
+ *
+ ******************************************************************************/
+void printf_retarget_flush(void)
+{
+#if (PRINTF_RETARGET_MODE_BLOCKING != PRINTF_RETARGET_MODE)
+  if (NULL == retarg_usartcfg_ptr)
+  {
+    return;
+  }
+
+#if (PRINTF_RETARGET_MODE_DROP == PRINTF_RETARGET_MODE)
+  /* Ring emptied first, so a pending drop marker and the staged data fit */
+  uart_flush(retarg_usartcfg_ptr);
+  stdout_tx_idle_handler(retarg_usartcfg_ptr);
+#endif
+
+  if (0U != stdout_line_len)
+  {
+#if (PRINTF_RETARGET_MODE_DROP == PRINTF_RETARGET_MODE)
+    (void)stdout_drop_put(stdout_line_buff, stdout_line_len);
+#else
+    (void)stdout_ring_put(stdout_line_buff, stdout_line_len);
+#endif
+    stdout_line_len = 0;
+  }
+
+  uart_flush(retarg_usartcfg_ptr);
+#endif
+}
+
 /*******************************************************************************
  * Function Name: printf_retarget_uart_init()
  *******************************************************************************
  * Summary:
- *    This function initializes the UART for redirecting the printf.
+ *    This function initializes the UART for redirecting the printf, the Tx ring
+ *    of the stdout in the BUFFERED and DROP modes, and the interrupt fed stdin.
  *
  *    NOTE: The HW/SW configs used in this function are present in the file BSP
  *    libs header file.
@@ -113,6 +727,39 @@ result_funct printf_retarget_uart_init(void)
     return res;
   }
 
+#if (PRINTF_RETARGET_MODE_BLOCKING != PRINTF_RETARGET_MODE)
+  /* Tx ring drained in background by the USART TXE interrupt */
+  res = uart_write_async_init(&printf_usartcfg, stdout_tx_ring, PRINTF_RETARGET_RING_SIZE);
+  if (RESULT_FUNCT_STATUS_SUCCESS != res)
+  {
+    return res;
+  }
+#endif
+
+#if (PRINTF_RETARGET_MODE_DROP == PRINTF_RETARGET_MODE)
+  /* Drops at the end of a burst are reported once the ring drains */
+  res = uart_write_async_register_idle_cb(&printf_usartcfg, stdout_tx_idle_handler);
+  if (RESULT_FUNCT_STATUS_SUCCESS != res)
+  {
+    return res;
+  }
+#endif
+
+#if (0U != PRINTF_RETARGET_STDIN)
+  /* stdin line edited by the RXNE interrupt, nothing is done till a key press */
+  res = usart_register_callback(&printf_usartcfg, USART_EVENT_RXNE, stdin_rxne_handler, NULL);
+  if (RESULT_FUNCT_STATUS_SUCCESS != res)
+  {
+    return res;
+  }
+
+  res = usart_event_enable(&printf_usartcfg, USART_EVENT_RXNE, true);
+  if (RESULT_FUNCT_STATUS_SUCCESS != res)
+  {
+    return res;
+  }
+#endif
+
   return res;
 }
 
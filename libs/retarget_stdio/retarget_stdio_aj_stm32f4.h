@@ -25,11 +25,83 @@
 /*******************************************************************************
  * Macros
  ******************************************************************************/
+/* stdout modes, selected at build time with PRINTF_RETARGET_MODE
+ *  - BLOCKING: each character is sent with uart_transmit_blocking()
+ *  - BUFFERED: characters are staged and queued into a RAM ring drained by the
+ *              USART TXE interrupt, the caller waits only if the ring is full
+ *  - DROP:     same as BUFFERED, but output which does not fit in the ring is
+ *              dropped instead of waited on, so the time of a printf() is
+ *              bounded. The drops are counted, and "[N bytes dropped]" is
+ *              printed once the ring has space again.
+ */
+#define PRINTF_RETARGET_MODE_BLOCKING       (0U)
+#define PRINTF_RETARGET_MODE_BUFFERED       (1U)
+#define PRINTF_RETARGET_MODE_DROP           (2U)
+
+#ifndef PRINTF_RETARGET_MODE
+#define PRINTF_RETARGET_MODE                (PRINTF_RETARGET_MODE_BUFFERED)
+#endif
+
+/* 1: staged output is queued on each new line, 0: only when the staging
+ * buffer is full, or on fflush(stdout).
+ */
+#ifndef PRINTF_RETARGET_LINE_BUFFERED
+#define PRINTF_RETARGET_LINE_BUFFERED       (1U)
+#endif
+
+/* Size of the staging buffer, the output is queued to the ring in chunks of
+ * upto this size.
+ */
+#ifndef PRINTF_RETARGET_LINE_SIZE
+#define PRINTF_RETARGET_LINE_SIZE           (64U)
+#endif
+
+/* Size of the Tx ring drained by the USART interrupt, a power of two */
+#ifndef PRINTF_RETARGET_RING_SIZE
+#define PRINTF_RETARGET_RING_SIZE           (512U)
+#endif
+
+/* 1: stdin is fed by the USART RXNE interrupt of the printf UART, for
+ * fgetc(), fgets() and scanf(). 0: no stdin.
+ */
+#ifndef PRINTF_RETARGET_STDIN
+#define PRINTF_RETARGET_STDIN               (1U)
+#endif
+
+/* Size of the stdin line buffer, including the '\n', longer input is dropped
+ * till the line ends.
+ */
+#ifndef PRINTF_RETARGET_STDIN_LINE_SIZE
+#define PRINTF_RETARGET_STDIN_LINE_SIZE     (64U)
+#endif
+
+/* 1: the received characters are echoed back on stdout */
+#ifndef PRINTF_RETARGET_STDIN_ECHO
+#define PRINTF_RETARGET_STDIN_ECHO          (1U)
+#endif
+
+
+/*******************************************************************************
+ * Global Variables
+ ******************************************************************************/
+typedef struct printf_retarget_stats_st
+{
+  uint32_t drop_bytes;        /* Bytes dropped in the DROP mode */
+  uint32_t drop_cnt;          /* Writes dropped in the DROP mode */
+  uint32_t write_max_cycles;  /* Worst case printf_retarget_write() time */
+} printf_retarget_stats_st_t;
 
 
 /*******************************************************************************
  * Function Prototypes
  ******************************************************************************/
 result_funct printf_retarget_uart_init(void);
+void printf_retarget_flush(void);
+uint16_t printf_retarget_write(const uint8_t *buff, uint16_t size);
+void printf_retarget_get_stats(printf_retarget_stats_st_t *stats, bool reset);
+
+#if (0U != PRINTF_RETARGET_STDIN)
+uint32_t printf_retarget_stdin_drop_cnt(void);
+#endif
 
 #endif   /* RETARGET_STDIO_AJ_STM32F4 */   /* End of File */
@@ -8,6 +8,16 @@
 *
 *******************************************************************************/
 #include "timer_aj_stm32f4.h"
+#include "rcc_aj_stm32f4.h"
+
+/*******************************************************************************
+* Global Variables
+*******************************************************************************/
+volatile uint32_t timebase_high = 0;
+
+static timebase_compare_cb_t timebase_compare_cb = NULL;
+static timebase_tick_cb_t timebase_tick_cb = NULL;
+static uint32_t timebase_tick_period = 0;
 
 /*******************************************************************************
 * Function Name: general_timer_config()
@@ -82,3 +92,278 @@ void timer_init(TIM_TypeDef *TIMx)
     /* Enable Counter */
     TIMx->CR1 |= (uint32_t)(1 << TIM_CR1_CEN_Pos);
 }
+
+/*******************************************************************************
+* Function Name: timebase_init()
+********************************************************************************
+* Summary:
+*   Starts the free running timebase of get_time_us(), TIMEBASE_TIM_INST counts
+*   at 1 MHz over it's full 32-bit range and the overflow ISR extends it to
+*   64-bit. The prescaler is computed from the timer clock of the current RCC
+*   configuration. A running timebase is not restarted, so the time never goes
+*   back under it's users, ex: timestamp_get().
+*
+* Parameters:
+*   void
+*
+* Return :
+*   void
+*
+*******************************************************************************/
+void timebase_init(void)
+{
+    general_timer_configs_t tim_configs = {
+        .count_direction = 0,
+        .auto_reload_preload_enable = 0,
+        .repetition_counter = 0,
+        .prescaler = 0,
+        .clock_division = 0,
+        .period = 0xFFFFFFFFU,
+    };
+
+    if (timebase_is_running())
+    {
+        return;
+    }
+
+    NVIC_DisableIRQ(TIMEBASE_TIM_IRQn);
+
+    tim_configs.prescaler = (uint16_t)((get_timer_clock(TIMEBASE_TIM_INST) / TIMEBASE_TICK_HZ) - 1U);
+    general_timer_config(TIMEBASE_TIM_INST, &tim_configs);
+
+    /* Load the prescaler now, the update event also sets UIF which is cleared */
+    TIMEBASE_TIM_INST->EGR = TIM_EGR_UG_Msk;
+    TIMEBASE_TIM_INST->CNT = 0;
+    TIMEBASE_TIM_INST->SR = (uint32_t)(~TIM_SR_UIF_Msk);
+    timebase_high = 0;
+
+    TIMEBASE_TIM_INST->DIER |= TIM_DIER_UIE_Msk;
+
+    NVIC_ClearPendingIRQ(TIMEBASE_TIM_IRQn);
+    NVIC_SetPriority(TIMEBASE_TIM_IRQn, TIMEBASE_IRQ_PRIORITY);
+    NVIC_EnableIRQ(TIMEBASE_TIM_IRQn);
+
+    timer_init(TIMEBASE_TIM_INST);
+}
+
+/*******************************************************************************
+* Function Name: timebase_compare_register()
+********************************************************************************
+* Summary:
+*   Registers the callback of the timebase compare, called from the timebase
+*   ISR at TIMEBASE_IRQ_PRIORITY.
+*
+* Parameters:
+*   compare_cb:      Callback on the compare match, NULL to remove it
+*
+* Return :
+*   void
+*
+*******************************************************************************/
+void timebase_compare_register(timebase_compare_cb_t compare_cb)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    timebase_compare_cb = compare_cb;
+    __set_PRIMASK(primask);
+}
+
+/*******************************************************************************
+* Function Name: timebase_compare_set()
+********************************************************************************
+* Summary:
+*   Arms the compare channel 1 of the timebase timer to interrupt at the
+*   specified time, a time already passed interrupts right away. The channel
+*   compares the lower 32 bits of the time only, a time more than 2^32 us away
+*   interrupts early and should be armed again from the callback.
+*
+* Parameters:
+*   time_us:         Time of the interrupt, in the get_time_us() timebase
+*
+* Return :
+*   void
+*
+*******************************************************************************/
+void timebase_compare_set(uint64_t time_us)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    /* DIER is shared with the wakeup, which is disarmed in the ISR */
+    __disable_irq();
+
+    TIMEBASE_TIM_INST->DIER &= (uint32_t)(~TIM_DIER_CC1IE_Msk);
+
+    TIMEBASE_TIM_INST->CCR1 = (uint32_t)time_us;
+    TIMEBASE_TIM_INST->SR = (uint32_t)(~TIM_SR_CC1IF_Msk);
+    TIMEBASE_TIM_INST->DIER |= TIM_DIER_CC1IE_Msk;
+
+    /* The counter may have passed the compare value before it was written */
+    if (get_time_us() >= time_us)
+    {
+        TIMEBASE_TIM_INST->EGR = TIM_EGR_CC1G_Msk;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/*******************************************************************************
+* Function Name: timebase_compare_stop()
+********************************************************************************
+* Summary:
+*   Disarms the compare interrupt of the timebase.
+*
+* Parameters:
+*   void
+*
+* Return :
+*   void
+*
+*******************************************************************************/
+void timebase_compare_stop(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    TIMEBASE_TIM_INST->DIER &= (uint32_t)(~TIM_DIER_CC1IE_Msk);
+    TIMEBASE_TIM_INST->SR = (uint32_t)(~TIM_SR_CC1IF_Msk);
+    __set_PRIMASK(primask);
+}
+
+/*******************************************************************************
+* Function Name: timebase_wakeup_set()
+********************************************************************************
+* Summary:
+*   Arms a one shot interrupt of the compare channel 2 of the timebase timer at
+*   the specified time, to wake up the core from WFI. The interrupt only clears
+*   and disarms itself, a time already passed interrupts right away. The lower
+*   32 bits of the time are compared, as in timebase_compare_set().
+*
+* Parameters:
+*   time_us:         Time of the wakeup, in the get_time_us() timebase
+*
+* Return :
+*   void
+*
+*******************************************************************************/
+void timebase_wakeup_set(uint64_t time_us)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    /* DIER is also changed by the compare callback in the ISR */
+    __disable_irq();
+
+    TIMEBASE_TIM_INST->DIER &= (uint32_t)(~TIM_DIER_CC2IE_Msk);
+    TIMEBASE_TIM_INST->CCR2 = (uint32_t)time_us;
+    TIMEBASE_TIM_INST->SR = (uint32_t)(~TIM_SR_CC2IF_Msk);
+    TIMEBASE_TIM_INST->DIER |= TIM_DIER_CC2IE_Msk;
+
+    if (get_time_us() >= time_us)
+    {
+        TIMEBASE_TIM_INST->EGR = TIM_EGR_CC2G_Msk;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/*******************************************************************************
+* Function Name: timebase_tick_start()
+********************************************************************************
+* Summary:
+*   Starts a periodic tick on the compare channel 3 of the timebase timer, the
+*   callback is called from the timebase ISR every period, the first one a
+*   period from now. Starting it again replaces the callback and the period.
+*
+* Parameters:
+*   tick_cb:         Callback on every tick
+*   period_us:       Period of the tick in us, non-zero
+*
+* Return :
+*   void
+*
+*******************************************************************************/
+void timebase_tick_start(timebase_tick_cb_t tick_cb, uint32_t period_us)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    /* DIER is also changed by the compare callback in the ISR */
+    __disable_irq();
+
+    TIMEBASE_TIM_INST->DIER &= (uint32_t)(~TIM_DIER_CC3IE_Msk);
+
+    timebase_tick_cb = tick_cb;
+    timebase_tick_period = period_us;
+
+    TIMEBASE_TIM_INST->CCR3 = TIMEBASE_TIM_INST->CNT + period_us;
+    TIMEBASE_TIM_INST->SR = (uint32_t)(~TIM_SR_CC3IF_Msk);
+    TIMEBASE_TIM_INST->DIER |= TIM_DIER_CC3IE_Msk;
+
+    __set_PRIMASK(primask);
+}
+
+/*******************************************************************************
+* Function Name: TIMEBASE_TIM_IRQHandler()
+********************************************************************************
+* Summary:
+*   ISR of the timebase. The overflow counts the upper 32 bits, the flag is
+*   cleared and the count is updated with IRQs masked, so that a reader in a
+*   higher priority ISR never sees both or neither of them for a wrap. The
+*   overflow is served first so the time is current in the compare callback.
+*
+*******************************************************************************/
+void TIMEBASE_TIM_IRQHandler(void)
+{
+    uint32_t primask = 0;
+
+    if (TIMEBASE_TIM_INST->SR & TIM_SR_UIF_Msk)
+    {
+        primask = __get_PRIMASK();
+        __disable_irq();
+
+        TIMEBASE_TIM_INST->SR = (uint32_t)(~TIM_SR_UIF_Msk);
+        timebase_high++;
+
+        __set_PRIMASK(primask);
+    }
+
+    if ((TIMEBASE_TIM_INST->DIER & TIM_DIER_CC1IE_Msk) &&
+        (TIMEBASE_TIM_INST->SR & TIM_SR_CC1IF_Msk))
+    {
+        TIMEBASE_TIM_INST->SR = (uint32_t)(~TIM_SR_CC1IF_Msk);
+
+        if (NULL != timebase_compare_cb)
+        {
+            timebase_compare_cb();
+        }
+    }
+
+    /* Wakeup of a sleep delay, the delay itself checks the time */
+    if ((TIMEBASE_TIM_INST->DIER & TIM_DIER_CC2IE_Msk) &&
+        (TIMEBASE_TIM_INST->SR & TIM_SR_CC2IF_Msk))
+    {
+        TIMEBASE_TIM_INST->DIER &= (uint32_t)(~TIM_DIER_CC2IE_Msk);
+        TIMEBASE_TIM_INST->SR = (uint32_t)(~TIM_SR_CC2IF_Msk);
+    }
+
+    /* Periodic tick, the next compare is a period after the last one, or a
+     * period from now if the ISR was held off past it
+     */
+    if ((TIMEBASE_TIM_INST->DIER & TIM_DIER_CC3IE_Msk) &&
+        (TIMEBASE_TIM_INST->SR & TIM_SR_CC3IF_Msk))
+    {
+        TIMEBASE_TIM_INST->SR = (uint32_t)(~TIM_SR_CC3IF_Msk);
+
+        TIMEBASE_TIM_INST->CCR3 += timebase_tick_period;
+        if ((TIMEBASE_TIM_INST->CCR3 - TIMEBASE_TIM_INST->CNT) > timebase_tick_period)
+        {
+            TIMEBASE_TIM_INST->CCR3 = TIMEBASE_TIM_INST->CNT + timebase_tick_period;
+        }
+
+        if (NULL != timebase_tick_cb)
+        {
+            timebase_tick_cb();
+        }
+    }
+}
+
+/* End of File */
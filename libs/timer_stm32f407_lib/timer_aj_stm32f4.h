@@ -17,6 +17,30 @@
 #include "stm32f407xx.h"
 #endif  /* __STM32F407xx_H */
 
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* 32-bit timer of the 1 MHz timebase of get_time_us(), TIM5 or TIM2. TIM2 is
+ * free when the delay lib uses it's DWT backend.
+ */
+#ifndef TIMEBASE_TIM_INST
+#define TIMEBASE_TIM_INST                   (TIM5)
+#define TIMEBASE_TIM_IRQn                   (TIM5_IRQn)
+#define TIMEBASE_TIM_IRQHandler             TIM5_IRQHandler
+#endif
+
+/* Counting rate of the timebase */
+#define TIMEBASE_TICK_HZ                    (1000000U)
+
+/* Priority of the timebase interrupt, the overflow takes a few cycles, the
+ * compare callback runs at this priority too, ex: the timer wheel callbacks.
+ * The compare channel 1 is the callback compare, channel 2 is the wakeup of
+ * the sleep delays, channel 3 is the periodic tick.
+ */
+#ifndef TIMEBASE_IRQ_PRIORITY
+#define TIMEBASE_IRQ_PRIORITY               (4U)
+#endif
+
 /*******************************************************************************
 * Global Variables
 *******************************************************************************/
@@ -29,10 +53,69 @@ typedef struct general_timer_configs_t{
     uint32_t period;
 }general_timer_configs_t;
 
+/* Called from the timebase ISR on the compare match of timebase_compare_set() */
+typedef void (*timebase_compare_cb_t)(void);
+
+/* Called from the timebase ISR on every tick of timebase_tick_start() */
+typedef void (*timebase_tick_cb_t)(void);
+
+/* Upper 32 bits of the timebase, counted by the overflow ISR */
+extern volatile uint32_t timebase_high;
+
 /*******************************************************************************
 * Function Prototypes
 *******************************************************************************/
 void general_timer_config(TIM_TypeDef *TIMx, general_timer_configs_t *tim_config);
 void timer_init(TIM_TypeDef *TIMx);
+void timebase_init(void);
+void timebase_compare_register(timebase_compare_cb_t compare_cb);
+void timebase_compare_set(uint64_t time_us);
+void timebase_compare_stop(void);
+void timebase_wakeup_set(uint64_t time_us);
+void timebase_tick_start(timebase_tick_cb_t tick_cb, uint32_t period_us);
+
+/*******************************************************************************
+* Function Name: timebase_is_running()
+********************************************************************************
+* Summary:
+*   Returns true if the timebase is started with timebase_init().
+*
+*******************************************************************************/
+static __inline bool timebase_is_running(void)
+{
+    return (0U != (TIMEBASE_TIM_INST->CR1 & TIM_CR1_CEN_Msk));
+}
+
+/*******************************************************************************
+* Function Name: get_time_us()
+********************************************************************************
+* Summary:
+*   Returns the time in us since timebase_init(), monotonic and 64-bit so it
+*   never wraps. Lock-free, can be called from thread and ISRs of any priority
+*   and with IRQs masked. The upper half is read before and after the counter,
+*   the read is repeated if the overflow ISR ran in between. A wrap not yet
+*   counted by the ISR, as it is masked or pre-empted by the caller, is taken
+*   from the pending update flag.
+*
+*******************************************************************************/
+static __inline uint64_t get_time_us(void)
+{
+    uint32_t high = 0, cnt = 0, sr = 0;
+
+    do
+    {
+        high = timebase_high;
+        cnt = TIMEBASE_TIM_INST->CNT;
+        sr = TIMEBASE_TIM_INST->SR;
+    } while (high != timebase_high);
+
+    /* The flag can be set just after a counter read before the wrap */
+    if ((sr & TIM_SR_UIF_Msk) && (cnt < 0x80000000U))
+    {
+        high++;
+    }
+
+    return (((uint64_t)high << 32) | cnt);
+}
 
 #endif  /* GPIO_AJ_STM32F4 */
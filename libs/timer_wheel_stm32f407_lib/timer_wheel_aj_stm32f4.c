@@ -0,0 +1,384 @@
+/*******************************************************************************
+ * File Name: timer_wheel_aj_stm32f4.c
+ *
+ * Description:
+ * The file contains function definition(s) for the hierarchical timer wheel.
+ *
+ * A timer at level L with slot d has an expiry with the same digits as the
+ * wheel time above L and the digit d > the digit L of the wheel time (d >= at
+ * level 0). So the slots of a level are reached in bitmap order, and the first
+ * event of the wheel is in the lowest non-empty level: an expiry at level 0,
+ * or the move of a slot down at the other levels.
+ *
+ * The wheel is not locked, the caller serializes the calls on a wheel.
+ *
+ * Related Document: See README.md
+ *
+ *******************************************************************************/
+#include "timer_wheel_aj_stm32f4.h"
+
+/*******************************************************************************
+ * Function Name: timer_wheel_ctz64()
+ ********************************************************************************
+ * Summary:
+ *   Returns the index of the lowest set bit of a non-zero value. The 32-bit
+ *   search is a de Bruijn multiply, so there is no loop and no compiler
+ *   intrinsic.
+ *
+ *******************************************************************************/
+static uint32_t timer_wheel_ctz64(uint64_t val)
+{
+    static const uint8_t debruijn_idx[32] = {
+        0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+        31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9,
+    };
+    uint32_t low = (uint32_t)val;
+    uint32_t base = 0;
+
+    if (0U == low)
+    {
+        low = (uint32_t)(val >> 32);
+        base = 32U;
+    }
+
+    return base + debruijn_idx[((low & (0U - low)) * 0x077CB531U) >> 27];
+}
+
+/*******************************************************************************
+ * Function Name: timer_wheel_level_of()
+ ********************************************************************************
+ * Summary:
+ *   Returns the level of an expiry, the highest 6-bit digit in which it differs
+ *   from the wheel time, 0 if they are equal.
+ *
+ *******************************************************************************/
+static uint32_t timer_wheel_level_of(uint64_t expiry, uint64_t now)
+{
+    uint64_t diff = expiry ^ now;
+    uint32_t level = 0;
+
+    /* Halve the search range of the top set bit, then find it's digit */
+    if (diff >> 36)
+    {
+        diff >>= 36;
+        level = 6U;
+    }
+    if (diff >> 18)
+    {
+        diff >>= 18;
+        level += 3U;
+    }
+    while (diff >> TIMER_WHEEL_LEVEL_BITS)
+    {
+        diff >>= TIMER_WHEEL_LEVEL_BITS;
+        level++;
+    }
+
+    return level;
+}
+
+/*******************************************************************************
+ * Function Name: timer_wheel_slot_time()
+ ********************************************************************************
+ * Summary:
+ *   Returns the time at which a slot of a level is reached, the wheel time with
+ *   the digit of the level replaced by the slot and the lower digits cleared.
+ *
+ *******************************************************************************/
+static uint64_t timer_wheel_slot_time(uint64_t now, uint32_t level, uint32_t slot)
+{
+    uint32_t shift = level * TIMER_WHEEL_LEVEL_BITS;
+    uint64_t above = 0;
+
+    /* Digits above the level, none for the top level */
+    if ((shift + TIMER_WHEEL_LEVEL_BITS) < 64U)
+    {
+        above = now & ~((((uint64_t)1) << (shift + TIMER_WHEEL_LEVEL_BITS)) - 1U);
+    }
+
+    return above | ((uint64_t)slot << shift);
+}
+
+/*******************************************************************************
+ * Function Name: timer_wheel_link()
+ ********************************************************************************
+ * Summary:
+ *   Links a timer into the slot of it's expiry.
+ *
+ *******************************************************************************/
+static void timer_wheel_link(timer_wheel_st_t *wheel, timer_wheel_timer_st_t *tmr)
+{
+    uint32_t level = timer_wheel_level_of(tmr->expiry, wheel->now);
+    uint32_t slot = (uint32_t)(tmr->expiry >> (level * TIMER_WHEEL_LEVEL_BITS)) &
+                    TIMER_WHEEL_SLOT_MASK;
+    timer_wheel_timer_st_t **head = &wheel->slots[level][slot];
+
+    tmr->level = (uint8_t)level;
+    tmr->slot = (uint8_t)slot;
+
+    tmr->next = *head;
+    if (NULL != tmr->next)
+    {
+        tmr->next->pprev = &tmr->next;
+    }
+    tmr->pprev = head;
+    *head = tmr;
+
+    wheel->bitmap[level] |= ((uint64_t)1 << slot);
+}
+
+/*******************************************************************************
+ * Function Name: timer_wheel_unlink()
+ ********************************************************************************
+ * Summary:
+ *   Unlinks a running timer from it's slot, the bit of the slot is cleared once
+ *   the slot is empty.
+ *
+ *******************************************************************************/
+static void timer_wheel_unlink(timer_wheel_st_t *wheel, timer_wheel_timer_st_t *tmr)
+{
+    *tmr->pprev = tmr->next;
+    if (NULL != tmr->next)
+    {
+        tmr->next->pprev = tmr->pprev;
+    }
+
+    tmr->next = NULL;
+    tmr->pprev = NULL;
+
+    if (NULL == wheel->slots[tmr->level][tmr->slot])
+    {
+        wheel->bitmap[tmr->level] &= ~((uint64_t)1 << tmr->slot);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: timer_wheel_init()
+ ********************************************************************************
+ * Summary:
+ *   Initializes an empty wheel at the specified time.
+ *
+ * Parameters:
+ *   wheel:          Pointer to the wheel
+ *   now:            Current time in ticks
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+void timer_wheel_init(timer_wheel_st_t *wheel, uint64_t now)
+{
+    uint32_t level = 0, slot = 0;
+
+    wheel->now = now;
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        wheel->bitmap[level] = 0;
+
+        for (slot = 0; slot < TIMER_WHEEL_SLOTS; slot++)
+        {
+            wheel->slots[level][slot] = NULL;
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: timer_wheel_timer_init()
+ ********************************************************************************
+ * Summary:
+ *   Initializes a timer with it's expiry callback, the timer is not running.
+ *
+ * Parameters:
+ *   tmr:            Pointer to the timer
+ *   cb:             Called when the timer expires
+ *   cb_arg:         Argument passed to the callback
+ *
+ * Return :
+ *   timer_wheel_status_e_t:   TIMER_WHEEL_STATUS_BAD_PARAM if the callback is NULL
+ *
+ *******************************************************************************/
+timer_wheel_status_e_t timer_wheel_timer_init(timer_wheel_timer_st_t *tmr, timer_wheel_cb_t cb,
+                                              void *cb_arg)
+{
+    if ((NULL == tmr) || (NULL == cb))
+    {
+        return TIMER_WHEEL_STATUS_BAD_PARAM;
+    }
+
+    tmr->next = NULL;
+    tmr->pprev = NULL;
+    tmr->expiry = 0;
+    tmr->cb = cb;
+    tmr->cb_arg = cb_arg;
+    tmr->level = 0;
+    tmr->slot = 0;
+
+    return TIMER_WHEEL_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: timer_wheel_start()
+ ********************************************************************************
+ * Summary:
+ *   Starts the timer to expire at the specified time, a running timer is
+ *   restarted. An expiry not later than the wheel time expires on the next
+ *   timer_wheel_advance().
+ *
+ *   NOTE: A callback which restarts it's timer should use an expiry later than
+ *   the time passed to timer_wheel_advance(), else the timer expires again in
+ *   the same advance.
+ *
+ * Parameters:
+ *   wheel:          Pointer to the wheel
+ *   tmr:            Pointer to the timer, initialized with timer_wheel_timer_init()
+ *   expiry:         Expiry time in ticks
+ *
+ * Return :
+ *   timer_wheel_status_e_t:   Status of the operation
+ *
+ *******************************************************************************/
+timer_wheel_status_e_t timer_wheel_start(timer_wheel_st_t *wheel, timer_wheel_timer_st_t *tmr,
+                                         uint64_t expiry)
+{
+    if ((NULL == wheel) || (NULL == tmr) || (NULL == tmr->cb))
+    {
+        return TIMER_WHEEL_STATUS_BAD_PARAM;
+    }
+
+    if (timer_wheel_is_running(tmr))
+    {
+        timer_wheel_unlink(wheel, tmr);
+    }
+
+    tmr->expiry = (expiry > wheel->now) ? (expiry) : (wheel->now);
+    timer_wheel_link(wheel, tmr);
+
+    return TIMER_WHEEL_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: timer_wheel_stop()
+ ********************************************************************************
+ * Summary:
+ *   Stops the timer, nothing is done if it is not running.
+ *
+ * Parameters:
+ *   wheel:          Pointer to the wheel
+ *   tmr:            Pointer to the timer
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+void timer_wheel_stop(timer_wheel_st_t *wheel, timer_wheel_timer_st_t *tmr)
+{
+    if ((NULL != tmr) && timer_wheel_is_running(tmr))
+    {
+        timer_wheel_unlink(wheel, tmr);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: timer_wheel_advance()
+ ********************************************************************************
+ * Summary:
+ *   Advances the wheel to the specified time, the slots reached on the way are
+ *   moved down a level, and the timers which expire are stopped and their
+ *   callbacks are called in the order of expiry. Only the events are visited,
+ *   the time between them is skipped.
+ *
+ * Parameters:
+ *   wheel:          Pointer to the wheel
+ *   now:            Current time in ticks, an earlier time than the wheel time
+ *                   is ignored
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+void timer_wheel_advance(timer_wheel_st_t *wheel, uint64_t now)
+{
+    timer_wheel_timer_st_t *tmr = NULL;
+    uint64_t event = 0;
+    uint32_t level = 0, slot = 0;
+
+    if (now < wheel->now)
+    {
+        return;
+    }
+
+    while (true)
+    {
+        for (level = 0; (level < TIMER_WHEEL_LEVELS) && (0U == wheel->bitmap[level]); level++)
+            ;
+
+        if (level >= TIMER_WHEEL_LEVELS)
+        {
+            break;
+        }
+
+        slot = timer_wheel_ctz64(wheel->bitmap[level]);
+        event = timer_wheel_slot_time(wheel->now, level, slot);
+
+        if (event > now)
+        {
+            break;
+        }
+
+        wheel->now = event;
+
+        /* One timer at a time, the callbacks may start and stop timers */
+        while (NULL != (tmr = wheel->slots[level][slot]))
+        {
+            timer_wheel_unlink(wheel, tmr);
+
+            if (0U == level)
+            {
+                tmr->cb(tmr, tmr->cb_arg);
+            }
+            else
+            {
+                /* Lands in a lower level, the expiry is not before the slot time */
+                timer_wheel_link(wheel, tmr);
+            }
+        }
+    }
+
+    wheel->now = now;
+}
+
+/*******************************************************************************
+ * Function Name: timer_wheel_next()
+ ********************************************************************************
+ * Summary:
+ *   Returns the time of the next event of the wheel, at which
+ *   timer_wheel_advance() should be called. It is the next expiry, or an
+ *   earlier time at which a slot of a higher level is moved down.
+ *
+ * Parameters:
+ *   wheel:          Pointer to the wheel
+ *   next:           Returns the time of the next event in ticks
+ *
+ * Return :
+ *   bool:           false if no timer is running
+ *
+ *******************************************************************************/
+bool timer_wheel_next(timer_wheel_st_t *wheel, uint64_t *next)
+{
+    uint32_t level = 0;
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        if (0U != wheel->bitmap[level])
+        {
+            *next = timer_wheel_slot_time(wheel->now, level,
+                                          timer_wheel_ctz64(wheel->bitmap[level]));
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* End of File */
@@ -0,0 +1,109 @@
+/*******************************************************************************
+* File Name: timer_wheel_aj_stm32f4.h
+*
+* Description:
+* The file contains function declaration(s) for the hierarchical timer wheel,
+* which runs any number of software timers from a single hardware compare.
+*
+* The wheel has TIMER_WHEEL_LEVELS levels of 64 slots, each level covers 64
+* times the span of the level below it. A timer is placed at the level of the
+* highest 6-bit digit in which it's expiry differs from the current time, and
+* is moved down a level when the time reaches it's slot, so it is moved at most
+* once per level. Each level has a bitmap of it's non-empty slots, the next
+* event is found from the lowest non-empty level without scanning the slots.
+* Start, stop and expiry are O(1).
+*
+* The module is plain C with no device dependency, the time is a 64-bit tick
+* count supplied by the caller, so the same files build on a Linux host with a
+* simulated clock. See timer_wheel_port_aj_stm32f4.h for the timer wheel on
+* the get_time_us() timebase.
+*
+* Related Document: See README.md
+*
+*******************************************************************************/
+#ifndef TIMER_WHEEL_AJ_STM32F4
+#define TIMER_WHEEL_AJ_STM32F4
+
+/*******************************************************************************
+* Header Files
+*******************************************************************************/
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* Slots per level, one bit of the 64-bit level bitmap per slot */
+#define TIMER_WHEEL_LEVEL_BITS              (6U)
+#define TIMER_WHEEL_SLOTS                   (1U << TIMER_WHEEL_LEVEL_BITS)
+#define TIMER_WHEEL_SLOT_MASK               (TIMER_WHEEL_SLOTS - 1U)
+
+/* Levels covering the full 64-bit tick count */
+#define TIMER_WHEEL_LEVELS                  ((64U + TIMER_WHEEL_LEVEL_BITS - 1U) / TIMER_WHEEL_LEVEL_BITS)
+
+/*******************************************************************************
+* Global Variables
+*******************************************************************************/
+typedef enum timer_wheel_status_e
+{
+    TIMER_WHEEL_STATUS_SUCCESS,
+    TIMER_WHEEL_STATUS_BAD_PARAM,
+} timer_wheel_status_e_t;
+
+typedef struct timer_wheel_timer_st timer_wheel_timer_st_t;
+
+/* Called by timer_wheel_advance() when the timer expires, the timer is
+ * stopped before the call and can be started again from the callback.
+ */
+typedef void (*timer_wheel_cb_t)(timer_wheel_timer_st_t *tmr, void *cb_arg);
+
+/* Software timer, owned by the caller and linked into a slot while running */
+struct timer_wheel_timer_st
+{
+    timer_wheel_timer_st_t *next;
+    timer_wheel_timer_st_t **pprev;     /* NULL when the timer is not running */
+    uint64_t expiry;
+    timer_wheel_cb_t cb;
+    void *cb_arg;
+    uint8_t level;
+    uint8_t slot;
+};
+
+typedef struct timer_wheel_st
+{
+    uint64_t now;                       /* Time the wheel is advanced to */
+    uint64_t bitmap[TIMER_WHEEL_LEVELS];
+    timer_wheel_timer_st_t *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+} timer_wheel_st_t;
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+void timer_wheel_init(timer_wheel_st_t *wheel, uint64_t now);
+
+timer_wheel_status_e_t timer_wheel_timer_init(timer_wheel_timer_st_t *tmr, timer_wheel_cb_t cb,
+                                              void *cb_arg);
+
+timer_wheel_status_e_t timer_wheel_start(timer_wheel_st_t *wheel, timer_wheel_timer_st_t *tmr,
+                                         uint64_t expiry);
+
+void timer_wheel_stop(timer_wheel_st_t *wheel, timer_wheel_timer_st_t *tmr);
+
+void timer_wheel_advance(timer_wheel_st_t *wheel, uint64_t now);
+
+bool timer_wheel_next(timer_wheel_st_t *wheel, uint64_t *next);
+
+/*******************************************************************************
+* Function Name: timer_wheel_is_running()
+********************************************************************************
+* Summary:
+*   Returns true if the timer is started and not yet expired or stopped.
+*
+*******************************************************************************/
+static __inline bool timer_wheel_is_running(const timer_wheel_timer_st_t *tmr)
+{
+    return (NULL != tmr->pprev);
+}
+
+#endif /* TIMER_WHEEL_AJ_STM32F4 */
@@ -0,0 +1,143 @@
+/*******************************************************************************
+ * File Name: timer_wheel_port_aj_stm32f4.c
+ *
+ * Description:
+ * The file contains function definition(s) for the timer wheel on the 1 MHz
+ * get_time_us() timebase.
+ *
+ * Related Document: See README.md
+ *
+ *******************************************************************************/
+#include "timer_wheel_port_aj_stm32f4.h"
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+static timer_wheel_st_t timer_wheel_sys;
+
+/*******************************************************************************
+ * Function Name: timer_wheel_port_arm()
+ ********************************************************************************
+ * Summary:
+ *   Arms the timebase compare to the next event of the wheel, or stops it if
+ *   no timer is running. Called with IRQs masked or from the timebase ISR.
+ *
+ *******************************************************************************/
+static void timer_wheel_port_arm(void)
+{
+    uint64_t next = 0;
+
+    if (timer_wheel_next(&timer_wheel_sys, &next))
+    {
+        timebase_compare_set(next);
+    }
+    else
+    {
+        timebase_compare_stop();
+    }
+}
+
+/*******************************************************************************
+ * Function Name: timer_wheel_port_compare_cb()
+ ********************************************************************************
+ * Summary:
+ *   Timebase compare callback, advances the wheel to the current time, which
+ *   calls the callbacks of the expired timers, and arms the next event. An
+ *   event which passed meanwhile interrupts again right away. IRQs are not
+ *   masked here, the wheel is only changed by callers which can't pre-empt
+ *   the timebase ISR.
+ *
+ *******************************************************************************/
+static void timer_wheel_port_compare_cb(void)
+{
+    timer_wheel_advance(&timer_wheel_sys, get_time_us());
+    timer_wheel_port_arm();
+}
+
+/*******************************************************************************
+ * Function Name: timer_wheel_port_init()
+ ********************************************************************************
+ * Summary:
+ *   Initializes the timer wheel at the current time, the timebase should be
+ *   started already with timebase_init().
+ *
+ * Parameters:
+ *   void
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+void timer_wheel_port_init(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+
+    timebase_compare_stop();
+    timer_wheel_init(&timer_wheel_sys, get_time_us());
+    timebase_compare_register(timer_wheel_port_compare_cb);
+
+    __set_PRIMASK(primask);
+}
+
+/*******************************************************************************
+ * Function Name: timer_wheel_port_start()
+ ********************************************************************************
+ * Summary:
+ *   Starts the timer to expire after the specified time from now, a running
+ *   timer is restarted. Can be called from thread, timer callbacks and ISRs
+ *   with priority lower or equal to TIMEBASE_IRQ_PRIORITY.
+ *
+ * Parameters:
+ *   tmr:            Pointer to the timer, initialized with timer_wheel_timer_init()
+ *   timeout_us:     Time till the expiry in us
+ *
+ * Return :
+ *   timer_wheel_status_e_t:   Status of the operation
+ *
+ *******************************************************************************/
+timer_wheel_status_e_t timer_wheel_port_start(timer_wheel_timer_st_t *tmr, uint64_t timeout_us)
+{
+    timer_wheel_status_e_t status = TIMER_WHEEL_STATUS_SUCCESS;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+
+    status = timer_wheel_start(&timer_wheel_sys, tmr, get_time_us() + timeout_us);
+    if (TIMER_WHEEL_STATUS_SUCCESS == status)
+    {
+        timer_wheel_port_arm();
+    }
+
+    __set_PRIMASK(primask);
+
+    return status;
+}
+
+/*******************************************************************************
+ * Function Name: timer_wheel_port_stop()
+ ********************************************************************************
+ * Summary:
+ *   Stops the timer, nothing is done if it is not running. Can be called from
+ *   thread, timer callbacks and ISRs with priority lower or equal to
+ *   TIMEBASE_IRQ_PRIORITY. The compare is left armed, an event with no expired
+ *   timer only advances the wheel.
+ *
+ * Parameters:
+ *   tmr:            Pointer to the timer
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+void timer_wheel_port_stop(timer_wheel_timer_st_t *tmr)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    timer_wheel_stop(&timer_wheel_sys, tmr);
+    __set_PRIMASK(primask);
+}
+
+/* End of File */
@@ -0,0 +1,39 @@
+/*******************************************************************************
+* File Name: timer_wheel_port_aj_stm32f4.h
+*
+* Description:
+* The file contains function declaration(s) for the timer wheel on the 1 MHz
+* get_time_us() timebase. The wheel is driven by the compare channel 1 of the
+* timebase timer, armed to the next event of the wheel, so there is no
+* periodic tick. The timer callbacks are called from the timebase ISR at
+* TIMEBASE_IRQ_PRIORITY, the timers should not be started or stopped from ISRs
+* of a higher priority.
+*
+* Related Document: See README.md
+*
+*******************************************************************************/
+#ifndef TIMER_WHEEL_PORT_AJ_STM32F4
+#define TIMER_WHEEL_PORT_AJ_STM32F4
+
+/*******************************************************************************
+* Header Files
+*******************************************************************************/
+#include "stm32f4xx.h"
+
+#ifdef  __STM32F407xx_H
+#include "stm32f407xx.h"
+#endif  /* __STM32F407xx_H */
+
+#include "timer_aj_stm32f4.h"
+#include "timer_wheel_aj_stm32f4.h"
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+void timer_wheel_port_init(void);
+
+timer_wheel_status_e_t timer_wheel_port_start(timer_wheel_timer_st_t *tmr, uint64_t timeout_us);
+
+void timer_wheel_port_stop(timer_wheel_timer_st_t *tmr);
+
+#endif /* TIMER_WHEEL_PORT_AJ_STM32F4 */
@@ -7,8 +7,161 @@
  * Related Document: See README.md
  *
  *******************************************************************************/
+#include <string.h>
 #include "usart_aj_stm32f4.h"
 
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+/* Fixed hardware resources of each USART/UART instance, DMA request mapping
+ * is from the DMA1/DMA2 request mapping tables of the reference manual.
+ */
+typedef struct usart_hw_map_st
+{
+    USART_TypeDef *instance;
+    IRQn_Type irqn;
+    DMA_Stream_TypeDef *dma_tx_stream;
+    uint8_t dma_tx_channel;
+    DMA_Stream_TypeDef *dma_rx_stream;
+    uint8_t dma_rx_channel;
+} usart_hw_map_st_t;
+
+/* Handler of a USART interrupt event, cb_arg is passed back to the callback */
+typedef struct usart_event_handler_st
+{
+    usart_event_cb_t cb;
+    void *cb_arg;
+} usart_event_handler_st_t;
+
+/* DMA Tx job, a list of segments sent back-to-back. A single buffer is kept
+ * in seg, with iov pointing to it.
+ */
+typedef struct usart_dma_tx_job_st
+{
+    const uart_iovec_st_t *iov;
+    uart_iovec_st_t seg;
+    uint8_t iov_cnt;
+} usart_dma_tx_job_st_t;
+
+/* Run-time state of each USART/UART instance, statically allocated, one per
+ * instance in the order of usart_hw_map.
+ */
+typedef struct usart_ctx_st
+{
+    usart_config_st_t *usart_cfg;
+    usart_event_handler_st_t event[USART_EVENT_NUM];
+    uart_dma_tx_cb_t dma_tx_cb;
+    usart_dma_tx_job_st_t dma_tx_job;
+    usart_dma_tx_job_st_t dma_tx_pend_job;
+    uint8_t dma_tx_seg_idx;
+    volatile bool dma_tx_busy;
+    volatile bool dma_tx_pend;
+    bool dma_tx_ready;
+    uart_rx_dma_cb_t dma_rx_cb;
+    uint8_t *dma_rx_ring;
+    uint16_t dma_rx_ring_size;
+    uint16_t dma_rx_read_pos;
+    uint32_t dma_rx_err_cnt;
+    uart_ring_st_t tx_ring;
+    volatile bool tx_idle;
+    uart_tx_idle_cb_t tx_idle_cb;
+    uart_ring_st_t rx_ring;
+    uart_rx_stats_st_t rx_stats;
+    uint16_t rx_flow_stop_lvl;
+    uint16_t rx_flow_resume_lvl;
+    bool rx_flow_ctrl;
+    volatile bool rx_flow_stopped;
+} usart_ctx_st_t;
+
+static const usart_hw_map_st_t usart_hw_map[USART_INST_NUM] = {
+    {USART1, USART1_IRQn, DMA2_Stream7, 4U, DMA2_Stream2, 4U},
+    {USART2, USART2_IRQn, DMA1_Stream6, 4U, DMA1_Stream5, 4U},
+    {USART3, USART3_IRQn, DMA1_Stream3, 4U, DMA1_Stream1, 4U},
+    {UART4,  UART4_IRQn,  DMA1_Stream4, 4U, DMA1_Stream2, 4U},
+    {UART5,  UART5_IRQn,  DMA1_Stream7, 4U, DMA1_Stream0, 4U},
+    {USART6, USART6_IRQn, DMA2_Stream6, 5U, DMA2_Stream1, 5U},
+};
+
+static usart_ctx_st_t usart_ctx[USART_INST_NUM];
+
+/* Index of the instance of a driver context */
+#define USART_CTX_IDX(ctx)                  ((uint32_t)((ctx) - usart_ctx))
+
+/*******************************************************************************
+ * Function Name: usart_get_inst_idx()
+ ********************************************************************************
+ * Summary:
+ *   Returns the index of the USART/UART instance in the usart_hw_map table.
+ *
+ * Parameters:
+ *   instance:      USART/UART instance
+ *
+ * Return :
+ *   int32_t:       Index of the instance, -1 if the instance is not valid.
+ *
+ *******************************************************************************/
+static int32_t usart_get_inst_idx(USART_TypeDef *instance)
+{
+    for (uint32_t i = 0; i < USART_INST_NUM; i++)
+    {
+        if (usart_hw_map[i].instance == instance)
+        {
+            return (int32_t)i;
+        }
+    }
+
+    return -1;
+}
+
+/*******************************************************************************
+ * Function Name: usart_get_clock()
+ ********************************************************************************
+ * Summary:
+ *   Returns the kernel clock of the USART/UART instance, USART1/6 are clocked
+ *   by APB2 and the others by APB1.
+ *
+ * Parameters:
+ *   instance:      USART/UART instance
+ *
+ * Return :
+ *   uint32_t:      Clock of the instance in Hz
+ *
+ *******************************************************************************/
+static uint32_t usart_get_clock(USART_TypeDef *instance)
+{
+    if ((USART1 == instance) || (USART6 == instance))
+    {
+        return get_apb2_clock();
+    }
+
+    return get_apb1_clock();
+}
+
+/*******************************************************************************
+ * Function Name: usart_cr1_modify()
+ ********************************************************************************
+ * Summary:
+ *   Read-modify-write of USART_CR1 from thread context, the interrupt enable
+ *   bits in CR1 are also modified by the ISR, hence done with IRQs masked.
+ *
+ * Parameters:
+ *   instance:       USART/UART instance
+ *   clr_msk:        Bits to clear
+ *   set_msk:        Bits to set
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void usart_cr1_modify(USART_TypeDef *instance, uint32_t clr_msk, uint32_t set_msk)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    instance->CR1 = (uint32_t)((instance->CR1 & (~clr_msk)) | set_msk);
+    __set_PRIMASK(primask);
+}
+
 /*******************************************************************************
  * Function Name: usart_config()
  ********************************************************************************
@@ -30,11 +183,35 @@ usart_status_e_t usart_config(usart_config_st_t *usart_cfg, GPIO_TypeDef *tx_GPI
                               uint8_t tx_gpio_pin, GPIO_TypeDef *rx_GPIOx, uint8_t rx_gpio_pin)
 {
     uint32_t tmp = 0;
-    float baud_usart_div = 0;
-    uint32_t baud_fractn = 0, baud_mantissa = 0;
-    uint32_t sys_clock = 0;
+    uint32_t usart_clock = 0, baud_brr = 0, baud_err_ppm = 0;
+    usart_status_e_t status = USART_STATUS_SUCCESS;
+
+    /* Check whether the usart instance is valid or not */
+    if (usart_get_inst_idx(usart_cfg->instance) < 0)
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    /* UART4/5 have no RTS/CTS lines */
+    if ((USART_FLOWCTRL_NONE != usart_cfg->hwflowctrl) &&
+        ((UART4 == usart_cfg->instance) || (UART5 == usart_cfg->instance)))
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
 
-    /* Check whether the usart instance is valid or not - TO DO */
+    usart_clock = usart_get_clock(usart_cfg->instance);
+
+    /* Reject baud rates which can't be generated, before touching the HW */
+    if (USART_COMPATIBLE_MODE_ASYNC == usart_cfg->compatmode ||
+        USART_COMPATIBLE_MODE_SYNC == usart_cfg->compatmode)
+    {
+        status = usart_calc_brr(usart_clock, usart_cfg->baudrate, usart_cfg->oversample,
+                                &baud_brr, &baud_err_ppm);
+        if (USART_STATUS_SUCCESS != status)
+        {
+            return status;
+        }
+    }
 
     /* Enable the USARTx/UARTx peripheral clock */
     if ((USART1 == usart_cfg->instance) || (USART6 == usart_cfg->instance))
@@ -180,39 +357,415 @@ usart_status_e_t usart_config(usart_config_st_t *usart_cfg, GPIO_TypeDef *tx_GPI
     /* Create the config data for USART_CR2 register */
     usart_cfg->instance->CR2 |= tmp;
 
-    sys_clock = get_systemcore_clock();
+    /* Program the RTS/CTS flow control, the usart_hwflowctrl_e_t values map
+     * directly to the RTSE and CTSE bits of USART_CR3 register.
+     */
+    usart_cfg->instance->CR3 = (uint32_t)((usart_cfg->instance->CR3 &
+                                           (~(USART_CR3_RTSE_Msk | USART_CR3_CTSE_Msk))) |
+                                          ((uint32_t)usart_cfg->hwflowctrl << USART_CR3_RTSE_Pos));
 
-    /* Calculate the fractional part and mantissa of the baud rate */
+    /* Program the calculated USART_DIV mantissa and fraction in BRR reg */
     if (USART_COMPATIBLE_MODE_ASYNC == usart_cfg->compatmode ||
         USART_COMPATIBLE_MODE_SYNC == usart_cfg->compatmode)
     {
-        baud_usart_div = ((sys_clock) / (usart_cfg->baudrate * 8 * (2 - usart_cfg->oversample)));
+        usart_cfg->instance->BRR = baud_brr;
+    }
 
-        if (USART_OVERSAMPLE_BY_16 == usart_cfg->oversample)
-        {
-            baud_fractn = (uint32_t)round((double)((baud_usart_div - (int)baud_usart_div) * 16));
-            baud_mantissa = (baud_fractn > 15U) ? (1U) : (0U);
-            baud_mantissa += (uint32_t)(baud_usart_div);
+    return USART_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: usart_gpio_af_config()
+ ********************************************************************************
+ * Summary:
+ *   Enables the GPIO port clock and sets the pin to the alternate function.
+ *
+ * Parameters:
+ *   GPIOx:          Pointer to GPIO port
+ *   gpio_pin:       GPIO pin
+ *   af_num:         Alternate function number, from the datasheet AF mapping
+ *   output:         true for an output pin, set to push-pull with max speed
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void usart_gpio_af_config(GPIO_TypeDef *GPIOx, uint8_t gpio_pin, uint32_t af_num,
+                                 bool output)
+{
+    uint32_t tmp = gpio_pin / 8;
+
+    RCC->AHB1ENR |= (uint32_t)((1U << (uint32_t)((GPIOx - GPIOA) / (GPIOB - GPIOA))));
+
+    GPIOx->MODER = (uint32_t)((GPIOx->MODER & (~(3U << (gpio_pin * 2)))) |
+                              (2U << (gpio_pin * 2)));
+
+    if (output)
+    {
+        GPIOx->OTYPER &= (uint32_t)(~(1U << gpio_pin));
+        GPIOx->OSPEEDR |= (uint32_t)(3U << (gpio_pin * 2));
+    }
+
+    /* No pull-up, pull-down enabled */
+    GPIOx->PUPDR &= (uint32_t)(~(3U << (gpio_pin * 2)));
+
+    GPIOx->AFR[tmp] = (uint32_t)((GPIOx->AFR[tmp] & (~(0xFU << ((gpio_pin % 8) * 4)))) |
+                                 (af_num << ((gpio_pin % 8) * 4)));
+}
+
+/*******************************************************************************
+ * Function Name: usart_flowctrl_config()
+ ********************************************************************************
+ * Summary:
+ *   Configures the CTS and RTS pins of the USART for the hardware flow control
+ *   selected in usart_cfg->hwflowctrl, the flow control itself is enabled by
+ *   usart_config(). Only USART1/2/3/6 have the RTS/CTS lines.
+ *
+ *   RTS is an output asserted (low) while the USART can receive, CTS an input
+ *   which must be low for the USART to start sending the next byte.
+ *
+ * Parameters:
+ *   usart_cfg:      Pointer to USART configs
+ *   cts_GPIOx:      Pointer to USART CTS pin port, used with CTS enabled
+ *   cts_gpio_pin:   USART CTS GPIO pin, used with CTS enabled
+ *   rts_GPIOx:      Pointer to USART RTS pin port, used with RTS enabled
+ *   rts_gpio_pin:   USART RTS GPIO pin, used with RTS enabled
+ *
+ * Return :
+ *   usart_status_e_t:   USART flow control config operation result
+ *
+ *******************************************************************************/
+usart_status_e_t usart_flowctrl_config(usart_config_st_t *usart_cfg, GPIO_TypeDef *cts_GPIOx,
+                                       uint8_t cts_gpio_pin, GPIO_TypeDef *rts_GPIOx,
+                                       uint8_t rts_gpio_pin)
+{
+    bool cts_en = (USART_FLOWCTRL_CTS_EN == usart_cfg->hwflowctrl) ||
+                  (USART_FLOWCTRL_RTS_CTS_BOTH_EN == usart_cfg->hwflowctrl);
+    bool rts_en = (USART_FLOWCTRL_RTS_EN == usart_cfg->hwflowctrl) ||
+                  (USART_FLOWCTRL_RTS_CTS_BOTH_EN == usart_cfg->hwflowctrl);
+    uint32_t af_num = 7U;
+
+    /* Alternate function number is from product datasheet's AF mapping */
+    if (USART6 == usart_cfg->instance)
+    {
+        af_num = 8U;
+    }
+    else if ((USART1 != usart_cfg->instance) && (USART2 != usart_cfg->instance) &&
+             (USART3 != usart_cfg->instance))
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    if ((cts_en && (NULL == cts_GPIOx)) || (rts_en && (NULL == rts_GPIOx)))
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    if (cts_en)
+    {
+        usart_gpio_af_config(cts_GPIOx, cts_gpio_pin, af_num, false);
+    }
+
+    if (rts_en)
+    {
+        usart_gpio_af_config(rts_GPIOx, rts_gpio_pin, af_num, true);
+    }
+
+    return USART_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: usart_calc_brr()
+ ********************************************************************************
+ * Summary:
+ *   Calculates the BRR register value for a baud rate, using integer math only,
+ *   see USART_BRR_CALC() for the compile time version of the same.
+ *
+ * Parameters:
+ *   fck:            USART kernel clock, APB2 clock for USART1/6, APB1 for others
+ *   baudrate:       Required baud rate
+ *   oversample:     USART_OVERSAMPLE_BY_16 or USART_OVERSAMPLE_BY_8
+ *   brr:            Set to the BRR value
+ *   baud_err_ppm:   Set to the error of the achieved baud rate in ppm, can be
+ *                   NULL.
+ *
+ * Return :
+ *  usart_status_e_t:   USART_STATUS_BAD_PARAM if the baud rate is out of the
+ *                      divider range or the error is above USART_BAUD_ERR_MAX_PPM
+ *
+ *******************************************************************************/
+usart_status_e_t usart_calc_brr(uint32_t fck, uint32_t baudrate, bool oversample,
+                                uint32_t *brr, uint32_t *baud_err_ppm)
+{
+    uint32_t usart_div = 0, achieved = 0, diff = 0, err_ppm = 0;
+
+    if ((0U == baudrate) || (NULL == brr))
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
 
-            usart_cfg->instance->BRR = 0U;
-            usart_cfg->instance->BRR |= (uint32_t)(baud_fractn | (baud_mantissa << 4U));
+    usart_div = USART_DIV_CALC(fck, baudrate);
+
+    /* Mantissa is 12 bits and must not be 0 */
+    if (USART_OVERSAMPLE_BY_8 == oversample)
+    {
+        if ((usart_div < 8U) || (usart_div > 0x7FFFU))
+        {
+            return USART_STATUS_BAD_PARAM;
         }
-        else if (USART_OVERSAMPLE_BY_8 == usart_cfg->oversample)
+    }
+    else
+    {
+        if ((usart_div < 16U) || (usart_div > 0xFFFFU))
         {
-            baud_fractn = (uint32_t)round((double)((baud_usart_div - (int)baud_usart_div) * 8));
-            baud_mantissa = (baud_fractn > 7U) ? (1U) : (0U);
-            baud_mantissa += (uint32_t)(baud_usart_div);
-
-            /* Program the calculated USART_DIV mantissa and fraction in BRR reg */
-            usart_cfg->instance->BRR = 0U;
-            usart_cfg->instance->BRR |= (uint32_t)((baud_fractn & 0x7U) |
-                                                   (baud_mantissa << 4U));
+            return USART_STATUS_BAD_PARAM;
         }
     }
 
+    achieved = usart_div * baudrate;
+    diff = (fck > achieved) ? (fck - achieved) : (achieved - fck);
+    err_ppm = (uint32_t)(((uint64_t)diff * 1000000U) / achieved);
+
+    if (NULL != baud_err_ppm)
+    {
+        *baud_err_ppm = err_ppm;
+    }
+
+    if (err_ppm > USART_BAUD_ERR_MAX_PPM)
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    *brr = USART_BRR_CALC(fck, baudrate, oversample);
+
     return USART_STATUS_SUCCESS;
 }
 
+/*******************************************************************************
+ * Function Name: usart_autobaud_snap()
+ ********************************************************************************
+ * Summary:
+ *   Returns the standard baud rate nearest to a measured rate, if it is within
+ *   USART_BAUD_ERR_MAX_PPM, else the measured rate itself.
+ *
+ *******************************************************************************/
+static uint32_t usart_autobaud_snap(uint32_t measured_baud)
+{
+    static const uint32_t std_baud[] = {
+        1200U, 2400U, 4800U, 9600U, 14400U, 19200U, 38400U, 57600U,
+        115200U, 230400U, 460800U, 921600U,
+    };
+    uint32_t i = 0, diff = 0;
+
+    for (i = 0; i < (sizeof(std_baud) / sizeof(std_baud[0])); i++)
+    {
+        diff = (measured_baud > std_baud[i]) ? (measured_baud - std_baud[i]) :
+                                               (std_baud[i] - measured_baud);
+
+        if (((uint64_t)diff * 1000000U) <= ((uint64_t)std_baud[i] * USART_BAUD_ERR_MAX_PPM))
+        {
+            return std_baud[i];
+        }
+    }
+
+    return measured_baud;
+}
+
+/*******************************************************************************
+ * Function Name: usart_autobaud_detect()
+ ********************************************************************************
+ * Summary:
+ *   Detects the baud rate of the peer from the sync character 'U' (0x55) and
+ *   programs it in the BRR, the rate is locked within one character. The USART
+ *   should be configured already with usart_config(), with any valid rate.
+ *
+ *   While detecting, the Rx pin is switched to a timer channel in the input
+ *   capture mode, the falling edges are captured and the span of 5 edges, 8
+ *   bit times, gives the rate. The 4 edge intervals must be equal within 1/4
+ *   bit, else the window moves by an edge, so the detection can start in the
+ *   middle of a character or on a stream of 'U'. The measured rate is snapped
+ *   to the nearest standard rate within USART_BAUD_ERR_MAX_PPM. The Rx pin is
+ *   switched back to the USART after the detection.
+ *
+ *   The sync character is consumed by the detection and is not received by
+ *   the USART. The edges are polled, the highest rate which can be detected
+ *   depends on the core clock, ~460800 at 100 MHz.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs, baudrate is updated
+ *   rx_GPIOx:           Pointer to USART Rx pin port
+ *   rx_gpio_pin:        USART Rx GPIO pin
+ *   ab_cfg:             Timer and it's channel on the Rx pin
+ *   timeout_milsec:     Time to wait for the sync character in ms,
+ *                       USART_TIMEOUT_WAIT_FOREVER to wait without a time limit.
+ *   measured_baud:      Set to the measured rate before the snapping, can be
+ *                       NULL.
+ *
+ * Return :
+ *  usart_status_e_t:   UART_STATUS_TIMEOUT if no sync character was received,
+ *                      USART_STATUS_FAIL if the rate can't be generated,
+ *                      USART_STATUS_BAD_PARAM if the timer is the timebase or
+ *                      the delay timer.
+ *
+ *******************************************************************************/
+usart_status_e_t usart_autobaud_detect(usart_config_st_t *usart_cfg, GPIO_TypeDef *rx_GPIOx,
+                                       uint8_t rx_gpio_pin, const usart_autobaud_cfg_st_t *ab_cfg,
+                                       uint32_t timeout_milsec, uint32_t *measured_baud)
+{
+    TIM_TypeDef *TIMx = ab_cfg->TIMx;
+    general_timer_configs_t tim_config = {0};
+    volatile uint32_t *ccr = NULL;
+    volatile uint32_t *ccmr = NULL;
+    deadline_st_t deadline;
+    usart_status_e_t status = UART_STATUS_TIMEOUT;
+    uint16_t edge[USART_AUTOBAUD_EDGE_CNT];
+    uint32_t ch = ab_cfg->tim_channel;
+    uint32_t cc_if = 0, cc_of = 0, ccmr_shift = 0, ccer_shift = 0;
+    uint32_t tim_clock = 0, psc = 0, sr = 0, edge_cnt = 0, span = 0, delta = 0, i = 0;
+    uint32_t baud = 0, brr = 0;
+    bool lock = false;
+
+    if ((usart_get_inst_idx(usart_cfg->instance) < 0) || (NULL == TIMx) || (ch < 1U) ||
+        (ch > 4U) || (USART_COMPATIBLE_MODE_ASYNC != usart_cfg->compatmode))
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    /* The timer is reprogrammed, it must not be one the other libs run on */
+    if (TIMEBASE_TIM_INST == TIMx)
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+#if (DELAY_BACKEND_TIM == DELAY_BACKEND)
+    if (DELAY_TIM_INST == TIMx)
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+#endif
+
+    cc_if = TIM_SR_CC1IF << (ch - 1U);
+    cc_of = TIM_SR_CC1OF << (ch - 1U);
+    ccr = &TIMx->CCR1 + (ch - 1U);
+    ccmr = (ch <= 2U) ? (&TIMx->CCMR1) : (&TIMx->CCMR2);
+    ccmr_shift = ((ch - 1U) % 2U) * 8U;
+    ccer_shift = (ch - 1U) * 4U;
+
+    /* The 2 bit times between two falling edges fit in the 16-bit capture at
+     * the lowest rate, the prescaler is the smallest which ensures it. The 8 bit
+     * times of the sync character are summed from the deltas in 32 bits.
+     */
+    tim_clock = get_timer_clock(TIMx);
+    psc = (2U * (tim_clock / USART_AUTOBAUD_MIN_BAUD)) / 0x10000U;
+
+    tim_config.prescaler = (uint16_t)psc;
+    tim_config.period = 0xFFFFU;
+    general_timer_config(TIMx, &tim_config);
+
+    /* Loads the prescaler */
+    TIMx->EGR = TIM_EGR_UG;
+
+    /* Channel as input capture on it's own input, no filter, on falling edges */
+    *ccmr = (uint32_t)((*ccmr & (~(0xFFU << ccmr_shift))) | (1U << ccmr_shift));
+    TIMx->CCER = (uint32_t)((TIMx->CCER & (~(0xFU << ccer_shift))) |
+                            ((TIM_CCER_CC1E | TIM_CCER_CC1P) << ccer_shift));
+    TIMx->SR = 0;
+    TIMx->CR1 |= TIM_CR1_CEN;
+
+    usart_gpio_af_config(rx_GPIOx, rx_gpio_pin, ab_cfg->tim_af, false);
+
+    deadline_start(&deadline, timeout_milsec);
+
+    while (!lock && !deadline_expired(&deadline))
+    {
+        sr = TIMx->SR;
+        if (!(sr & cc_if))
+        {
+            continue;
+        }
+
+        /* Reading the capture clears the capture flag */
+        edge[edge_cnt++] = (uint16_t)*ccr;
+
+        /* An edge was missed, start again */
+        if (sr & cc_of)
+        {
+            TIMx->SR = ~cc_of;
+            edge[0] = edge[edge_cnt - 1U];
+            edge_cnt = 1;
+            continue;
+        }
+
+        if (edge_cnt < USART_AUTOBAUD_EDGE_CNT)
+        {
+            continue;
+        }
+
+        span = 0;
+        for (i = 1; i < USART_AUTOBAUD_EDGE_CNT; i++)
+        {
+            span += (uint16_t)(edge[i] - edge[i - 1U]);
+        }
+        lock = (0U != span);
+
+        for (i = 1; lock && (i < USART_AUTOBAUD_EDGE_CNT); i++)
+        {
+            delta = (uint16_t)(edge[i] - edge[i - 1U]);
+            delta *= (USART_AUTOBAUD_EDGE_CNT - 1U);
+            lock = (((delta > span) ? (delta - span) : (span - delta)) <= (span / 8U));
+        }
+
+        if (!lock)
+        {
+            /* Not the sync character, move the window by an edge */
+            for (i = 1; i < USART_AUTOBAUD_EDGE_CNT; i++)
+            {
+                edge[i - 1U] = edge[i];
+            }
+            edge_cnt--;
+        }
+    }
+
+    /* Rx pin back to the USART, AF number is from product datasheet's AF mapping */
+    TIMx->CR1 &= ~TIM_CR1_CEN;
+    TIMx->CCER &= ~(0xFU << ccer_shift);
+
+    usart_gpio_af_config(rx_GPIOx, rx_gpio_pin,
+                         ((USART1 == usart_cfg->instance) || (USART2 == usart_cfg->instance) ||
+                          (USART3 == usart_cfg->instance)) ? (7U) : (8U), false);
+
+    if (lock)
+    {
+        /* 8 bit times of the sync character in the span */
+        baud = (uint32_t)(((uint64_t)tim_clock * 8U) / ((uint64_t)(psc + 1U) * span));
+
+        if (NULL != measured_baud)
+        {
+            *measured_baud = baud;
+        }
+
+        baud = usart_autobaud_snap(baud);
+
+        status = usart_calc_brr(usart_get_clock(usart_cfg->instance), baud,
+                                usart_cfg->oversample, &brr, NULL);
+        if (USART_STATUS_SUCCESS == status)
+        {
+            usart_cfg->baudrate = baud;
+            usart_cfg->instance->BRR = brr;
+        }
+        else
+        {
+            status = USART_STATUS_FAIL;
+        }
+    }
+
+    /* Errors flagged while the Rx pin was switched, cleared by the SR and DR read */
+    (void)usart_cfg->instance->SR;
+    (void)usart_cfg->instance->DR;
+
+    return status;
+}
+
 /*******************************************************************************
  * Function Name: usart_init()
  ********************************************************************************
@@ -261,28 +814,55 @@ usart_status_e_t usart_deinit(usart_config_st_t *usart_cfg)
  *  usart_cfg:          Pointer to USART configs
  *  rx_buff:            Pointer to buffer to store Rx data
  *  rx_buff_size:       Size of the RX data buffer
- *  timeout_milsec:     (TO DO) The API waits for this much time in ms for receiving the
- *                      data and then terminates.
+ *  timeout_milsec:     The API waits for this much time in ms for receiving the
+ *                      data and then terminates, USART_TIMEOUT_WAIT_FOREVER to
+ *                      wait without a time limit.
+ *  rx_size:            Set to the number of bytes received, the reception can
+ *                      be resumed from here after a timeout. Can be NULL.
  *
  * Return :
- *  usart_status_e_t:   Status of this receive operation
+ *  usart_status_e_t:   Status of this receive operation, UART_STATUS_TIMEOUT
+ *                      if the buffer was not filled in time.
  *
  *******************************************************************************/
 usart_status_e_t uart_receive_poll(usart_config_st_t *usart_cfg, uint8_t *rx_buff,
-                                   uint16_t rx_buff_size, uint32_t timeout_milsec)
+                                   uint16_t rx_buff_size, uint32_t timeout_milsec,
+                                   uint16_t *rx_size)
 {
-    for (uint16_t i = 0; i < rx_buff_size; i++)
+    usart_status_e_t status = USART_STATUS_SUCCESS;
+    deadline_st_t deadline;
+    uint16_t i = 0;
+
+    deadline_start(&deadline, timeout_milsec);
+
+    for (i = 0; i < rx_buff_size; i++)
     {
         /* Wait while the RX data can be safely read from the HW Rx buffer */
         while (!(usart_cfg->instance->SR & (1U << USART_SR_RXNE_Pos)))
-            ;
+        {
+            if (deadline_expired(&deadline))
+            {
+                status = UART_STATUS_TIMEOUT;
+                break;
+            }
+        }
+
+        if (UART_STATUS_TIMEOUT == status)
+        {
+            break;
+        }
 
         /* Now the data can be safely read from the HW Rx buffer,
          * Read operation clears the RXNE flag .*/
         rx_buff[i] = usart_cfg->instance->DR;
     }
 
-    return USART_STATUS_SUCCESS;
+    if (NULL != rx_size)
+    {
+        *rx_size = i;
+    }
+
+    return status;
 }
 
 /*******************************************************************************
@@ -295,30 +875,58 @@ usart_status_e_t uart_receive_poll(usart_config_st_t *usart_cfg, uint8_t *rx_buf
  *   usart_cfg:          Pointer to USART configs
  *   tx_buff:            Pointer to buffer of Tx data
  *   tx_buff_size:       Size of the TX data buffer
- *   timeout_milsec:     (TO DO) The API waits for this much time in ms for
- *                       transmitting the data and then terminates.
+ *   timeout_milsec:     The API waits for this much time in ms for transmitting
+ *                       the data and then terminates, USART_TIMEOUT_WAIT_FOREVER
+ *                       to wait without a time limit.
+ *   tx_size:            Set to the number of bytes written to the USART, the
+ *                       transmission can be resumed from here after a timeout.
+ *                       Can be NULL.
  *
  * Return :
- *  usart_status_e_t:   Status of this transmit operation
+ *  usart_status_e_t:   Status of this transmit operation, UART_STATUS_TIMEOUT
+ *                      if the buffer was not sent in time.
  *
  *******************************************************************************/
 usart_status_e_t uart_transmit_blocking(usart_config_st_t *usart_cfg, uint8_t *tx_buff,
-                                        uint16_t tx_buff_size, uint32_t timeout_milsec)
+                                        uint16_t tx_buff_size, uint32_t timeout_milsec,
+                                        uint16_t *tx_size)
 {
-    for (uint16_t i = 0; i < tx_buff_size; i++)
+    usart_status_e_t status = USART_STATUS_SUCCESS;
+    deadline_st_t deadline;
+    uint16_t i = 0;
+
+    deadline_start(&deadline, timeout_milsec);
+
+    for (i = 0; i < tx_buff_size; i++)
     {
         /* Wait for the Transmit buffer to be ready to accept data safely */
         while (!(usart_cfg->instance->SR & (1U << USART_SR_TXE_Pos)))
-            ;
+        {
+            if (deadline_expired(&deadline))
+            {
+                status = UART_STATUS_TIMEOUT;
+                break;
+            }
+        }
+
+        if (UART_STATUS_TIMEOUT == status)
+        {
+            break;
+        }
 
         /* The transmission data can be safely put to Tx data register
          * (HW Tx buffer). This operation also clears the TXE bit. */
         usart_cfg->instance->DR = tx_buff[i];
     }
 
-    return USART_STATUS_SUCCESS;
-}
-
+    if (NULL != tx_size)
+    {
+        *tx_size = i;
+    }
+
+    return status;
+}
+
 /*******************************************************************************
  * Function Name: uart_rx_interrupt_set()
  ********************************************************************************
@@ -341,4 +949,1600 @@ usart_status_e_t uart_rx_interrupt_set(USART_TypeDef *uart_inst, bool rx_int_en)
     return USART_STATUS_SUCCESS;
 }
 
+/*******************************************************************************
+ * Function Name: usart_set_event_handler()
+ ********************************************************************************
+ * Summary:
+ *   Installs the handler of an interrupt event of the instance. The callback and
+ *   it's argument are written with IRQs masked so that the ISR never sees a
+ *   mismatched pair.
+ *
+ * Parameters:
+ *   idx:            Index of the USART instance
+ *   event:          Interrupt event
+ *   event_cb:       Callback for the event, NULL to remove the handler
+ *   cb_arg:         Argument passed to the callback
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void usart_set_event_handler(uint32_t idx, usart_event_e_t event,
+                                    usart_event_cb_t event_cb, void *cb_arg)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    usart_ctx[idx].event[event].cb = event_cb;
+    usart_ctx[idx].event[event].cb_arg = cb_arg;
+    __set_PRIMASK(primask);
+}
+
+/*******************************************************************************
+ * Function Name: usart_irq_enable()
+ ********************************************************************************
+ * Summary:
+ *   Enables the USART interrupt of the instance in NVIC with USART_IRQ_PRIORITY.
+ *
+ * Parameters:
+ *   idx:            Index of the USART instance
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void usart_irq_enable(uint32_t idx)
+{
+    NVIC_SetPriority(usart_hw_map[idx].irqn, USART_IRQ_PRIORITY);
+    NVIC_EnableIRQ(usart_hw_map[idx].irqn);
+}
+
+/*******************************************************************************
+ * Function Name: usart_register_callback()
+ ********************************************************************************
+ * Summary:
+ *   Registers the callback for an interrupt event of the USART instance, the
+ *   callback is called from the USARTx_IRQHandler of the lib. This replaces the
+ *   handler installed for the event by the lib engines, ex: uart_rx_ring_start()
+ *   installs the RXNE handler. The USART interrupt is enabled in NVIC with
+ *   USART_IRQ_PRIORITY, the event itself is enabled with usart_event_enable().
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *   event:              Interrupt event
+ *   event_cb:           Callback for the event, NULL to remove the callback
+ *   cb_arg:             Argument passed to the callback
+ *
+ * Return :
+ *  usart_status_e_t:   Status of the operation
+ *
+ *******************************************************************************/
+usart_status_e_t usart_register_callback(usart_config_st_t *usart_cfg, usart_event_e_t event,
+                                         usart_event_cb_t event_cb, void *cb_arg)
+{
+    int32_t idx = usart_get_inst_idx(usart_cfg->instance);
+
+    if ((idx < 0) || (event >= USART_EVENT_NUM))
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    usart_ctx[idx].usart_cfg = usart_cfg;
+    usart_set_event_handler((uint32_t)idx, event, event_cb, cb_arg);
+
+    usart_irq_enable((uint32_t)idx);
+
+    return USART_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: usart_event_enable()
+ ********************************************************************************
+ * Summary:
+ *   Enables/disables the interrupt of an event of the USART instance. The error
+ *   event covers overrun, noise and framing errors, and parity error.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *   event:              Interrupt event
+ *   event_en:           Enable/disable value for the event interrupt
+ *
+ * Return :
+ *  usart_status_e_t:   Status of the operation
+ *
+ *******************************************************************************/
+usart_status_e_t usart_event_enable(usart_config_st_t *usart_cfg, usart_event_e_t event,
+                                    bool event_en)
+{
+    USART_TypeDef *instance = usart_cfg->instance;
+    uint32_t cr1_msk = 0;
+    uint32_t primask = 0;
+
+    switch (event)
+    {
+    case USART_EVENT_RXNE:
+        cr1_msk = USART_CR1_RXNEIE_Msk;
+        break;
+    case USART_EVENT_TXE:
+        cr1_msk = USART_CR1_TXEIE_Msk;
+        break;
+    case USART_EVENT_TC:
+        cr1_msk = USART_CR1_TCIE_Msk;
+        break;
+    case USART_EVENT_IDLE:
+        cr1_msk = USART_CR1_IDLEIE_Msk;
+        break;
+    case USART_EVENT_ERROR:
+        cr1_msk = USART_CR1_PEIE_Msk;
+        break;
+    default:
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    if (USART_EVENT_ERROR == event)
+    {
+        primask = __get_PRIMASK();
+        __disable_irq();
+        instance->CR3 = (uint32_t)((instance->CR3 & (~USART_CR3_EIE_Msk)) |
+                                   ((uint32_t)event_en << USART_CR3_EIE_Pos));
+        __set_PRIMASK(primask);
+    }
+
+    usart_cr1_modify(instance, cr1_msk, (event_en) ? (cr1_msk) : (0U));
+
+    return USART_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: usart_dma_tx_start()
+ ********************************************************************************
+ * Summary:
+ *   Starts the DMA transfer of a segment to the USART data register. Called
+ *   with the instance's DMA Tx interrupt masked or from the DMA Tx ISR.
+ *
+ * Parameters:
+ *   idx:            Index of the USART instance
+ *   tx_buff:        Pointer to buffer of Tx data
+ *   tx_buff_size:   Size of the TX data buffer
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void usart_dma_tx_start(uint32_t idx, uint8_t *tx_buff, uint16_t tx_buff_size)
+{
+    USART_TypeDef *instance = usart_hw_map[idx].instance;
+
+    /* Clear TC, the flag is cleared by writing 0, other bits written as 1 are
+     * not affected, a read-modify-write could clear a freshly set RXNE.
+     */
+    instance->SR = (uint32_t)(~(USART_SR_TC_Msk));
+
+    dma_stream_start(usart_hw_map[idx].dma_tx_stream, (uint32_t)&instance->DR,
+                     (uint32_t)tx_buff, tx_buff_size);
+}
+
+/*******************************************************************************
+ * Function Name: usart_dma_tx_next_seg()
+ ********************************************************************************
+ * Summary:
+ *   Starts the DMA transfer of the next non-empty segment of the ongoing job.
+ *
+ * Parameters:
+ *   idx:            Index of the USART instance
+ *
+ * Return :
+ *   bool:           false if no segment is left in the job
+ *
+ *******************************************************************************/
+static bool usart_dma_tx_next_seg(uint32_t idx)
+{
+    usart_ctx_st_t *ctx = &usart_ctx[idx];
+    const uart_iovec_st_t *seg = NULL;
+
+    while (ctx->dma_tx_seg_idx < ctx->dma_tx_job.iov_cnt)
+    {
+        seg = &ctx->dma_tx_job.iov[ctx->dma_tx_seg_idx++];
+
+        if (0U != seg->size)
+        {
+            usart_dma_tx_start(idx, seg->buff, seg->size);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*******************************************************************************
+ * Function Name: usart_dma_tx_job_start()
+ ********************************************************************************
+ * Summary:
+ *   Makes the job the ongoing DMA Tx job and starts it's first segment.
+ *
+ * Parameters:
+ *   idx:            Index of the USART instance
+ *   job:            Job to start, copied into the instance context
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void usart_dma_tx_job_start(uint32_t idx, const usart_dma_tx_job_st_t *job)
+{
+    usart_ctx_st_t *ctx = &usart_ctx[idx];
+
+    ctx->dma_tx_job = *job;
+
+    /* A single buffer job refers to it's own copy of the segment */
+    if (&job->seg == job->iov)
+    {
+        ctx->dma_tx_job.iov = &ctx->dma_tx_job.seg;
+    }
+
+    ctx->dma_tx_seg_idx = 0;
+    (void)usart_dma_tx_next_seg(idx);
+}
+
+/*******************************************************************************
+ * Function Name: usart_dma_tx_isr()
+ ********************************************************************************
+ * Summary:
+ *   Common DMA Tx stream ISR, chains the next segment of the ongoing job. Once
+ *   the job is done starts the queued job, if any, and reports the completed
+ *   job through the registered callback. A failed job is not continued.
+ *
+ * Parameters:
+ *   idx:            Index of the USART instance
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void usart_dma_tx_isr(uint32_t idx)
+{
+    usart_ctx_st_t *ctx = &usart_ctx[idx];
+    DMA_Stream_TypeDef *stream = usart_hw_map[idx].dma_tx_stream;
+    uint32_t flags = dma_stream_get_flags(stream);
+    uint8_t *done_buff = NULL;
+    usart_status_e_t status = USART_STATUS_SUCCESS;
+
+    dma_stream_clear_flags(stream, flags);
+
+    /* FIFO error flag may be set in direct mode too, it is harmless */
+    if (!(flags & (DMA_FLAG_TCIF | DMA_FLAG_TEIF)))
+    {
+        return;
+    }
+
+    if (flags & DMA_FLAG_TEIF)
+    {
+        status = USART_STATUS_FAIL;
+    }
+    else if (usart_dma_tx_next_seg(idx))
+    {
+        /* Next segment started, the last byte of the previous one is still in
+         * the USART, so the segments go out back-to-back.
+         */
+        return;
+    }
+
+    done_buff = ctx->dma_tx_job.iov[0].buff;
+
+    /* Start the queued job first, to keep the line busy */
+    if (ctx->dma_tx_pend)
+    {
+        ctx->dma_tx_pend = false;
+        usart_dma_tx_job_start(idx, &ctx->dma_tx_pend_job);
+    }
+    else
+    {
+        ctx->dma_tx_busy = false;
+    }
+
+    if (NULL != ctx->dma_tx_cb)
+    {
+        ctx->dma_tx_cb(ctx->usart_cfg, done_buff, status);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: uart_dma_tx_init()
+ ********************************************************************************
+ * Summary:
+ *   Configures the DMA stream assosciated with the USART Tx, for use by
+ *   uart_transmit_dma(). The USART should be configured already with
+ *   usart_config().
+ *
+ * Parameters:
+ *   usart_cfg:      Pointer to USART configs
+ *   tx_done_cb:     Called from ISR when a buffer is sent, can be NULL
+ *
+ * Return :
+ *  usart_status_e_t:   Status of DMA Tx init operation
+ *
+ *******************************************************************************/
+usart_status_e_t uart_dma_tx_init(usart_config_st_t *usart_cfg, uart_dma_tx_cb_t tx_done_cb)
+{
+    int32_t idx = usart_get_inst_idx(usart_cfg->instance);
+    IRQn_Type dma_irqn;
+
+    dma_stream_config_st_t dma_cfg = {
+        .direction = DMA_DIR_MEM_TO_PERIPH,
+        .priority = DMA_PRIORITY_MEDIUM,
+        .periph_size = DMA_DATA_SIZE_BYTE,
+        .mem_size = DMA_DATA_SIZE_BYTE,
+        .periph_inc = false,
+        .mem_inc = true,
+        .circular = false,
+        .tc_intr_en = true,
+        .ht_intr_en = false,
+        .te_intr_en = true,
+    };
+
+    if (idx < 0)
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    dma_cfg.channel = usart_hw_map[idx].dma_tx_channel;
+    dma_irqn = dma_stream_get_irqn(usart_hw_map[idx].dma_tx_stream);
+
+    NVIC_DisableIRQ(dma_irqn);
+
+    usart_ctx[idx].usart_cfg = usart_cfg;
+    usart_ctx[idx].dma_tx_cb = tx_done_cb;
+    usart_ctx[idx].dma_tx_busy = false;
+    usart_ctx[idx].dma_tx_pend = false;
+
+    dma_stream_config(usart_hw_map[idx].dma_tx_stream, &dma_cfg);
+
+    /* Route the USART Tx requests to DMA */
+    usart_cfg->instance->CR3 |= (1U << USART_CR3_DMAT_Pos);
+
+    NVIC_SetPriority(dma_irqn, USART_IRQ_PRIORITY);
+    NVIC_EnableIRQ(dma_irqn);
+
+    /* Only the DMA Tx init sets it, usart_cfg is also set by the other inits */
+    usart_ctx[idx].dma_tx_ready = true;
+
+    return USART_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: usart_dma_tx_submit()
+ ********************************************************************************
+ * Summary:
+ *   Starts the DMA Tx job, or queues it if a job is ongoing. Only one job can
+ *   be queued.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *   job:                Job to submit, copied
+ *
+ * Return :
+ *  usart_status_e_t:   UART_STATUS_TRANSMIT_BUSY if a job is already queued
+ *
+ *******************************************************************************/
+static usart_status_e_t usart_dma_tx_submit(usart_config_st_t *usart_cfg,
+                                            const usart_dma_tx_job_st_t *job)
+{
+    int32_t idx = usart_get_inst_idx(usart_cfg->instance);
+    usart_status_e_t status = USART_STATUS_SUCCESS;
+    usart_ctx_st_t *ctx = NULL;
+    uint32_t primask = 0;
+
+    if (idx < 0)
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    ctx = &usart_ctx[idx];
+
+    /* uart_dma_tx_init() not called for the instance */
+    if (!ctx->dma_tx_ready)
+    {
+        return USART_STATUS_FAIL;
+    }
+
+    /* The busy/queued state is shared with the DMA Tx ISR */
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (!ctx->dma_tx_busy)
+    {
+        ctx->dma_tx_busy = true;
+        usart_dma_tx_job_start((uint32_t)idx, job);
+    }
+    else if (!ctx->dma_tx_pend)
+    {
+        ctx->dma_tx_pend_job = *job;
+        if (&job->seg == job->iov)
+        {
+            ctx->dma_tx_pend_job.iov = &ctx->dma_tx_pend_job.seg;
+        }
+        ctx->dma_tx_pend = true;
+    }
+    else
+    {
+        status = UART_STATUS_TRANSMIT_BUSY;
+    }
+
+    __set_PRIMASK(primask);
+
+    return status;
+}
+
+/*******************************************************************************
+ * Function Name: uart_transmit_dma()
+ ********************************************************************************
+ * Summary:
+ *   Transmit UART data from the specified buffer using DMA, the function
+ *   returns immediately and the CPU is free during the transmission.
+ *
+ *   If a transfer is ongoing the buffer is queued and sent right after the
+ *   ongoing one, only one buffer can be queued. The buffer must not be
+ *   modified till the completion callback for it is called.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *   tx_buff:            Pointer to buffer of Tx data
+ *   tx_buff_size:       Size of the TX data buffer
+ *
+ * Return :
+ *  usart_status_e_t:   UART_STATUS_TRANSMIT_BUSY if a buffer is already queued
+ *
+ *******************************************************************************/
+usart_status_e_t uart_transmit_dma(usart_config_st_t *usart_cfg, uint8_t *tx_buff,
+                                   uint16_t tx_buff_size)
+{
+    usart_dma_tx_job_st_t job;
+
+    if ((NULL == tx_buff) || (0U == tx_buff_size))
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    job.seg.buff = tx_buff;
+    job.seg.size = tx_buff_size;
+    job.iov = &job.seg;
+    job.iov_cnt = 1U;
+
+    return usart_dma_tx_submit(usart_cfg, &job);
+}
+
+/*******************************************************************************
+ * Function Name: uart_transmit_v()
+ ********************************************************************************
+ * Summary:
+ *   Transmit UART data from a list of segments using DMA, the segments are
+ *   sent back-to-back as one frame without being copied into a single buffer,
+ *   ex: header, payload in place and CRC trailer. The F4 DMA has no linked
+ *   list mode, each segment is chained from the DMA Tx ISR while the USART is
+ *   still sending the last byte of the previous one. Empty segments are skipped.
+ *
+ *   Queuing and busy reporting is the same as uart_transmit_dma(). The segment
+ *   array and the data must not be modified till the completion callback is
+ *   called, the callback gets the buffer of the first segment.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *   iov:                Pointer to array of Tx data segments
+ *   iov_cnt:            Number of segments in the array
+ *
+ * Return :
+ *  usart_status_e_t:   UART_STATUS_TRANSMIT_BUSY if a job is already queued
+ *
+ *******************************************************************************/
+usart_status_e_t uart_transmit_v(usart_config_st_t *usart_cfg, const uart_iovec_st_t *iov,
+                                 uint8_t iov_cnt)
+{
+    usart_dma_tx_job_st_t job;
+    uint8_t i = 0;
+    bool has_data = false;
+
+    if ((NULL == iov) || (0U == iov_cnt))
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    for (i = 0; i < iov_cnt; i++)
+    {
+        if ((NULL == iov[i].buff) && (0U != iov[i].size))
+        {
+            return USART_STATUS_BAD_PARAM;
+        }
+
+        has_data = has_data || (0U != iov[i].size);
+    }
+
+    if (!has_data)
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    job.iov = iov;
+    job.seg.buff = NULL;
+    job.seg.size = 0;
+    job.iov_cnt = iov_cnt;
+
+    return usart_dma_tx_submit(usart_cfg, &job);
+}
+
+/*******************************************************************************
+ * Function Name: uart_dma_tx_busy()
+ ********************************************************************************
+ * Summary:
+ *   Checks whether a DMA transmission is ongoing on the USART.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *
+ * Return :
+ *  bool:               true if a DMA transfer is ongoing or queued
+ *
+ *******************************************************************************/
+bool uart_dma_tx_busy(usart_config_st_t *usart_cfg)
+{
+    int32_t idx = usart_get_inst_idx(usart_cfg->instance);
+
+    return (idx >= 0) ? (usart_ctx[idx].dma_tx_busy) : (false);
+}
+
+/*******************************************************************************
+ * Function Name: usart_rx_dma_deliver()
+ ********************************************************************************
+ * Summary:
+ *   Hands the data written by the DMA since the last call to the Rx callback,
+ *   directly from the ring. Data wrapping around the ring end is handed as two
+ *   chunks. Called only from the DMA Rx and USART ISRs which have the same
+ *   priority, so the read position needs no further protection.
+ *
+ * Parameters:
+ *   idx:            Index of the USART instance
+ *   frame_end:      true if called on Rx line idle
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void usart_rx_dma_deliver(uint32_t idx, bool frame_end)
+{
+    usart_ctx_st_t *ctx = &usart_ctx[idx];
+    uint16_t read_pos = ctx->dma_rx_read_pos;
+    uint16_t write_pos = 0;
+
+    /* Write position of the DMA, NDTR counts down and reloads in circular mode */
+    write_pos = (uint16_t)(ctx->dma_rx_ring_size - dma_stream_get_count(usart_hw_map[idx].dma_rx_stream));
+    if (write_pos == ctx->dma_rx_ring_size)
+    {
+        write_pos = 0;
+    }
+
+    if (write_pos == read_pos)
+    {
+        return;
+    }
+
+    if (write_pos > read_pos)
+    {
+        ctx->dma_rx_cb(ctx->usart_cfg, &ctx->dma_rx_ring[read_pos],
+                       (uint16_t)(write_pos - read_pos), frame_end);
+    }
+    else
+    {
+        ctx->dma_rx_cb(ctx->usart_cfg, &ctx->dma_rx_ring[read_pos],
+                       (uint16_t)(ctx->dma_rx_ring_size - read_pos),
+                       (frame_end && (0U == write_pos)));
+
+        if (write_pos > 0U)
+        {
+            ctx->dma_rx_cb(ctx->usart_cfg, ctx->dma_rx_ring, write_pos, frame_end);
+        }
+    }
+
+    ctx->dma_rx_read_pos = write_pos;
+}
+
+/*******************************************************************************
+ * Function Name: usart_dma_rx_isr()
+ ********************************************************************************
+ * Summary:
+ *   Common DMA Rx stream ISR, the half and full transfer events hand the data
+ *   to the application before the DMA wraps around and overwrites it.
+ *
+ * Parameters:
+ *   idx:            Index of the USART instance
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void usart_dma_rx_isr(uint32_t idx)
+{
+    DMA_Stream_TypeDef *stream = usart_hw_map[idx].dma_rx_stream;
+    uint32_t flags = dma_stream_get_flags(stream);
+
+    dma_stream_clear_flags(stream, flags);
+
+    if (flags & DMA_FLAG_TEIF)
+    {
+        usart_ctx[idx].dma_rx_err_cnt++;
+    }
+
+    if (flags & (DMA_FLAG_HTIF | DMA_FLAG_TCIF))
+    {
+        usart_rx_dma_deliver(idx, false);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: usart_rx_dma_idle_handler()
+ ********************************************************************************
+ * Summary:
+ *   IDLE event handler of the DMA reception, hands the frame received so far to
+ *   the Rx callback. One interrupt is taken per received frame instead of one
+ *   per byte.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *   sr:                 USART_SR read on the interrupt entry
+ *   cb_arg:             Driver context of the instance
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void usart_rx_dma_idle_handler(usart_config_st_t *usart_cfg, uint32_t sr, void *cb_arg)
+{
+    usart_ctx_st_t *ctx = (usart_ctx_st_t *)cb_arg;
+
+    /* IDLE flag is cleared by reading SR followed by DR, the error handler
+     * already did it if an error is flagged too. DR is read once only, as a
+     * read may take a byte away from the DMA.
+     */
+    if (!(sr & (USART_SR_ORE_Msk | USART_SR_NE_Msk | USART_SR_FE_Msk)))
+    {
+        (void)usart_cfg->instance->DR;
+    }
+
+    usart_rx_dma_deliver(USART_CTX_IDX(ctx), true);
+}
+
+/*******************************************************************************
+ * Function Name: usart_rx_dma_err_handler()
+ ********************************************************************************
+ * Summary:
+ *   Error event handler of the DMA reception, counts the overrun, framing and
+ *   noise errors.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *   sr:                 USART_SR read on the interrupt entry
+ *   cb_arg:             Driver context of the instance
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void usart_rx_dma_err_handler(usart_config_st_t *usart_cfg, uint32_t sr, void *cb_arg)
+{
+    /* Error flags are cleared by reading SR followed by DR */
+    (void)usart_cfg->instance->DR;
+
+    ((usart_ctx_st_t *)cb_arg)->dma_rx_err_cnt++;
+}
+
+/*******************************************************************************
+ * Function Name: uart_rx_dma_start()
+ ********************************************************************************
+ * Summary:
+ *   Starts the reception into a ring buffer using DMA in circular mode. The
+ *   received data is handed to the callback, without copying, when the Rx line
+ *   goes idle after a frame and when the DMA reaches half and end of the ring.
+ *
+ *   The callback must consume the data before the DMA comes back to the same
+ *   ring location i.e. within the time of receiving half of the ring.
+ *
+ *   NOTE: The USART and the DMA Rx interrupts are enabled with the same
+ *   priority USART_IRQ_PRIORITY by this function, the IDLE and error events
+ *   of the instance are handled by the lib.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *   rx_ring:            Pointer to the ring buffer for the Rx data
+ *   rx_ring_size:       Size of the ring buffer
+ *   rx_cb:              Called from ISR with the received data
+ *
+ * Return :
+ *  usart_status_e_t:   Status of the operation
+ *
+ *******************************************************************************/
+usart_status_e_t uart_rx_dma_start(usart_config_st_t *usart_cfg, uint8_t *rx_ring,
+                                   uint16_t rx_ring_size, uart_rx_dma_cb_t rx_cb)
+{
+    int32_t idx = usart_get_inst_idx(usart_cfg->instance);
+    IRQn_Type dma_irqn;
+
+    dma_stream_config_st_t dma_cfg = {
+        .direction = DMA_DIR_PERIPH_TO_MEM,
+        .priority = DMA_PRIORITY_HIGH,
+        .periph_size = DMA_DATA_SIZE_BYTE,
+        .mem_size = DMA_DATA_SIZE_BYTE,
+        .periph_inc = false,
+        .mem_inc = true,
+        .circular = true,
+        .tc_intr_en = true,
+        .ht_intr_en = true,
+        .te_intr_en = true,
+    };
+
+    if ((idx < 0) || (NULL == rx_ring) || (rx_ring_size < 2U) || (NULL == rx_cb))
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    dma_cfg.channel = usart_hw_map[idx].dma_rx_channel;
+    dma_irqn = dma_stream_get_irqn(usart_hw_map[idx].dma_rx_stream);
+
+    NVIC_DisableIRQ(dma_irqn);
+
+    usart_ctx[idx].usart_cfg = usart_cfg;
+    usart_ctx[idx].dma_rx_cb = rx_cb;
+    usart_ctx[idx].dma_rx_ring = rx_ring;
+    usart_ctx[idx].dma_rx_ring_size = rx_ring_size;
+    usart_ctx[idx].dma_rx_read_pos = 0;
+    usart_ctx[idx].dma_rx_err_cnt = 0;
+
+    usart_set_event_handler((uint32_t)idx, USART_EVENT_IDLE, usart_rx_dma_idle_handler,
+                            &usart_ctx[idx]);
+    usart_set_event_handler((uint32_t)idx, USART_EVENT_ERROR, usart_rx_dma_err_handler,
+                            &usart_ctx[idx]);
+
+    dma_stream_config(usart_hw_map[idx].dma_rx_stream, &dma_cfg);
+    dma_stream_start(usart_hw_map[idx].dma_rx_stream, (uint32_t)&usart_cfg->instance->DR,
+                     (uint32_t)rx_ring, rx_ring_size);
+
+    /* Route the USART Rx requests to DMA, error interrupt reports overrun,
+     * framing and noise errors in DMA mode.
+     */
+    usart_cfg->instance->CR3 |= (1U << USART_CR3_DMAR_Pos) | (1U << USART_CR3_EIE_Pos);
+
+    /* Clear a stale IDLE flag, by reading SR followed by DR */
+    (void)usart_cfg->instance->SR;
+    (void)usart_cfg->instance->DR;
+
+    usart_cfg->instance->CR1 |= (1U << USART_CR1_IDLEIE_Pos);
+
+    NVIC_SetPriority(dma_irqn, USART_IRQ_PRIORITY);
+    NVIC_EnableIRQ(dma_irqn);
+    usart_irq_enable((uint32_t)idx);
+
+    return USART_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: uart_rx_dma_stop()
+ ********************************************************************************
+ * Summary:
+ *   Stops the DMA reception started with uart_rx_dma_start().
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *
+ * Return :
+ *  usart_status_e_t:   Status of the operation
+ *
+ *******************************************************************************/
+usart_status_e_t uart_rx_dma_stop(usart_config_st_t *usart_cfg)
+{
+    int32_t idx = usart_get_inst_idx(usart_cfg->instance);
+
+    if (idx < 0)
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    usart_cfg->instance->CR1 &= (uint32_t)(~(USART_CR1_IDLEIE_Msk));
+    usart_cfg->instance->CR3 &= (uint32_t)(~(USART_CR3_DMAR_Msk | USART_CR3_EIE_Msk));
+
+    NVIC_DisableIRQ(dma_stream_get_irqn(usart_hw_map[idx].dma_rx_stream));
+    dma_stream_stop(usart_hw_map[idx].dma_rx_stream);
+
+    usart_set_event_handler((uint32_t)idx, USART_EVENT_IDLE, NULL, NULL);
+    usart_set_event_handler((uint32_t)idx, USART_EVENT_ERROR, NULL, NULL);
+    usart_ctx[idx].dma_rx_cb = NULL;
+
+    return USART_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: usart_ring_valid()
+ ********************************************************************************
+ * Summary:
+ *   Returns true if the storage can back a ring, a power of two size in range
+ *   [2, 32768]. Lets the users of a ring validate it before they touch the IRQ.
+ *
+ *******************************************************************************/
+static bool usart_ring_valid(const uint8_t *buff, uint16_t buff_size)
+{
+    return ((NULL != buff) && (buff_size >= 2U) && (0U == (buff_size & (buff_size - 1U))));
+}
+
+/*******************************************************************************
+ * Function Name: uart_ring_init()
+ ********************************************************************************
+ * Summary:
+ *   Initializes a lock-free SPSC byte ring on the supplied buffer.
+ *
+ * Parameters:
+ *   ring:           Pointer to the ring
+ *   buff:           Storage for the ring data
+ *   buff_size:      Size of the storage, a power of two in range [2, 32768]
+ *
+ * Return :
+ *  usart_status_e_t:   USART_STATUS_BAD_PARAM if the size is not valid
+ *
+ *******************************************************************************/
+usart_status_e_t uart_ring_init(uart_ring_st_t *ring, uint8_t *buff, uint16_t buff_size)
+{
+    if ((NULL == ring) || !usart_ring_valid(buff, buff_size))
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    ring->buff = buff;
+    ring->mask = (uint16_t)(buff_size - 1U);
+    ring->head = 0;
+    ring->tail = 0;
+
+    return USART_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: usart_ring_put()
+ ********************************************************************************
+ * Summary:
+ *   Copies data into the ring, in at most two chunks, and publishes it to the
+ *   consumer by advancing the head. The caller checks for the free space.
+ *
+ * Parameters:
+ *   ring:           Pointer to the ring
+ *   data:           Data to be stored
+ *   size:           Size of the data
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void usart_ring_put(uart_ring_st_t *ring, uint8_t *data, uint16_t size)
+{
+    uint16_t head = ring->head;
+    uint16_t pos = (uint16_t)(head & ring->mask);
+    uint16_t chunk = (uint16_t)((ring->mask + 1U) - pos);
+
+    if (chunk > size)
+    {
+        chunk = size;
+    }
+
+    memcpy(&ring->buff[pos], data, chunk);
+    memcpy(ring->buff, &data[chunk], (size_t)(size - chunk));
+
+    /* Data must be in memory before the consumer can see the new head */
+    __DMB();
+    ring->head = (uint16_t)(head + size);
+}
+
+/*******************************************************************************
+ * Function Name: usart_ring_get()
+ ********************************************************************************
+ * Summary:
+ *   Copies up to the requested number of bytes out of the ring, in at most two
+ *   chunks, and releases the space to the producer by advancing the tail.
+ *
+ * Parameters:
+ *   ring:           Pointer to the ring
+ *   data:           Destination for the data
+ *   size:           Max number of bytes to copy
+ *
+ * Return :
+ *   uint16_t:       Number of bytes copied
+ *
+ *******************************************************************************/
+static uint16_t usart_ring_get(uart_ring_st_t *ring, uint8_t *data, uint16_t size)
+{
+    uint16_t tail = ring->tail;
+    uint16_t count = (uint16_t)(ring->head - tail);
+    uint16_t pos = (uint16_t)(tail & ring->mask);
+    uint16_t chunk = (uint16_t)((ring->mask + 1U) - pos);
+
+    if (count > size)
+    {
+        count = size;
+    }
+
+    if (chunk > count)
+    {
+        chunk = count;
+    }
+
+    /* Head is read before the data, data must be read before the tail moves */
+    __DMB();
+
+    memcpy(data, &ring->buff[pos], chunk);
+    memcpy(&data[chunk], ring->buff, (size_t)(count - chunk));
+
+    __DMB();
+    ring->tail = (uint16_t)(tail + count);
+
+    return count;
+}
+
+/*******************************************************************************
+ * Function Name: usart_tx_async_txe_handler()
+ ********************************************************************************
+ * Summary:
+ *   TXE event handler of the buffered transmit, moves the next byte from the
+ *   ring to the data register. Once the ring is empty it waits for TC instead.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *   sr:                 USART_SR read on the interrupt entry
+ *   cb_arg:             Driver context of the instance
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void usart_tx_async_txe_handler(usart_config_st_t *usart_cfg, uint32_t sr, void *cb_arg)
+{
+    USART_TypeDef *instance = usart_cfg->instance;
+    uart_ring_st_t *ring = &((usart_ctx_st_t *)cb_arg)->tx_ring;
+    uint16_t tail = ring->tail;
+
+    if (tail != ring->head)
+    {
+        /* Writing DR clears TXE and TC */
+        instance->DR = ring->buff[tail & ring->mask];
+        ring->tail = (uint16_t)(tail + 1U);
+    }
+    else
+    {
+        /* Ring drained, wait for the last byte to leave the shift register */
+        instance->CR1 = (uint32_t)((instance->CR1 & (~USART_CR1_TXEIE_Msk)) | USART_CR1_TCIE_Msk);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: usart_tx_async_tc_handler()
+ ********************************************************************************
+ * Summary:
+ *   TC event handler of the buffered transmit, marks the line idle if no new
+ *   data was queued meanwhile.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *   sr:                 USART_SR read on the interrupt entry
+ *   cb_arg:             Driver context of the instance
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void usart_tx_async_tc_handler(usart_config_st_t *usart_cfg, uint32_t sr, void *cb_arg)
+{
+    usart_ctx_st_t *ctx = (usart_ctx_st_t *)cb_arg;
+    USART_TypeDef *instance = usart_cfg->instance;
+
+    instance->CR1 = (uint32_t)(instance->CR1 & (~USART_CR1_TCIE_Msk));
+
+    /* New data may have been queued meanwhile, TXE interrupt handles it */
+    if (ctx->tx_ring.tail == ctx->tx_ring.head)
+    {
+        ctx->tx_idle = true;
+
+        if (NULL != ctx->tx_idle_cb)
+        {
+            ctx->tx_idle_cb(usart_cfg);
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: uart_write_async_init()
+ ********************************************************************************
+ * Summary:
+ *   Initializes the interrupt driven buffered transmit of the USART, the Tx data
+ *   is queued into the supplied ring and drained by the TXE interrupt.
+ *
+ *   NOTE: The USART interrupt is enabled with USART_IRQ_PRIORITY by this
+ *   function, the TXE and TC events of the instance are handled by the lib.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *   tx_ring:            Storage for the Tx ring
+ *   tx_ring_size:       Size of the storage, a power of two
+ *
+ * Return :
+ *  usart_status_e_t:   Status of the operation
+ *
+ *******************************************************************************/
+usart_status_e_t uart_write_async_init(usart_config_st_t *usart_cfg, uint8_t *tx_ring,
+                                       uint16_t tx_ring_size)
+{
+    int32_t idx = usart_get_inst_idx(usart_cfg->instance);
+    usart_status_e_t status = USART_STATUS_SUCCESS;
+
+    /* Validated before the IRQ is disabled, an error leaves the IRQ as it was */
+    if ((idx < 0) || !usart_ring_valid(tx_ring, tx_ring_size))
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    NVIC_DisableIRQ(usart_hw_map[idx].irqn);
+
+    status = uart_ring_init(&usart_ctx[idx].tx_ring, tx_ring, tx_ring_size);
+    if (USART_STATUS_SUCCESS != status)
+    {
+        return status;
+    }
+
+    usart_ctx[idx].usart_cfg = usart_cfg;
+    usart_ctx[idx].tx_idle = true;
+
+    usart_cfg->instance->CR1 &= (uint32_t)(~(USART_CR1_TXEIE_Msk | USART_CR1_TCIE_Msk));
+
+    usart_set_event_handler((uint32_t)idx, USART_EVENT_TXE, usart_tx_async_txe_handler,
+                            &usart_ctx[idx]);
+    usart_set_event_handler((uint32_t)idx, USART_EVENT_TC, usart_tx_async_tc_handler,
+                            &usart_ctx[idx]);
+
+    usart_irq_enable((uint32_t)idx);
+
+    return USART_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: uart_write_async()
+ ********************************************************************************
+ * Summary:
+ *   Queues the data for transmission and returns without waiting, the data is
+ *   sent in background by the TXE interrupt. The data is either queued fully
+ *   or not at all.
+ *
+ *   NOTE: Only one context (thread or ISR) should write to an instance.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *   tx_buff:            Pointer to buffer of Tx data
+ *   tx_buff_size:       Size of the TX data buffer
+ *
+ * Return :
+ *  usart_status_e_t:   UART_STATUS_TRANSMIT_BUSY if not enough space in ring
+ *
+ *******************************************************************************/
+usart_status_e_t uart_write_async(usart_config_st_t *usart_cfg, uint8_t *tx_buff,
+                                  uint16_t tx_buff_size)
+{
+    int32_t idx = usart_get_inst_idx(usart_cfg->instance);
+    uart_ring_st_t *ring = NULL;
+
+    if ((idx < 0) || (NULL == usart_ctx[idx].tx_ring.buff) || (NULL == tx_buff))
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    ring = &usart_ctx[idx].tx_ring;
+
+    if (tx_buff_size > (uint16_t)(ring->mask + 1U))
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    if (tx_buff_size > uart_ring_free(ring))
+    {
+        return UART_STATUS_TRANSMIT_BUSY;
+    }
+
+    usart_ring_put(ring, tx_buff, tx_buff_size);
+
+    usart_ctx[idx].tx_idle = false;
+
+    /* TXE interrupt takes over from here */
+    usart_cr1_modify(usart_cfg->instance, 0U, USART_CR1_TXEIE_Msk);
+
+    return USART_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: uart_write_async_register_idle_cb()
+ ********************************************************************************
+ * Summary:
+ *   Registers the callback of the buffered transmit called once the Tx line
+ *   goes idle, from the USART ISR. Call after uart_write_async_init().
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *   idle_cb:            Callback, NULL to remove it
+ *
+ * Return :
+ *  usart_status_e_t:   Status of the operation
+ *
+ *******************************************************************************/
+usart_status_e_t uart_write_async_register_idle_cb(usart_config_st_t *usart_cfg,
+                                                  uart_tx_idle_cb_t idle_cb)
+{
+    int32_t idx = usart_get_inst_idx(usart_cfg->instance);
+
+    if (idx < 0)
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    usart_ctx[idx].tx_idle_cb = idle_cb;
+
+    return USART_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: uart_tx_idle()
+ ********************************************************************************
+ * Summary:
+ *   Checks whether all the data queued with uart_write_async() has been sent
+ *   out completely on the line, including the stop bits of the last byte.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *
+ * Return :
+ *  bool:               true if the Tx line is idle
+ *
+ *******************************************************************************/
+bool uart_tx_idle(usart_config_st_t *usart_cfg)
+{
+    int32_t idx = usart_get_inst_idx(usart_cfg->instance);
+
+    return (idx >= 0) ? (usart_ctx[idx].tx_idle) : (true);
+}
+
+/*******************************************************************************
+ * Function Name: uart_flush()
+ ********************************************************************************
+ * Summary:
+ *   Waits till all the data queued with uart_write_async() is sent out on the
+ *   line. Must not be called from an ISR with priority equal or higher than
+ *   USART_IRQ_PRIORITY.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+void uart_flush(usart_config_st_t *usart_cfg)
+{
+    while (!uart_tx_idle(usart_cfg))
+        ;
+}
+
+/*******************************************************************************
+ * Function Name: usart_rx_ring_rxne_handler()
+ ********************************************************************************
+ * Summary:
+ *   RXNE event handler of the ring reception, the received byte is stored into
+ *   the ring, or dropped and counted if the ring is full.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *   sr:                 USART_SR read on the interrupt entry
+ *   cb_arg:             Driver context of the instance
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void usart_rx_ring_rxne_handler(usart_config_st_t *usart_cfg, uint32_t sr, void *cb_arg)
+{
+    usart_ctx_st_t *ctx = (usart_ctx_st_t *)cb_arg;
+    uart_ring_st_t *ring = &ctx->rx_ring;
+    uint16_t head = ring->head;
+    uint16_t count = (uint16_t)(head - ring->tail);
+    uint8_t data = 0;
+
+    /* Ring almost full, leave the byte in DR and stop the interrupt, the USART
+     * deasserts RTS till DR is read. uart_read() resumes the reception.
+     */
+    if (ctx->rx_flow_ctrl && (count >= ctx->rx_flow_stop_lvl))
+    {
+        usart_cfg->instance->CR1 = (uint32_t)(usart_cfg->instance->CR1 & (~USART_CR1_RXNEIE_Msk));
+        ctx->rx_flow_stopped = true;
+        ctx->rx_stats.flow_stop_cnt++;
+        return;
+    }
+
+    /* Reading DR clears RXNE, and ORE as SR was read before */
+    data = (uint8_t)usart_cfg->instance->DR;
+
+    if (sr & USART_SR_ORE_Msk)
+    {
+        ctx->rx_stats.hw_overrun_cnt++;
+    }
+
+    if (count > ring->mask)
+    {
+        ctx->rx_stats.ring_overrun_cnt++;
+        return;
+    }
+
+    ring->buff[head & ring->mask] = data;
+
+    /* Data must be in memory before the consumer can see the new head */
+    __DMB();
+    ring->head = (uint16_t)(head + 1U);
+
+    if (count >= ctx->rx_stats.high_watermark)
+    {
+        ctx->rx_stats.high_watermark = (uint16_t)(count + 1U);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: uart_rx_ring_start()
+ ********************************************************************************
+ * Summary:
+ *   Starts the interrupt driven reception into the supplied ring, each byte is
+ *   stored by the RXNE interrupt and read in thread context with uart_read().
+ *
+ *   With RTS flow control enabled in usart_cfg->hwflowctrl, the reception is
+ *   stopped at USART_RX_FLOW_STOP_LVL_EIGHTHS of the ring and RTS deasserted,
+ *   so no byte is lost even if the thread falls behind.
+ *
+ *   NOTE: The USART interrupt is enabled with USART_IRQ_PRIORITY by this
+ *   function, the RXNE event of the instance is handled by the lib.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *   rx_ring:            Storage for the Rx ring
+ *   rx_ring_size:       Size of the storage, a power of two
+ *
+ * Return :
+ *  usart_status_e_t:   Status of the operation
+ *
+ *******************************************************************************/
+usart_status_e_t uart_rx_ring_start(usart_config_st_t *usart_cfg, uint8_t *rx_ring,
+                                    uint16_t rx_ring_size)
+{
+    int32_t idx = usart_get_inst_idx(usart_cfg->instance);
+    usart_status_e_t status = USART_STATUS_SUCCESS;
+
+    /* Validated before the IRQ is disabled, an error leaves the IRQ as it was */
+    if ((idx < 0) || !usart_ring_valid(rx_ring, rx_ring_size))
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    NVIC_DisableIRQ(usart_hw_map[idx].irqn);
+
+    status = uart_ring_init(&usart_ctx[idx].rx_ring, rx_ring, rx_ring_size);
+    if (USART_STATUS_SUCCESS != status)
+    {
+        return status;
+    }
+
+    usart_ctx[idx].usart_cfg = usart_cfg;
+    memset(&usart_ctx[idx].rx_stats, 0, sizeof(usart_ctx[idx].rx_stats));
+
+    /* Throttle the peer through RTS before the ring fills */
+    usart_ctx[idx].rx_flow_ctrl = (USART_FLOWCTRL_RTS_EN == usart_cfg->hwflowctrl) ||
+                                  (USART_FLOWCTRL_RTS_CTS_BOTH_EN == usart_cfg->hwflowctrl);
+    usart_ctx[idx].rx_flow_stop_lvl =
+        (uint16_t)(((uint32_t)rx_ring_size * USART_RX_FLOW_STOP_LVL_EIGHTHS) / 8U);
+    usart_ctx[idx].rx_flow_resume_lvl =
+        (uint16_t)(((uint32_t)rx_ring_size * USART_RX_FLOW_RESUME_LVL_EIGHTHS) / 8U);
+    usart_ctx[idx].rx_flow_stopped = false;
+
+    usart_set_event_handler((uint32_t)idx, USART_EVENT_RXNE, usart_rx_ring_rxne_handler,
+                            &usart_ctx[idx]);
+
+    usart_cr1_modify(usart_cfg->instance, 0U, USART_CR1_RXNEIE_Msk);
+
+    usart_irq_enable((uint32_t)idx);
+
+    return USART_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: uart_read()
+ ********************************************************************************
+ * Summary:
+ *   Reads all the received bytes available in the Rx ring, up to the size of
+ *   the buffer, and returns without waiting. Lock-free, safe to be called while
+ *   the Rx interrupt is storing data. With RTS flow control the reception
+ *   stopped on a full ring is resumed once the ring is drained enough.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *   rx_buff:            Pointer to buffer to store Rx data
+ *   rx_buff_size:       Size of the RX data buffer
+ *
+ * Return :
+ *  uint16_t:           Number of bytes read, 0 if no data available
+ *
+ *******************************************************************************/
+uint16_t uart_read(usart_config_st_t *usart_cfg, uint8_t *rx_buff, uint16_t rx_buff_size)
+{
+    int32_t idx = usart_get_inst_idx(usart_cfg->instance);
+
+    usart_ctx_st_t *ctx = NULL;
+    uint16_t rx_len = 0;
+
+    if ((idx < 0) || (NULL == usart_ctx[idx].rx_ring.buff) || (NULL == rx_buff))
+    {
+        return 0;
+    }
+
+    ctx = &usart_ctx[idx];
+    rx_len = usart_ring_get(&ctx->rx_ring, rx_buff, rx_buff_size);
+
+    /* Resume the reception stopped by RTS flow control, the ISR can't set the
+     * flag again before RXNEIE is set.
+     */
+    if (ctx->rx_flow_stopped && (uart_ring_count(&ctx->rx_ring) <= ctx->rx_flow_resume_lvl))
+    {
+        ctx->rx_flow_stopped = false;
+        usart_cr1_modify(usart_cfg->instance, 0U, USART_CR1_RXNEIE_Msk);
+    }
+
+    return rx_len;
+}
+
+/*******************************************************************************
+ * Function Name: uart_rx_ring_get_stats()
+ ********************************************************************************
+ * Summary:
+ *   Returns the Rx ring statistics, bytes dropped because the ring was full,
+ *   bytes lost in hardware overrun, and the max fill level seen of the ring.
+ *
+ * Parameters:
+ *   usart_cfg:          Pointer to USART configs
+ *   rx_stats:           Filled with the statistics
+ *
+ * Return :
+ *  usart_status_e_t:   Status of the operation
+ *
+ *******************************************************************************/
+usart_status_e_t uart_rx_ring_get_stats(usart_config_st_t *usart_cfg,
+                                        uart_rx_stats_st_t *rx_stats)
+{
+    int32_t idx = usart_get_inst_idx(usart_cfg->instance);
+
+    if ((idx < 0) || (NULL == rx_stats))
+    {
+        return USART_STATUS_BAD_PARAM;
+    }
+
+    /* Counters are written by the ISR only, a torn read is not possible for
+     * the aligned 32-bit and 16-bit fields.
+     */
+    *rx_stats = usart_ctx[idx].rx_stats;
+
+    return USART_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: usart_event_mute()
+ ********************************************************************************
+ * Summary:
+ *   Clears an enabled event which has no handler, to avoid the interrupt from
+ *   re-triggering for ever.
+ *
+ * Parameters:
+ *   instance:       USART/UART instance
+ *   event:          Interrupt event
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void usart_event_mute(USART_TypeDef *instance, usart_event_e_t event)
+{
+    if (USART_EVENT_TXE == event)
+    {
+        instance->CR1 = (uint32_t)(instance->CR1 & (~USART_CR1_TXEIE_Msk));
+    }
+    else if (USART_EVENT_TC == event)
+    {
+        instance->CR1 = (uint32_t)(instance->CR1 & (~USART_CR1_TCIE_Msk));
+    }
+    else
+    {
+        /* RXNE, IDLE and error flags are cleared by reading SR followed by DR */
+        (void)instance->DR;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: usart_event_call()
+ ********************************************************************************
+ * Summary:
+ *   Calls the handler registered for the event of the instance.
+ *
+ * Parameters:
+ *   ctx:            Driver context of the instance
+ *   instance:       USART/UART instance
+ *   event:          Interrupt event
+ *   sr:             USART_SR read on the interrupt entry
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static __inline void usart_event_call(usart_ctx_st_t *ctx, USART_TypeDef *instance,
+                                      usart_event_e_t event, uint32_t sr)
+{
+    usart_event_handler_st_t *handler = &ctx->event[event];
+
+    if (NULL != handler->cb)
+    {
+        handler->cb(ctx->usart_cfg, sr, handler->cb_arg);
+    }
+    else
+    {
+        usart_event_mute(instance, event);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: usart_irq_dispatch()
+ ********************************************************************************
+ * Summary:
+ *   Common USART ISR, dispatches the pending and enabled events to the handlers
+ *   of the instance. The context and the instance are constants in each
+ *   USARTx_IRQHandler, so no lookup is done on the interrupt path. SR, CR1 and
+ *   CR3 are read once, Rx events are served before the Tx events.
+ *
+ * Parameters:
+ *   ctx:            Driver context of the instance
+ *   instance:       USART/UART instance
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void usart_irq_dispatch(usart_ctx_st_t *ctx, USART_TypeDef *instance)
+{
+    uint32_t sr = instance->SR;
+    uint32_t cr1 = instance->CR1;
+    uint32_t cr3 = instance->CR3;
+
+    /* Overrun also raises the RXNE interrupt */
+    if ((cr1 & USART_CR1_RXNEIE_Msk) && (sr & (USART_SR_RXNE_Msk | USART_SR_ORE_Msk)))
+    {
+        usart_event_call(ctx, instance, USART_EVENT_RXNE, sr);
+    }
+
+    if (((cr3 & USART_CR3_EIE_Msk) &&
+         (sr & (USART_SR_ORE_Msk | USART_SR_NE_Msk | USART_SR_FE_Msk))) ||
+        ((cr1 & USART_CR1_PEIE_Msk) && (sr & USART_SR_PE_Msk)))
+    {
+        usart_event_call(ctx, instance, USART_EVENT_ERROR, sr);
+    }
+
+    if ((cr1 & USART_CR1_IDLEIE_Msk) && (sr & USART_SR_IDLE_Msk))
+    {
+        usart_event_call(ctx, instance, USART_EVENT_IDLE, sr);
+    }
+
+    if ((cr1 & USART_CR1_TXEIE_Msk) && (sr & USART_SR_TXE_Msk))
+    {
+        usart_event_call(ctx, instance, USART_EVENT_TXE, sr);
+    }
+
+    if ((cr1 & USART_CR1_TCIE_Msk) && (sr & USART_SR_TC_Msk))
+    {
+        usart_event_call(ctx, instance, USART_EVENT_TC, sr);
+    }
+}
+
+/*******************************************************************************
+ * USART IRQ handlers, see usart_hw_map for the context index of the instance.
+ *******************************************************************************/
+void USART1_IRQHandler(void)
+{
+    usart_irq_dispatch(&usart_ctx[0], USART1);
+}
+
+void USART2_IRQHandler(void)
+{
+    usart_irq_dispatch(&usart_ctx[1], USART2);
+}
+
+void USART3_IRQHandler(void)
+{
+    usart_irq_dispatch(&usart_ctx[2], USART3);
+}
+
+void UART4_IRQHandler(void)
+{
+    usart_irq_dispatch(&usart_ctx[3], UART4);
+}
+
+void UART5_IRQHandler(void)
+{
+    usart_irq_dispatch(&usart_ctx[4], UART5);
+}
+
+void USART6_IRQHandler(void)
+{
+    usart_irq_dispatch(&usart_ctx[5], USART6);
+}
+
+/*******************************************************************************
+ * DMA stream IRQ handlers used for USART Tx, see usart_hw_map for the mapping.
+ *******************************************************************************/
+void DMA2_Stream7_IRQHandler(void)
+{
+    usart_dma_tx_isr(0U);
+}
+
+void DMA1_Stream6_IRQHandler(void)
+{
+    usart_dma_tx_isr(1U);
+}
+
+void DMA1_Stream3_IRQHandler(void)
+{
+    usart_dma_tx_isr(2U);
+}
+
+void DMA1_Stream4_IRQHandler(void)
+{
+    usart_dma_tx_isr(3U);
+}
+
+void DMA1_Stream7_IRQHandler(void)
+{
+    usart_dma_tx_isr(4U);
+}
+
+void DMA2_Stream6_IRQHandler(void)
+{
+    usart_dma_tx_isr(5U);
+}
+
+/*******************************************************************************
+ * DMA stream IRQ handlers used for USART Rx, see usart_hw_map for the mapping.
+ *******************************************************************************/
+void DMA2_Stream2_IRQHandler(void)
+{
+    usart_dma_rx_isr(0U);
+}
+
+void DMA1_Stream5_IRQHandler(void)
+{
+    usart_dma_rx_isr(1U);
+}
+
+void DMA1_Stream1_IRQHandler(void)
+{
+    usart_dma_rx_isr(2U);
+}
+
+void DMA1_Stream2_IRQHandler(void)
+{
+    usart_dma_rx_isr(3U);
+}
+
+void DMA1_Stream0_IRQHandler(void)
+{
+    usart_dma_rx_isr(4U);
+}
+
+void DMA2_Stream1_IRQHandler(void)
+{
+    usart_dma_rx_isr(5U);
+}
+
 /* End of File */
@@ -14,7 +14,7 @@
 * Header Files
 *******************************************************************************/
 #include <stdint.h>
-#include <math.h>
+#include <stddef.h>
 
 #include "stm32f4xx.h"
 #include <stdbool.h>
@@ -22,6 +22,8 @@
 #include "bsp_aj_stm32f4.h"
 #include "gpio_aj_stm32f4.h"
 #include "rcc_aj_stm32f4.h"
+#include "dma_aj_stm32f4.h"
+#include "utils_aj_stm32f4.h"
 
 #ifdef  __STM32F407xx_H
 #include "stm32f407xx.h"
@@ -40,6 +42,67 @@
 #define USART_PARITY_EVEN                   (0U)
 #define USART_PARITY_ODD                    (1U)
 
+/*
+ * Baud rate divider, integer only and usable in constant expressions.
+ *
+ * baud = fck / (8 * (2 - OVER8) * USARTDIV), the BRR holds USARTDIV in 1/16
+ * (OVER8 = 0) or 1/8 (OVER8 = 1) units, so in both cases the divider in those
+ * units is fck/baud, rounded to nearest:
+ *  - OVER8 = 0: BRR = divider
+ *  - OVER8 = 1: BRR = mantissa (divider / 8) << 4 | fraction (divider % 8)
+ */
+#define USART_DIV_CALC(fck, baud)           (((fck) + ((baud) / 2U)) / (baud))
+
+#define USART_BRR_CALC(fck, baud, over8)    ((over8) ?                                      \
+                                            (((USART_DIV_CALC(fck, baud) >> 3U) << 4U) |    \
+                                             (USART_DIV_CALC(fck, baud) & 0x7U)) :          \
+                                            (USART_DIV_CALC(fck, baud)))
+
+/* Error of the achieved baud rate in ppm, |fck/div - baud| / baud */
+#define USART_BAUD_ERR_PPM(fck, baud)                                                   \
+        ((((fck) > (USART_DIV_CALC(fck, baud) * (baud))) ?                              \
+          ((fck) - (USART_DIV_CALC(fck, baud) * (baud))) :                              \
+          ((USART_DIV_CALC(fck, baud) * (baud)) - (fck))) * 1000000ULL /                \
+         (USART_DIV_CALC(fck, baud) * (baud)))
+
+/* Max baud rate error accepted, the receiver tolerance is shared by both ends
+ * of the link, keeping each end within 2% leaves margin for the clock drift.
+ */
+#define USART_BAUD_ERR_MAX_PPM              (20000U)
+
+/* Fails the build if the baud rate can't be generated from the clock within
+ * USART_BAUD_ERR_MAX_PPM, ex: USART_BAUD_STATIC_CHECK(uart1_baud, 100000000, 115200);
+ */
+#define USART_BAUD_STATIC_CHECK(name, fck, baud)                                        \
+        typedef char name[(USART_BAUD_ERR_PPM(fck, baud) <= USART_BAUD_ERR_MAX_PPM) ? (1) : (-1)]
+
+/* Timeout value for the polling APIs to wait without a time limit */
+#define USART_TIMEOUT_WAIT_FOREVER          (DEADLINE_WAIT_FOREVER)
+
+/* Number of USART/UART instances, USART1/2/3/6 and UART4/5 */
+#define USART_INST_NUM                      (6U)
+/* Fill levels of the Rx ring, in eighths of the ring size, at which the ring
+ * reception stops and resumes reading the data register when RTS flow control
+ * is enabled. While stopped the received byte is left in DR, the USART keeps
+ * RTS deasserted till it is read, so the peer pauses before the ring fills.
+ */
+#define USART_RX_FLOW_STOP_LVL_EIGHTHS      (6U)
+#define USART_RX_FLOW_RESUME_LVL_EIGHTHS    (2U)
+
+/* Auto-baud detection, the peer sends the sync character 'U' (0x55), which
+ * has a falling edge every 2 bit times, the first 5 falling edges of it span 8
+ * bit times. The rate is measured by the input capture of a timer on the Rx pin.
+ */
+#define USART_AUTOBAUD_SYNC_CHAR            (0x55U)
+#define USART_AUTOBAUD_EDGE_CNT             (5U)
+/* Lowest rate detected, sets the timer prescaler, a lower value costs resolution */
+#define USART_AUTOBAUD_MIN_BAUD             (1200U)
+
+/* NVIC priority of the USART and it's DMA stream interrupts, the lib expects
+ * these to be the same, so that they do not pre-empt each other.
+ */
+#define USART_IRQ_PRIORITY                  (5U)
+
 /*******************************************************************************
  * Global Variables
  *******************************************************************************/
@@ -75,6 +138,27 @@ typedef enum usart_stopbit_e
     USART_STOPBIT_1_5,
 } usart_stopbit_e_t;
 
+/* Lock-free single producer/single consumer byte ring, the size of the ring
+ * must be a power of two. The head is only written by the producer and the tail
+ * only by the consumer, the indices run freely and are masked on access.
+ */
+typedef struct uart_ring_st
+{
+    uint8_t *buff;
+    uint16_t mask;
+    volatile uint16_t head;
+    volatile uint16_t tail;
+} uart_ring_st_t;
+
+/* Statistics of the interrupt driven Rx ring */
+typedef struct uart_rx_stats_st
+{
+    uint32_t ring_overrun_cnt;
+    uint32_t hw_overrun_cnt;
+    uint32_t flow_stop_cnt;
+    uint16_t high_watermark;
+} uart_rx_stats_st_t;
+
 typedef struct usart_config_st
 {
     usart_compatible_mode_e_t compatmode;
@@ -89,6 +173,19 @@ typedef struct usart_config_st
     bool parity;
 } usart_config_st_t;
 
+/* Timer used for the auto-baud detection, a channel of the timer must be on
+ * the Rx pin, ex: TIM1 CH3 AF1 for USART1 Rx on PA10, TIM9 CH2 AF3 for USART2
+ * Rx on PA3, TIM4 CH2 AF2 for USART1 Rx on PB7. The timer is reprogrammed and
+ * stopped by the detection, so it can't be the timebase TIMEBASE_TIM_INST
+ * (TIM5) nor the delay timer DELAY_TIM_INST (TIM2) of the TIM delay backend.
+ */
+typedef struct usart_autobaud_cfg_st
+{
+    TIM_TypeDef *TIMx;
+    uint8_t tim_channel;    /* 1 to 4 */
+    uint8_t tim_af;         /* AF number of the channel on the Rx pin */
+} usart_autobaud_cfg_st_t;
+
 typedef enum usart_status_e
 {
     USART_STATUS_SUCCESS,
@@ -96,23 +193,148 @@ typedef enum usart_status_e
     USART_STATUS_BAD_PARAM,
     UART_STATUS_RECEIVE_BUSY,
     UART_STATUS_TRANSMIT_BUSY,
+    UART_STATUS_TIMEOUT,
 } usart_status_e_t;
 
+/* Interrupt events of a USART instance, dispatched by the USARTx_IRQHandler
+ * of the lib to the handler registered for the event.
+ */
+typedef enum usart_event_e
+{
+    USART_EVENT_RXNE,
+    USART_EVENT_TXE,
+    USART_EVENT_TC,
+    USART_EVENT_IDLE,
+    USART_EVENT_ERROR,
+    USART_EVENT_NUM,
+} usart_event_e_t;
+
+/* Called from the USART ISR for a registered event, sr is the value of USART_SR
+ * read on the interrupt entry. The callback must clear the event, ex: read DR
+ * for RXNE/IDLE/ERROR or disable the interrupt for TXE/TC.
+ */
+typedef void (*usart_event_cb_t)(usart_config_st_t *usart_cfg, uint32_t sr, void *cb_arg);
+
+/* Segment of a scatter-gather transmit, see uart_transmit_v() */
+typedef struct uart_iovec_st
+{
+    uint8_t *buff;
+    uint16_t size;
+} uart_iovec_st_t;
+
+/* Called from DMA ISR once a buffer passed to uart_transmit_dma() is sent, or
+ * all the segments passed to uart_transmit_v(), tx_buff is the first segment.
+ */
+typedef void (*uart_dma_tx_cb_t)(usart_config_st_t *usart_cfg, uint8_t *tx_buff,
+                                 usart_status_e_t status);
+
+/* Called from ISR with received data, pointing into the DMA Rx ring, frame_end
+ * is set for the last chunk of a frame i.e. when the Rx line went idle.
+ */
+typedef void (*uart_rx_dma_cb_t)(usart_config_st_t *usart_cfg, uint8_t *rx_data,
+                                 uint16_t rx_data_size, bool frame_end);
+
+/* Called from the USART ISR once the data queued with uart_write_async() is
+ * sent out and the Tx ring is empty, it may queue more data.
+ */
+typedef void (*uart_tx_idle_cb_t)(usart_config_st_t *usart_cfg);
+
 /*******************************************************************************
  * Function Prototypes
  *******************************************************************************/
 usart_status_e_t usart_config(usart_config_st_t *usart_cfg, GPIO_TypeDef *tx_GPIOx,
                               uint8_t tx_gpio_pin, GPIO_TypeDef *rx_GPIOx, uint8_t rx_gpio_pin);
 
+usart_status_e_t usart_autobaud_detect(usart_config_st_t *usart_cfg, GPIO_TypeDef *rx_GPIOx,
+                                       uint8_t rx_gpio_pin, const usart_autobaud_cfg_st_t *ab_cfg,
+                                       uint32_t timeout_milsec, uint32_t *measured_baud);
+
+usart_status_e_t usart_flowctrl_config(usart_config_st_t *usart_cfg, GPIO_TypeDef *cts_GPIOx,
+                                       uint8_t cts_gpio_pin, GPIO_TypeDef *rts_GPIOx,
+                                       uint8_t rts_gpio_pin);
+
+usart_status_e_t usart_calc_brr(uint32_t fck, uint32_t baudrate, bool oversample,
+                                uint32_t *brr, uint32_t *baud_err_ppm);
+
 usart_status_e_t usart_init(usart_config_st_t *usart_cfg);
 usart_status_e_t usart_deinit(usart_config_st_t *usart_cfg);
 
 usart_status_e_t uart_receive_poll(usart_config_st_t *usart_cfg, uint8_t *rx_buff,
-                                   uint16_t rx_buff_size, uint32_t timeout_milsec);
+                                   uint16_t rx_buff_size, uint32_t timeout_milsec,
+                                   uint16_t *rx_size);
 
 usart_status_e_t uart_transmit_blocking(usart_config_st_t *usart_cfg, uint8_t *tx_buff,
-                                        uint16_t tx_buff_size, uint32_t timeout_milsec);
+                                        uint16_t tx_buff_size, uint32_t timeout_milsec,
+                                        uint16_t *tx_size);
 
 usart_status_e_t uart_rx_interrupt_set(USART_TypeDef *uart_inst, bool rx_int_en);
 
+usart_status_e_t usart_register_callback(usart_config_st_t *usart_cfg, usart_event_e_t event,
+                                         usart_event_cb_t event_cb, void *cb_arg);
+
+usart_status_e_t usart_event_enable(usart_config_st_t *usart_cfg, usart_event_e_t event,
+                                    bool event_en);
+
+usart_status_e_t uart_dma_tx_init(usart_config_st_t *usart_cfg, uart_dma_tx_cb_t tx_done_cb);
+
+usart_status_e_t uart_transmit_dma(usart_config_st_t *usart_cfg, uint8_t *tx_buff,
+                                   uint16_t tx_buff_size);
+
+usart_status_e_t uart_transmit_v(usart_config_st_t *usart_cfg, const uart_iovec_st_t *iov,
+                                 uint8_t iov_cnt);
+
+bool uart_dma_tx_busy(usart_config_st_t *usart_cfg);
+
+usart_status_e_t uart_rx_dma_start(usart_config_st_t *usart_cfg, uint8_t *rx_ring,
+                                   uint16_t rx_ring_size, uart_rx_dma_cb_t rx_cb);
+
+usart_status_e_t uart_rx_dma_stop(usart_config_st_t *usart_cfg);
+
+usart_status_e_t uart_ring_init(uart_ring_st_t *ring, uint8_t *buff, uint16_t buff_size);
+
+usart_status_e_t uart_write_async_init(usart_config_st_t *usart_cfg, uint8_t *tx_ring,
+                                       uint16_t tx_ring_size);
+
+usart_status_e_t uart_write_async(usart_config_st_t *usart_cfg, uint8_t *tx_buff,
+                                  uint16_t tx_buff_size);
+
+usart_status_e_t uart_write_async_register_idle_cb(usart_config_st_t *usart_cfg,
+                                                  uart_tx_idle_cb_t idle_cb);
+
+bool uart_tx_idle(usart_config_st_t *usart_cfg);
+
+void uart_flush(usart_config_st_t *usart_cfg);
+
+usart_status_e_t uart_rx_ring_start(usart_config_st_t *usart_cfg, uint8_t *rx_ring,
+                                    uint16_t rx_ring_size);
+
+uint16_t uart_read(usart_config_st_t *usart_cfg, uint8_t *rx_buff, uint16_t rx_buff_size);
+
+usart_status_e_t uart_rx_ring_get_stats(usart_config_st_t *usart_cfg,
+                                        uart_rx_stats_st_t *rx_stats);
+
+/*******************************************************************************
+ * Function Name: uart_ring_count()
+ ********************************************************************************
+ * Summary:
+ *   Returns the number of bytes stored in the ring.
+ *
+ *******************************************************************************/
+static __inline uint16_t uart_ring_count(uart_ring_st_t *ring)
+{
+    return (uint16_t)(ring->head - ring->tail);
+}
+
+/*******************************************************************************
+ * Function Name: uart_ring_free()
+ ********************************************************************************
+ * Summary:
+ *   Returns the number of bytes which can be stored in the ring.
+ *
+ *******************************************************************************/
+static __inline uint16_t uart_ring_free(uart_ring_st_t *ring)
+{
+    return (uint16_t)((ring->mask + 1U) - (uint16_t)(ring->head - ring->tail));
+}
+
 #endif /* USART_AJ_STM32F4 */
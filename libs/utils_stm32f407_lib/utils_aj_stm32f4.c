@@ -1 +1,178 @@
-/* TO DO */
+/*******************************************************************************
+* File Name: utils_aj_stm32f4.c
+*
+* Description:
+* The file contains function definition(s) for utility functions for the
+* STM32f407 libs.
+*
+* Related Document: See README.md
+*
+*******************************************************************************/
+#include "utils_aj_stm32f4.h"
+#include "rcc_aj_stm32f4.h"
+
+/*******************************************************************************
+* Global Variables
+*******************************************************************************/
+/* Will be initialized by the timestamp_init() */
+timestamp_st_t timestamp_ext = {0, 0, 0, 1U};
+
+static void timestamp_tick(void);
+
+/*******************************************************************************
+* Function Name: deadline_start()
+********************************************************************************
+* Summary:
+*   Starts a deadline of the specified time from now, the deadline is tracked
+*   on the free running DWT cycle counter, no timer or interrupt is needed.
+*
+* Parameters:
+*   deadline:       Pointer to the deadline to start
+*   timeout_milsec: Time in ms till the deadline, DEADLINE_WAIT_FOREVER for a
+*                   deadline which never expires.
+*
+* Return :
+*   void
+*
+*******************************************************************************/
+void deadline_start(deadline_st_t *deadline, uint32_t timeout_milsec)
+{
+    cyccnt_init();
+
+    deadline->start = cyccnt_get();
+    /* The cycle counter runs from HCLK */
+    deadline->cycles_per_milsec = get_ahb_clock() / 1000U;
+    deadline->remaining_milsec = timeout_milsec;
+}
+
+/*******************************************************************************
+* Function Name: deadline_expired()
+********************************************************************************
+* Summary:
+*   Checks whether the deadline has expired. Elapsed time is consumed in whole
+*   ms steps, so the 32-bit cycle counter wrap (~42 s at 100 MHz) does not limit
+*   the timeout, as long as this is called at least once per counter wrap.
+*
+* Parameters:
+*   deadline:       Pointer to the deadline
+*
+* Return :
+*   bool:           true if the deadline has expired
+*
+*******************************************************************************/
+bool deadline_expired(deadline_st_t *deadline)
+{
+    uint32_t now = cyccnt_get();
+
+    if (DEADLINE_WAIT_FOREVER == deadline->remaining_milsec)
+    {
+        return false;
+    }
+
+    while ((now - deadline->start) >= deadline->cycles_per_milsec)
+    {
+        if (0U == deadline->remaining_milsec)
+        {
+            break;
+        }
+
+        deadline->start += deadline->cycles_per_milsec;
+        deadline->remaining_milsec--;
+    }
+
+    return (0U == deadline->remaining_milsec);
+}
+
+/*******************************************************************************
+* Function Name: timestamp_init()
+********************************************************************************
+* Summary:
+*   Starts the 64-bit timestamp on the DWT cycle counter, the timebase of
+*   timebase_init() is started if it is not running and it's tick counts the
+*   cycle counter wraps. The core clock for the conversion to us is cached. Must
+*   be called again if the clocks are changed.
+*
+* Parameters:
+*   void
+*
+* Return :
+*   void
+*
+*******************************************************************************/
+void timestamp_init(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t cycles_per_usec = get_ahb_clock() / 1000000U;
+
+    cyccnt_init();
+
+    if (!timebase_is_running())
+    {
+        timebase_init();
+    }
+
+    __disable_irq();
+
+    /* Counter is not reset, the deadlines running on it are not disturbed */
+    timestamp_ext.base_cycles = cyccnt_get();
+    timestamp_ext.last_cycles = timestamp_ext.base_cycles;
+    timestamp_ext.high = 0;
+    timestamp_ext.cycles_per_usec = (0U != cycles_per_usec) ? (cycles_per_usec) : (1U);
+
+    __set_PRIMASK(primask);
+
+    timebase_tick_start(timestamp_tick, TIMESTAMP_TICK_US);
+}
+
+/*******************************************************************************
+* Function Name: timestamp_tick()
+********************************************************************************
+* Summary:
+*   Tick of the timestamp, called from the timebase ISR. Counts a wrap of the
+*   cycle counter when it is lower than at the last tick, the count and the
+*   cycle counter are updated with IRQs masked for the readers in higher
+*   priority ISRs.
+*
+* Parameters:
+*   void
+*
+* Return :
+*   void
+*
+*******************************************************************************/
+static void timestamp_tick(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t now = 0;
+
+    __disable_irq();
+
+    now = cyccnt_get();
+    if (now < timestamp_ext.last_cycles)
+    {
+        timestamp_ext.high++;
+    }
+    timestamp_ext.last_cycles = now;
+
+    __set_PRIMASK(primask);
+}
+
+/*******************************************************************************
+* Function Name: timestamp_to_usec()
+********************************************************************************
+* Summary:
+*   Converts a timestamp in core cycles, from timestamp_get(), to us.
+*
+* Parameters:
+*   cycles:         Timestamp in core cycles
+*
+* Return :
+*   uint64_t:       Timestamp in us
+*
+*******************************************************************************/
+uint64_t timestamp_to_usec(uint64_t cycles)
+{
+    return (cycles / timestamp_ext.cycles_per_usec);
+}
+
+/* End of File */
@@ -25,9 +25,19 @@
 #include "stm32f407xx.h"
 #endif  /* __STM32F407xx_H */
 
+#include "timer_aj_stm32f4.h"
+
 /*******************************************************************************
 * Macros
 *******************************************************************************/
+/* Timeout value for a deadline which never expires */
+#define DEADLINE_WAIT_FOREVER               (0xFFFFFFFFU)
+
+/* Period of the timebase tick which counts the cycle counter wraps, must stay
+ * below one wrap, 2^32 cycles are ~25 s at the max HCLK of 168 MHz.
+ */
+#define TIMESTAMP_TICK_US                   (10000000U)
+
 #if 0
 #define ST_ASSERT(x)        do{\
                                 ((x) ? (void)(0U) : __asm("BKPT #0"));\
@@ -46,9 +56,93 @@ typedef enum result_funct_e
 
 typedef int result_funct;
 
+/* Deadline tracked on the DWT cycle counter, see deadline_start() */
+typedef struct deadline_st
+{
+    uint32_t start;
+    uint32_t cycles_per_milsec;
+    uint32_t remaining_milsec;
+} deadline_st_t;
+
+/* 64-bit extension of the DWT cycle counter, see timestamp_get() */
+typedef struct timestamp_st
+{
+    uint32_t base_cycles;               /* Cycle counter at timestamp_init() */
+    volatile uint32_t high;             /* Wraps of the cycle counter */
+    volatile uint32_t last_cycles;      /* Cycle counter at the last tick */
+    uint32_t cycles_per_usec;
+} timestamp_st_t;
+
+extern timestamp_st_t timestamp_ext;
+
 /*******************************************************************************
 * Function Prototypes
 *******************************************************************************/
+void deadline_start(deadline_st_t *deadline, uint32_t timeout_milsec);
+bool deadline_expired(deadline_st_t *deadline);
+
+void timestamp_init(void);
+uint64_t timestamp_to_usec(uint64_t cycles);
+
+/*******************************************************************************
+* Function Name: cyccnt_init()
+********************************************************************************
+* Summary:
+*   Enables the free running DWT cycle counter of the Cortex-M4 core. The counter
+*   is not reset, other users of the counter are not disturbed.
+*
+*******************************************************************************/
+static __inline void cyccnt_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/*******************************************************************************
+* Function Name: cyccnt_get()
+********************************************************************************
+* Summary:
+*   Returns the DWT cycle counter value, counts at core clock and wraps at 2^32,
+*   use unsigned subtraction for computing elapsed cycles.
+*
+*******************************************************************************/
+static __inline uint32_t cyccnt_get(void)
+{
+    return DWT->CYCCNT;
+}
+
+/*******************************************************************************
+* Function Name: timestamp_get()
+********************************************************************************
+* Summary:
+*   Returns the time in core cycles since timestamp_init(), the 32-bit DWT cycle
+*   counter extended to 64-bit by it's own wrap count. The wraps are counted by
+*   a timebase tick every TIMESTAMP_TICK_US, here the counter is only compared
+*   against it's value at the last tick, so a read is a handful of cycles with
+*   no multiply or divide. Use timestamp_to_usec() for the time in us, only when
+*   needed. Lock-free, can be called from thread and ISRs, a wrap is missed if
+*   the IRQs are masked for longer than a counter wrap.
+*
+*******************************************************************************/
+static __inline uint64_t timestamp_get(void)
+{
+    uint32_t last = 0, high = 0, low = 0;
+
+    /* The tick updates both with IRQs masked, read again if it came between */
+    do
+    {
+        last = timestamp_ext.last_cycles;
+        high = timestamp_ext.high;
+        low = DWT->CYCCNT;
+    } while (last != timestamp_ext.last_cycles);
+
+    /* Less than a wrap since the tick, a lower count has wrapped once */
+    if (low < last)
+    {
+        high++;
+    }
 
+    return ((((uint64_t)high << 32) | low) - timestamp_ext.base_cycles);
+}
 
 #endif /* UTILS_AJ_STM32F4 */
@@ -0,0 +1,356 @@
+/*******************************************************************************
+ * File Name: binlog_decoder_host_test.c
+ *
+ * Description:
+ * Host test (Linux) of tools/binlog_decoder. Writes a small 32-bit ELF image
+ * with known format strings in the binlog_fmt section and a string in .rodata,
+ * and a capture of COBS framed records as the target sends them, then runs the
+ * decoder on them and checks it's output.
+ *
+ * Usage: binlog_decoder_host_test <binlog_decoder> <work dir>
+ *
+ * Related Document: See README.md
+ *
+ *******************************************************************************/
+#include <elf.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cobs_aj_stm32f4.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Target addresses of the sections of the test image */
+#define TEST_FMT_ADDR                       (0x08010000U)
+#define TEST_RODATA_ADDR                    (0x08020000U)
+
+#define TEST_PATH_SIZE                      (512U)
+#define TEST_OUT_SIZE                       (4096U)
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+/* Format strings, placed one after the other from TEST_FMT_ADDR */
+enum
+{
+    TEST_FMT_ADC,
+    TEST_FMT_STR,
+    TEST_FMT_HEX,
+    TEST_FMT_NO_ARGS,
+    TEST_FMT_TWO,
+    TEST_FMT_NUM,
+};
+
+static const char *test_fmts[TEST_FMT_NUM] = {
+    "adc ch%u = %.3f V\n",
+    "%s: %d%%\n",
+    "x=%08lx %c\n",
+    "no args\n",
+    "%d %d\n",
+};
+
+/* Contents of the binlog_fmt section and the address of each string */
+static char test_fmt_section[256];
+static uint32_t test_fmt_size = 0;
+static uint32_t test_fmt_addr[TEST_FMT_NUM];
+
+static const char test_rodata[] = "main";
+
+static const char test_shstrtab[] = "\0binlog_fmt\0.rodata\0.shstrtab";
+
+static uint32_t fail_cnt = 0;
+
+/*******************************************************************************
+ * Function Name: fmt_section_build()
+ ********************************************************************************
+ * Summary:
+ *   Places the format strings in the binlog_fmt section, NUL terminated.
+ *
+ *******************************************************************************/
+static void fmt_section_build(void)
+{
+    uint32_t i = 0, len = 0;
+
+    for (i = 0; i < TEST_FMT_NUM; i++)
+    {
+        len = (uint32_t)strlen(test_fmts[i]) + 1U;
+        test_fmt_addr[i] = TEST_FMT_ADDR + test_fmt_size;
+        memcpy(&test_fmt_section[test_fmt_size], test_fmts[i], len);
+        test_fmt_size += len;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: check()
+ ********************************************************************************
+ * Summary:
+ *   Counts and reports a failed check.
+ *
+ *******************************************************************************/
+static void check(int cond, const char *what)
+{
+    if (!cond)
+    {
+        printf("FAIL: %s\n", what);
+        fail_cnt++;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: elf_write()
+ ********************************************************************************
+ * Summary:
+ *   Writes the test ELF image, the header, the section data and the section
+ *   headers: null, binlog_fmt, .rodata and .shstrtab.
+ *
+ *******************************************************************************/
+static int elf_write(const char *path)
+{
+    Elf32_Ehdr ehdr;
+    Elf32_Shdr shdr[4];
+    FILE *fp = fopen(path, "wb");
+    uint32_t off = sizeof(Elf32_Ehdr);
+
+    if (NULL == fp)
+    {
+        return -1;
+    }
+
+    memset(&ehdr, 0, sizeof(ehdr));
+    memset(shdr, 0, sizeof(shdr));
+
+    memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+    ehdr.e_ident[EI_CLASS] = ELFCLASS32;
+    ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+    ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+    ehdr.e_type = ET_EXEC;
+    ehdr.e_machine = EM_ARM;
+    ehdr.e_version = EV_CURRENT;
+    ehdr.e_ehsize = sizeof(Elf32_Ehdr);
+    ehdr.e_shentsize = sizeof(Elf32_Shdr);
+    ehdr.e_shnum = 4;
+    ehdr.e_shstrndx = 3;
+
+    shdr[1].sh_name = 1;
+    shdr[1].sh_type = SHT_PROGBITS;
+    shdr[1].sh_flags = SHF_ALLOC;
+    shdr[1].sh_addr = TEST_FMT_ADDR;
+    shdr[1].sh_offset = off;
+    shdr[1].sh_size = test_fmt_size;
+    off += test_fmt_size;
+
+    shdr[2].sh_name = 12;
+    shdr[2].sh_type = SHT_PROGBITS;
+    shdr[2].sh_flags = SHF_ALLOC;
+    shdr[2].sh_addr = TEST_RODATA_ADDR;
+    shdr[2].sh_offset = off;
+    shdr[2].sh_size = sizeof(test_rodata);
+    off += sizeof(test_rodata);
+
+    shdr[3].sh_name = 20;
+    shdr[3].sh_type = SHT_STRTAB;
+    shdr[3].sh_offset = off;
+    shdr[3].sh_size = sizeof(test_shstrtab);
+    off += sizeof(test_shstrtab);
+
+    ehdr.e_shoff = off;
+
+    fwrite(&ehdr, sizeof(ehdr), 1, fp);
+    fwrite(test_fmt_section, test_fmt_size, 1, fp);
+    fwrite(test_rodata, sizeof(test_rodata), 1, fp);
+    fwrite(test_shstrtab, sizeof(test_shstrtab), 1, fp);
+    fwrite(shdr, sizeof(shdr), 1, fp);
+
+    return fclose(fp);
+}
+
+/*******************************************************************************
+ * Function Name: record_write()
+ ********************************************************************************
+ * Summary:
+ *   Writes a record of little endian words framed with COBS, as binlog_write()
+ *   does on the target.
+ *
+ *******************************************************************************/
+static void record_write(FILE *fp, const uint32_t *words, uint32_t word_cnt)
+{
+    uint8_t packet[64];
+    uint8_t frame[COBS_ENC_MAX_SIZE(64U)];
+    uint16_t frame_size = 0;
+    uint32_t i = 0;
+
+    for (i = 0; i < word_cnt; i++)
+    {
+        packet[4U * i] = (uint8_t)words[i];
+        packet[4U * i + 1U] = (uint8_t)(words[i] >> 8);
+        packet[4U * i + 2U] = (uint8_t)(words[i] >> 16);
+        packet[4U * i + 3U] = (uint8_t)(words[i] >> 24);
+    }
+
+    check(COBS_STATUS_SUCCESS == cobs_encode(packet, (uint16_t)(4U * word_cnt), frame,
+                                             sizeof(frame), &frame_size), "cobs_encode");
+    fwrite(frame, frame_size, 1, fp);
+}
+
+/*******************************************************************************
+ * Function Name: float_bits()
+ ********************************************************************************
+ * Summary:
+ *   Returns the IEEE-754 bits of a float, as BINLOG_F().
+ *
+ *******************************************************************************/
+static uint32_t float_bits(float val)
+{
+    uint32_t bits = 0;
+
+    memcpy(&bits, &val, sizeof(bits));
+
+    return bits;
+}
+
+/*******************************************************************************
+ * Function Name: capture_write()
+ ********************************************************************************
+ * Summary:
+ *   Writes the capture, the records and the garbage in it, and returns the
+ *   text the decoder should print for it.
+ *
+ *******************************************************************************/
+static int capture_write(const char *path, const char **expected)
+{
+    static const uint8_t garbage[] = {0x55, 0xFF, 0x13, 0x00};
+    static const uint8_t short_record[] = {0x03, 0x11, 0x22, 0x01, 0x01, 0x01, 0x00};
+    uint32_t adc[] = {test_fmt_addr[TEST_FMT_ADC], 3U, float_bits(1.25f)};
+    uint32_t str[] = {test_fmt_addr[TEST_FMT_STR], TEST_RODATA_ADDR, (uint32_t)-5};
+    uint32_t bad_str[] = {test_fmt_addr[TEST_FMT_STR], 0x20000000U, 7U};
+    uint32_t hex[] = {test_fmt_addr[TEST_FMT_HEX], 0xBEEFU, 'A'};
+    uint32_t no_args[] = {test_fmt_addr[TEST_FMT_NO_ARGS]};
+    uint32_t unknown[] = {0x12345678U, 1U};
+    uint32_t missing[] = {test_fmt_addr[TEST_FMT_TWO], 42U};
+    FILE *fp = fopen(path, "wb");
+
+    if (NULL == fp)
+    {
+        return -1;
+    }
+
+    /* The capture starts in the middle of a record */
+    fwrite(&garbage[1], sizeof(garbage) - 1U, 1, fp);
+    record_write(fp, adc, 3);
+    record_write(fp, str, 3);
+    /* Garbage without a delimiter runs into the next record, both are lost */
+    fwrite(garbage, 2, 1, fp);
+    record_write(fp, no_args, 1);
+    record_write(fp, bad_str, 3);
+    record_write(fp, hex, 3);
+    /* Record not a whole number of words */
+    fwrite(short_record, sizeof(short_record), 1, fp);
+    record_write(fp, unknown, 2);
+    record_write(fp, missing, 2);
+    record_write(fp, no_args, 1);
+
+    *expected = "adc ch3 = 1.250 V\n"
+                "main: -5%\n"
+                "<str@0x20000000>: 7%\n"
+                "x=0000beef A\n"
+                "<unknown format 0x12345678>\n"
+                "42 <missing>\n"
+                "no args\n";
+
+    return fclose(fp);
+}
+
+/*******************************************************************************
+ * Function Name: file_read()
+ ********************************************************************************
+ * Summary:
+ *   Reads a text file into the buffer, NUL terminated.
+ *
+ *******************************************************************************/
+static void file_read(const char *path, char *buff, size_t buff_size)
+{
+    FILE *fp = fopen(path, "rb");
+    size_t len = 0;
+
+    if (NULL != fp)
+    {
+        len = fread(buff, 1, buff_size - 1U, fp);
+        fclose(fp);
+    }
+
+    buff[len] = '\0';
+}
+
+/*******************************************************************************
+ * Function Name: main()
+ ********************************************************************************
+ * Summary:
+ *   Runs the decoder on the test image and capture, and checks it's stdout
+ *   and the bad frame report on stderr.
+ *
+ *******************************************************************************/
+int main(int argc, char **argv)
+{
+    char elf_path[TEST_PATH_SIZE], cap_path[TEST_PATH_SIZE];
+    char out_path[TEST_PATH_SIZE], err_path[TEST_PATH_SIZE];
+    char cmd[6U * TEST_PATH_SIZE];
+    char out[TEST_OUT_SIZE], err[TEST_OUT_SIZE];
+    const char *expected = NULL;
+    int status = 0;
+
+    if (3 != argc)
+    {
+        fprintf(stderr, "usage: %s <binlog_decoder> <work dir>\n", argv[0]);
+        return 2;
+    }
+
+    snprintf(elf_path, sizeof(elf_path), "%s/binlog_test.axf", argv[2]);
+    snprintf(cap_path, sizeof(cap_path), "%s/binlog_test.bin", argv[2]);
+    snprintf(out_path, sizeof(out_path), "%s/binlog_test.out", argv[2]);
+    snprintf(err_path, sizeof(err_path), "%s/binlog_test.err", argv[2]);
+
+    fmt_section_build();
+
+    check(0 == elf_write(elf_path), "write the ELF image");
+    check(0 == capture_write(cap_path, &expected), "write the capture");
+
+    /* Capture from a file */
+    snprintf(cmd, sizeof(cmd), "%s %s %s > %s 2> %s", argv[1], elf_path, cap_path, out_path,
+             err_path);
+    status = system(cmd);
+    check(0 == status, "decoder exit status");
+
+    file_read(out_path, out, sizeof(out));
+    file_read(err_path, err, sizeof(err));
+
+    check(0 == strcmp(out, expected), "decoded text");
+    if (0 != strcmp(out, expected))
+    {
+        printf("expected:\n%s\ngot:\n%s\n", expected, out);
+    }
+    check(NULL != strstr(err, "bad frames"), "bad frames reported");
+    check(NULL != strstr(err, "1 bad records"), "short record reported");
+
+    /* Capture from stdin */
+    snprintf(cmd, sizeof(cmd), "%s %s < %s > %s 2> %s", argv[1], elf_path, cap_path, out_path,
+             err_path);
+    status = system(cmd);
+    check(0 == status, "decoder exit status, stdin");
+
+    file_read(out_path, out, sizeof(out));
+    check(0 == strcmp(out, expected), "decoded text, stdin");
+
+    /* Not an ELF image */
+    snprintf(cmd, sizeof(cmd), "%s %s < %s > %s 2> %s", argv[1], cap_path, cap_path, out_path,
+             err_path);
+    check(0 != system(cmd), "non ELF image rejected");
+
+    printf("binlog_decoder_host_test: %s\n", (0U == fail_cnt) ? ("PASS") : ("FAIL"));
+
+    return (0U == fail_cnt) ? (0) : (1);
+}
+
+/* End of File */
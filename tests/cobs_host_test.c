@@ -0,0 +1,321 @@
+/*******************************************************************************
+ * File Name: cobs_host_test.c
+ *
+ * Description:
+ * Host test (Linux) of libs/cobs_stm32f407_lib. Random packets, with runs of
+ * zeros and of 254/255 non zero bytes, are encoded and streamed back to back
+ * through the decoder in random chunks, and each frame must match the packet.
+ * Also checks the encoder size bound and overflow, the oversized and
+ * truncated frames, and the resync after garbage.
+ *
+ * Related Document: See README.md
+ *
+ *******************************************************************************/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cobs_aj_stm32f4.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define TEST_PACKET_MAX_SIZE                (1100U)
+#define TEST_PACKETS                        (20000U)
+/* Packets streamed before the decoded frames are checked */
+#define TEST_BATCH                          (16U)
+
+#define TEST_STREAM_SIZE                    (TEST_BATCH * COBS_ENC_MAX_SIZE(TEST_PACKET_MAX_SIZE))
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+static uint8_t test_packets[TEST_BATCH][TEST_PACKET_MAX_SIZE];
+static uint16_t test_packet_size[TEST_BATCH];
+
+static uint8_t test_stream[TEST_STREAM_SIZE];
+static uint8_t test_frame_buff[TEST_PACKET_MAX_SIZE];
+
+/* Index of the next packet expected by the frame callback */
+static uint32_t test_rx_idx = 0;
+
+static uint32_t fail_cnt = 0;
+
+/*******************************************************************************
+ * Function Name: check()
+ ********************************************************************************
+ * Summary:
+ *   Counts and reports a failed check, only the first few are printed.
+ *
+ *******************************************************************************/
+static void check(int cond, const char *what, uint32_t val)
+{
+    if (!cond)
+    {
+        if (fail_cnt < 10U)
+        {
+            printf("FAIL: %s (%u)\n", what, (unsigned int)val);
+        }
+        fail_cnt++;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: test_frame_cb()
+ ********************************************************************************
+ * Summary:
+ *   Frame callback, compares the frame with the next packet sent.
+ *
+ *******************************************************************************/
+static void test_frame_cb(void *cb_arg, uint8_t *frame, uint16_t frame_size)
+{
+    (void)cb_arg;
+
+    if (test_rx_idx >= TEST_BATCH)
+    {
+        check(0, "frame not sent", frame_size);
+        return;
+    }
+
+    check(frame_size == test_packet_size[test_rx_idx], "frame size", test_rx_idx);
+    check((frame_size != test_packet_size[test_rx_idx]) ||
+              (0 == memcmp(frame, test_packets[test_rx_idx], frame_size)),
+          "frame data", test_rx_idx);
+
+    test_rx_idx++;
+}
+
+/*******************************************************************************
+ * Function Name: packet_fill()
+ ********************************************************************************
+ * Summary:
+ *   Fills a packet of a random size with one of the patterns, which hit the
+ *   block boundaries of the encoding.
+ *
+ *******************************************************************************/
+static uint16_t packet_fill(uint8_t *packet)
+{
+    uint16_t size = 0, i = 0;
+    int pattern = rand() % 5;
+
+    switch (rand() % 4)
+    {
+    case 0:
+        size = (uint16_t)(rand() % 8);
+        break;
+    case 1:
+        /* Around the max run length */
+        size = (uint16_t)(250 + (rand() % 12));
+        break;
+    default:
+        size = (uint16_t)(rand() % TEST_PACKET_MAX_SIZE);
+        break;
+    }
+
+    for (i = 0; i < size; i++)
+    {
+        switch (pattern)
+        {
+        case 0:
+            packet[i] = (uint8_t)rand();
+            break;
+        case 1:
+            packet[i] = 0U;
+            break;
+        case 2:
+            /* Non zero only, 254 bytes per block */
+            packet[i] = (uint8_t)(1 + (rand() % 255));
+            break;
+        case 3:
+            /* Sparse zeros */
+            packet[i] = (0 == (rand() % 300)) ? (0U) : (uint8_t)(1 + (rand() % 255));
+            break;
+        default:
+            /* A zero after each 254 or 255 bytes */
+            packet[i] = (0U == (i % (254U + (uint16_t)(size & 1U)))) ? (0U) : (0xA5U);
+            break;
+        }
+    }
+
+    return size;
+}
+
+/*******************************************************************************
+ * Function Name: stream_decode()
+ ********************************************************************************
+ * Summary:
+ *   Feeds a stream to the decoder, in random chunks or byte by byte.
+ *
+ *******************************************************************************/
+static void stream_decode(cobs_decoder_st_t *dec, const uint8_t *data, uint32_t size)
+{
+    uint32_t pos = 0, chunk = 0;
+    int bytewise = (0 == (rand() % 4));
+
+    while (pos < size)
+    {
+        if (bytewise)
+        {
+            cobs_decode_byte(dec, data[pos++]);
+            continue;
+        }
+
+        chunk = 1U + ((uint32_t)rand() % 3000U);
+        chunk = ((pos + chunk) > size) ? (size - pos) : (chunk);
+        cobs_decode(dec, &data[pos], (uint16_t)chunk);
+        pos += chunk;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: round_trip_test()
+ ********************************************************************************
+ * Summary:
+ *   Encodes batches of random packets back to back, at times with an extra
+ *   delimiter between the frames, and checks the decoded frames.
+ *
+ *******************************************************************************/
+static void round_trip_test(void)
+{
+    cobs_decoder_st_t dec;
+    uint32_t pkt = 0, i = 0, j = 0, pos = 0, frames = 0;
+    uint16_t enc_size = 0;
+
+    cobs_decoder_init(&dec, test_frame_buff, sizeof(test_frame_buff), test_frame_cb, NULL);
+
+    for (pkt = 0; pkt < TEST_PACKETS; pkt += TEST_BATCH)
+    {
+        pos = 0;
+
+        for (i = 0; i < TEST_BATCH; i++)
+        {
+            test_packet_size[i] = packet_fill(test_packets[i]);
+
+            check(COBS_STATUS_SUCCESS ==
+                      cobs_encode(test_packets[i], test_packet_size[i], &test_stream[pos],
+                                  (uint16_t)COBS_ENC_MAX_SIZE(test_packet_size[i]), &enc_size),
+                  "encode", pkt + i);
+            check(enc_size <= COBS_ENC_MAX_SIZE(test_packet_size[i]), "encoded size", enc_size);
+            check(COBS_FRAME_DELIM == test_stream[pos + enc_size - 1U], "no delimiter", pkt + i);
+
+            for (j = 0; j < (uint32_t)(enc_size - 1U); j++)
+            {
+                check(COBS_FRAME_DELIM != test_stream[pos + j], "delimiter in the frame", pkt + i);
+            }
+
+            pos += enc_size;
+
+            /* An empty gap between the frames is ignored */
+            if (0 == (rand() % 8))
+            {
+                test_stream[pos++] = COBS_FRAME_DELIM;
+            }
+        }
+
+        test_rx_idx = 0;
+        stream_decode(&dec, test_stream, pos);
+        check(TEST_BATCH == test_rx_idx, "frames lost", test_rx_idx);
+        frames += test_rx_idx;
+    }
+
+    check(TEST_PACKETS == dec.frame_cnt, "frame count", dec.frame_cnt);
+    check(0U == dec.err_cnt, "errors", dec.err_cnt);
+
+    printf("cobs_host_test: %u frames decoded\n", (unsigned int)frames);
+}
+
+/*******************************************************************************
+ * Function Name: error_test()
+ ********************************************************************************
+ * Summary:
+ *   Checks the encoder overflow and bad parameters, and that the decoder drops
+ *   the oversized, truncated and garbage frames, then decodes the next frame.
+ *
+ *******************************************************************************/
+static void error_test(void)
+{
+    cobs_decoder_st_t dec;
+    uint8_t small_buff[16];
+    uint16_t enc_size = 0, pos = 0, i = 0;
+    /* Block of 4 bytes cut after 2 by the delimiter */
+    const uint8_t truncated[] = {0x05U, 0x11U, 0x22U, COBS_FRAME_DELIM};
+
+    /* Encoder */
+    check(COBS_STATUS_OVERFLOW == cobs_encode(test_packets[0], 300U, test_stream,
+                                              (uint16_t)(COBS_ENC_MAX_SIZE(300U) - 1U), &enc_size),
+          "encode overflow", 0);
+    check(COBS_STATUS_BAD_PARAM == cobs_encode(NULL, 1U, test_stream, 16U, &enc_size),
+          "encode bad param", 0);
+    check(COBS_STATUS_SUCCESS == cobs_encode(NULL, 0U, test_stream, 16U, &enc_size),
+          "encode empty", enc_size);
+    check(COBS_STATUS_BAD_PARAM == cobs_decoder_init(&dec, small_buff, 0U, test_frame_cb, NULL),
+          "decoder bad param", 0);
+
+    cobs_decoder_init(&dec, small_buff, sizeof(small_buff), test_frame_cb, NULL);
+
+    /* Frame larger than the decoder buffer, then a valid frame */
+    test_packet_size[0] = 4U;
+    memset(test_packets[0], 0x33, 4U);
+
+    for (i = 0; i < 40U; i++)
+    {
+        test_packets[1][i] = (uint8_t)i;
+    }
+    cobs_encode(test_packets[1], 40U, test_stream, sizeof(test_stream), &enc_size);
+    pos = enc_size;
+    cobs_encode(test_packets[0], test_packet_size[0], &test_stream[pos], 16U, &enc_size);
+    pos = (uint16_t)(pos + enc_size);
+
+    test_rx_idx = 0;
+    cobs_decode(&dec, test_stream, pos);
+    check(1U == test_rx_idx, "frame after the oversized frame", test_rx_idx);
+    check(1U == dec.err_cnt, "oversized frame error", dec.err_cnt);
+
+    /* Truncated frame, then a valid frame */
+    cobs_decode(&dec, truncated, sizeof(truncated));
+    check(2U == dec.err_cnt, "truncated frame error", dec.err_cnt);
+
+    test_rx_idx = 0;
+    cobs_decode(&dec, &test_stream[pos - enc_size], enc_size);
+    check(1U == test_rx_idx, "frame after the truncated frame", test_rx_idx);
+
+    /* Garbage, starting with a block longer than the garbage, is dropped at
+     * the delimiter, then the frame after it is decoded.
+     */
+    test_stream[0] = 0xFFU;
+    for (i = 1; i < 100U; i++)
+    {
+        test_stream[i] = (uint8_t)(1 + (rand() % 255));
+    }
+    test_stream[100] = COBS_FRAME_DELIM;
+    pos = 101U;
+    cobs_encode(test_packets[0], test_packet_size[0], &test_stream[pos], 16U, &enc_size);
+    pos = (uint16_t)(pos + enc_size);
+
+    test_rx_idx = 0;
+    cobs_decode(&dec, test_stream, pos);
+    check(3U == dec.err_cnt, "garbage error", dec.err_cnt);
+    check(1U == test_rx_idx, "frame after the garbage", test_rx_idx);
+}
+
+/*******************************************************************************
+ * Function Name: main()
+ ********************************************************************************
+ * Summary:
+ *   Runs the tests.
+ *
+ *******************************************************************************/
+int main(void)
+{
+    srand(1);
+
+    round_trip_test();
+    error_test();
+
+    printf("cobs_host_test: %s\n", (0U == fail_cnt) ? ("PASS") : ("FAIL"));
+
+    return (0U == fail_cnt) ? (0) : (1);
+}
+
+/* End of File */
@@ -0,0 +1,129 @@
+/*******************************************************************************
+ * File Name: core_cm4.h
+ *
+ * Description:
+ * Host (Linux) stand-in of the CMSIS Cortex-M4 core header, for the host build
+ * of the device libs and apps. The core registers are plain RAM objects
+ * defined in host_model.c, and the intrinsics and NVIC functions are
+ * implemented by the host model, see host_model.c.
+ *
+ *******************************************************************************/
+#ifndef HOST_MODEL_CORE_CM4_H
+#define HOST_MODEL_CORE_CM4_H
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define __I                                 volatile const
+#define __O                                 volatile
+#define __IO                                volatile
+#define __STATIC_INLINE                     static inline
+#define __INLINE                            inline
+
+/*******************************************************************************
+ * Core registers
+ *******************************************************************************/
+typedef struct
+{
+    __IO uint32_t CTRL, LOAD, VAL, CALIB;
+} SysTick_Type;
+
+typedef struct
+{
+    __IO uint32_t CTRL, CYCCNT, CPICNT, EXCCNT, SLEEPCNT, LSUCNT, FOLDCNT, PCSR;
+} DWT_Type;
+
+typedef struct
+{
+    __IO uint32_t DHCSR, DCRSR, DCRDR, DEMCR;
+} CoreDebug_Type;
+
+typedef struct
+{
+    __IO uint32_t CPUID, ICSR, VTOR, AIRCR, SCR, CCR;
+} SCB_Type;
+
+typedef struct
+{
+    __IO uint32_t LAR;
+} ITM_Type;
+
+extern SysTick_Type host_SysTick;
+extern DWT_Type host_DWT;
+extern CoreDebug_Type host_CoreDebug;
+extern SCB_Type host_SCB;
+extern ITM_Type host_ITM;
+
+#define SysTick                             (&host_SysTick)
+#define DWT                                 (&host_DWT)
+#define CoreDebug                           (&host_CoreDebug)
+#define SCB                                 (&host_SCB)
+#define ITM                                 (&host_ITM)
+
+#define SysTick_CTRL_ENABLE_Pos          (0U)
+#define SysTick_CTRL_ENABLE_Msk          (0x1UL << SysTick_CTRL_ENABLE_Pos)
+#define SysTick_CTRL_ENABLE              SysTick_CTRL_ENABLE_Msk
+#define SysTick_CTRL_TICKINT_Pos         (1U)
+#define SysTick_CTRL_TICKINT_Msk         (0x1UL << SysTick_CTRL_TICKINT_Pos)
+#define SysTick_CTRL_TICKINT             SysTick_CTRL_TICKINT_Msk
+#define SysTick_CTRL_CLKSOURCE_Pos       (2U)
+#define SysTick_CTRL_CLKSOURCE_Msk       (0x1UL << SysTick_CTRL_CLKSOURCE_Pos)
+#define SysTick_CTRL_CLKSOURCE           SysTick_CTRL_CLKSOURCE_Msk
+#define SysTick_CTRL_COUNTFLAG_Pos       (16U)
+#define SysTick_CTRL_COUNTFLAG_Msk       (0x1UL << SysTick_CTRL_COUNTFLAG_Pos)
+#define SysTick_CTRL_COUNTFLAG           SysTick_CTRL_COUNTFLAG_Msk
+#define SysTick_LOAD_RELOAD_Pos          (0U)
+#define SysTick_LOAD_RELOAD_Msk          (0xFFFFFFUL << SysTick_LOAD_RELOAD_Pos)
+#define SysTick_LOAD_RELOAD              SysTick_LOAD_RELOAD_Msk
+#define SysTick_VAL_CURRENT_Pos          (0U)
+#define SysTick_VAL_CURRENT_Msk          (0xFFFFFFUL << SysTick_VAL_CURRENT_Pos)
+#define SysTick_VAL_CURRENT              SysTick_VAL_CURRENT_Msk
+
+#define DWT_CTRL_CYCCNTENA_Pos           (0U)
+#define DWT_CTRL_CYCCNTENA_Msk           (0x1UL << DWT_CTRL_CYCCNTENA_Pos)
+#define DWT_CTRL_CYCCNTENA               DWT_CTRL_CYCCNTENA_Msk
+
+#define CoreDebug_DEMCR_TRCENA_Pos       (24U)
+#define CoreDebug_DEMCR_TRCENA_Msk       (0x1UL << CoreDebug_DEMCR_TRCENA_Pos)
+#define CoreDebug_DEMCR_TRCENA           CoreDebug_DEMCR_TRCENA_Msk
+
+#define SCB_SCR_SLEEPDEEP_Pos            (2U)
+#define SCB_SCR_SLEEPDEEP_Msk            (0x1UL << SCB_SCR_SLEEPDEEP_Pos)
+#define SCB_SCR_SLEEPDEEP                SCB_SCR_SLEEPDEEP_Msk
+#define SCB_SCR_SLEEPONEXIT_Pos          (1U)
+#define SCB_SCR_SLEEPONEXIT_Msk          (0x1UL << SCB_SCR_SLEEPONEXIT_Pos)
+#define SCB_SCR_SLEEPONEXIT              SCB_SCR_SLEEPONEXIT_Msk
+#define SCB_ICSR_VECTACTIVE_Pos          (0U)
+#define SCB_ICSR_VECTACTIVE_Msk          (0x1FFUL << SCB_ICSR_VECTACTIVE_Pos)
+#define SCB_ICSR_VECTACTIVE              SCB_ICSR_VECTACTIVE_Msk
+
+/*******************************************************************************
+ * Intrinsics and NVIC, see host_model.c
+ *******************************************************************************/
+void __disable_irq(void);
+void __enable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+uint32_t __get_IPSR(void);
+uint32_t __get_MSP(void);
+void __WFI(void);
+void __WFE(void);
+void __SEV(void);
+void __NOP(void);
+void __DSB(void);
+void __DMB(void);
+void __ISB(void);
+uint32_t __CLZ(uint32_t value);
+uint32_t __RBIT(uint32_t value);
+
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority);
+void NVIC_SetPendingIRQ(IRQn_Type IRQn);
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+uint32_t NVIC_GetPendingIRQ(IRQn_Type IRQn);
+void NVIC_SystemReset(void);
+
+#endif /* HOST_MODEL_CORE_CM4_H */
@@ -0,0 +1,1297 @@
+/*******************************************************************************
+ * File Name: host_model.c
+ *
+ * Description:
+ * Host (Linux) model of the STM32F407 peripherals used by the USART, DMA,
+ * timer and retarget libs, so that the apps like uart_bench_stm32f407 build
+ * and run on a Linux host with the device libs as they are.
+ *
+ * The peripheral registers are plain RAM objects. A periodic SIGALRM runs the
+ * free running counters, the DWT cycle counter and TIM2-5, also with IRQs
+ * masked. The USART, DMA and NVIC are run by SIGUSR1, raised by each tick, it
+ * stands for the interrupts, so it is blocked by __disable_irq() and it calls
+ * the IRQ handlers of the libs. The Tx of USART1 goes to the stdout of the
+ * host, the Tx of the other USARTs is looped back to their Rx.
+ *
+ * Limits of the model:
+ *  - the register writes of the code are seen at the next step of the model,
+ *    a tick or an IRQ enable, so DR written in a TXE polling loop is
+ *    overwritten and the polled transfers do not time right
+ *  - the Rx is only modelled with the RXNE interrupt or DMA, IDLE only with
+ *    it's interrupt, and DMA only byte wide
+ *  - the timing is the host wall clock at the tick granularity, the interrupt
+ *    latency and CPU load are the ones of the host
+ *  - NVIC priorities are not modelled, the IRQs do not nest
+ *
+ * Related Document: See tests/Makefile
+ *
+ *******************************************************************************/
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "stm32f4xx.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Clock tree left by SystemInit() of the apps: HSE 8 MHz, PLL M=4 N=100 P=2
+ * for 100 MHz HCLK, APB1 HCLK/4 and APB2 HCLK/2.
+ */
+#define HOST_MODEL_HCLK                     (100000000U)
+#define HOST_MODEL_RCC_CR                   (RCC_CR_HSION_Msk | RCC_CR_HSIRDY_Msk | \
+                                             RCC_CR_HSEON_Msk | RCC_CR_HSERDY_Msk | \
+                                             RCC_CR_PLLON_Msk | RCC_CR_PLLRDY_Msk)
+#define HOST_MODEL_RCC_PLLCFGR              (RCC_PLLCFGR_PLLSRC_Msk | (4U << RCC_PLLCFGR_PLLQ_Pos) | \
+                                             (100U << RCC_PLLCFGR_PLLN_Pos) | \
+                                             (4U << RCC_PLLCFGR_PLLM_Pos))
+#define HOST_MODEL_RCC_CFGR                 ((2U << RCC_CFGR_SW_Pos) | (2U << RCC_CFGR_SWS_Pos) | \
+                                             (5U << RCC_CFGR_PPRE1_Pos) | \
+                                             (4U << RCC_CFGR_PPRE2_Pos))
+
+/* Period of the model tick */
+#ifndef HOST_MODEL_TICK_US
+#define HOST_MODEL_TICK_US                  (20U)
+#endif
+
+/* The program is ended once no USART sent a byte for this long, the apps
+ * end in an endless loop.
+ */
+#ifndef HOST_MODEL_IDLE_EXIT_MS
+#define HOST_MODEL_IDLE_EXIT_MS             (1000U)
+#endif
+
+/* The program is ended with a failure after this run time */
+#ifndef HOST_MODEL_RUN_MAX_MS
+#define HOST_MODEL_RUN_MAX_MS               (60000U)
+#endif
+
+/* The Tx of this USART is written to the stdout of the host, the Tx of the
+ * others is looped back to their Rx.
+ */
+#ifndef HOST_MODEL_STDOUT_USART
+#define HOST_MODEL_STDOUT_USART             (USART1)
+#endif
+
+/* Upper half of USART_DR as left by the model, a write of the code clears it */
+#define HOST_MODEL_DR_IDLE                  (0xA5A50000U)
+#define HOST_MODEL_DR_IDLE_MSK              (0xFFFF0000U)
+
+/* USART_SR bits cleared by writing 0, the others are read only */
+#define HOST_MODEL_USART_SR_RC_W0           (USART_SR_RXNE_Msk | USART_SR_TC_Msk | \
+                                             USART_SR_LBD_Msk | USART_SR_CTS_Msk)
+/* USART_SR bits cleared by reading SR followed by DR */
+#define HOST_MODEL_USART_SR_RX              (USART_SR_RXNE_Msk | USART_SR_ORE_Msk | \
+                                             USART_SR_IDLE_Msk | USART_SR_NE_Msk | \
+                                             USART_SR_FE_Msk | USART_SR_PE_Msk)
+
+/* Flags of a DMA stream in DMA_xISR, at the offset of the stream */
+#define HOST_MODEL_DMA_FEIF                 (0x01U)
+#define HOST_MODEL_DMA_DMEIF                (0x04U)
+#define HOST_MODEL_DMA_TEIF                 (0x08U)
+#define HOST_MODEL_DMA_HTIF                 (0x10U)
+#define HOST_MODEL_DMA_TCIF                 (0x20U)
+
+/* TIMx_SR/DIER bits of the update and compare interrupts */
+#define HOST_MODEL_TIM_IRQ_MSK              (0x1FU)
+
+#define HOST_MODEL_IRQ_NUM                  (82U)
+/* Handler calls in a step, more means a handler does not clear it's flag */
+#define HOST_MODEL_IRQ_STORM                (100000U)
+
+#define HOST_MODEL_USART_NUM                (6U)
+#define HOST_MODEL_DMA_STREAM_NUM           (16U)
+#define HOST_MODEL_TIM_NUM                  (4U)
+
+#define HOST_MODEL_NSEC_PER_SEC             (1000000000ULL)
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+/* Peripheral registers, see stm32f407xx.h and core_cm4.h */
+USART_TypeDef host_USART1, host_USART2, host_USART3, host_UART4, host_UART5, host_USART6;
+GPIO_TypeDef host_GPIOA, host_GPIOB, host_GPIOC, host_GPIOD;
+TIM_TypeDef host_TIM[14];
+RCC_TypeDef host_RCC;
+DMA_TypeDef host_DMA1, host_DMA2;
+DMA_Stream_TypeDef host_DMA_Stream[16];
+PWR_TypeDef host_PWR;
+FLASH_TypeDef host_FLASH;
+SysTick_Type host_SysTick;
+DWT_Type host_DWT;
+CoreDebug_Type host_CoreDebug;
+SCB_Type host_SCB;
+ITM_Type host_ITM;
+
+/* Model of a USART, the Tx data register, the shift register and the Rx */
+typedef struct host_usart_st
+{
+    USART_TypeDef *instance;
+    IRQn_Type irqn;
+    bool apb2;
+    uint32_t sr;                /* SR of the model, SR in RAM differs after a write */
+    uint8_t rx_data;
+    bool tdr_full;
+    uint8_t tdr;
+    bool shift_busy;
+    uint8_t shift_data;
+    uint64_t shift_end_ns;      /* Time the byte in the shift register is sent */
+    uint64_t idle_ns;           /* Time the Rx line turns idle, 0: not pending */
+} host_usart_st_t;
+
+/* Model of a DMA stream */
+typedef struct host_dma_stream_st
+{
+    bool running;
+    uint32_t count;             /* NDTR at the start of the transfer */
+    uint32_t ndtr;              /* NDTR last written by the model */
+} host_dma_stream_st_t;
+
+/* Model of a timer, the counter runs from the time of the last (re)start */
+typedef struct host_tim_st
+{
+    TIM_TypeDef *instance;
+    IRQn_Type irqn;
+    bool running;
+    uint64_t base_ns;
+    uint64_t base_ticks;
+    uint64_t ticks;             /* Ticks counted at the last update */
+    uint32_t cnt;               /* CNT last written by the model */
+    uint32_t sr;                /* SR of the model */
+} host_tim_st_t;
+
+static host_usart_st_t host_usart[HOST_MODEL_USART_NUM] = {
+    {.instance = USART1, .irqn = USART1_IRQn, .apb2 = true},
+    {.instance = USART2, .irqn = USART2_IRQn, .apb2 = false},
+    {.instance = USART3, .irqn = USART3_IRQn, .apb2 = false},
+    {.instance = UART4, .irqn = UART4_IRQn, .apb2 = false},
+    {.instance = UART5, .irqn = UART5_IRQn, .apb2 = false},
+    {.instance = USART6, .irqn = USART6_IRQn, .apb2 = true},
+};
+
+static host_dma_stream_st_t host_dma[HOST_MODEL_DMA_STREAM_NUM];
+
+static const IRQn_Type host_dma_irqn[HOST_MODEL_DMA_STREAM_NUM] = {
+    DMA1_Stream0_IRQn, DMA1_Stream1_IRQn, DMA1_Stream2_IRQn, DMA1_Stream3_IRQn,
+    DMA1_Stream4_IRQn, DMA1_Stream5_IRQn, DMA1_Stream6_IRQn, DMA1_Stream7_IRQn,
+    DMA2_Stream0_IRQn, DMA2_Stream1_IRQn, DMA2_Stream2_IRQn, DMA2_Stream3_IRQn,
+    DMA2_Stream4_IRQn, DMA2_Stream5_IRQn, DMA2_Stream6_IRQn, DMA2_Stream7_IRQn,
+};
+
+/* Bit offset of each stream's flags inside DMA_xISR/DMA_xIFCR */
+static const uint8_t host_dma_flag_offset[4] = {0U, 6U, 16U, 22U};
+
+static host_tim_st_t host_tim[HOST_MODEL_TIM_NUM] = {
+    {.instance = TIM2, .irqn = TIM2_IRQn},
+    {.instance = TIM3, .irqn = TIM3_IRQn},
+    {.instance = TIM4, .irqn = TIM4_IRQn},
+    {.instance = TIM5, .irqn = TIM5_IRQn},
+};
+
+/* Core state */
+static volatile uint32_t host_primask = 0;
+static volatile uint32_t host_ipsr = 0;
+static volatile bool host_nvic_en[HOST_MODEL_IRQ_NUM];
+static volatile bool host_nvic_pend[HOST_MODEL_IRQ_NUM];
+
+/* DWT cycle counter, counts from the value written at the time of the write */
+static bool host_cyc_running = false;
+static uint64_t host_cyc_base_ns = 0;
+static uint32_t host_cyc_base = 0;
+static uint32_t host_cyc_written = 0;
+
+static struct timespec host_start_time;
+/* Time of the event being modelled */
+static uint64_t host_sim_ns = 0;
+static uint64_t host_last_tx_ns = 0;
+static bool host_tx_seen = false;
+
+static char host_stdout_buff[256];
+static uint32_t host_stdout_len = 0;
+
+static sigset_t host_irq_sigset;
+
+/* Defined by the retarget lib, the stdout of the host is written through it */
+extern FILE __stdout;
+
+/*******************************************************************************
+ * IRQ handlers, the handlers not defined by the program end it.
+ *******************************************************************************/
+void host_default_handler(void);
+
+#define HOST_MODEL_WEAK_HANDLER(name)       void name(void) __attribute__((weak, alias("host_default_handler")))
+
+HOST_MODEL_WEAK_HANDLER(DMA1_Stream0_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(DMA1_Stream1_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(DMA1_Stream2_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(DMA1_Stream3_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(DMA1_Stream4_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(DMA1_Stream5_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(DMA1_Stream6_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(DMA1_Stream7_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(DMA2_Stream0_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(DMA2_Stream1_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(DMA2_Stream2_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(DMA2_Stream3_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(DMA2_Stream4_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(DMA2_Stream5_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(DMA2_Stream6_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(DMA2_Stream7_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(TIM2_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(TIM3_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(TIM4_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(TIM5_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(USART1_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(USART2_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(USART3_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(UART4_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(UART5_IRQHandler);
+HOST_MODEL_WEAK_HANDLER(USART6_IRQHandler);
+
+static void (*const host_vector[HOST_MODEL_IRQ_NUM])(void) = {
+    [DMA1_Stream0_IRQn] = DMA1_Stream0_IRQHandler,
+    [DMA1_Stream1_IRQn] = DMA1_Stream1_IRQHandler,
+    [DMA1_Stream2_IRQn] = DMA1_Stream2_IRQHandler,
+    [DMA1_Stream3_IRQn] = DMA1_Stream3_IRQHandler,
+    [DMA1_Stream4_IRQn] = DMA1_Stream4_IRQHandler,
+    [DMA1_Stream5_IRQn] = DMA1_Stream5_IRQHandler,
+    [DMA1_Stream6_IRQn] = DMA1_Stream6_IRQHandler,
+    [DMA1_Stream7_IRQn] = DMA1_Stream7_IRQHandler,
+    [DMA2_Stream0_IRQn] = DMA2_Stream0_IRQHandler,
+    [DMA2_Stream1_IRQn] = DMA2_Stream1_IRQHandler,
+    [DMA2_Stream2_IRQn] = DMA2_Stream2_IRQHandler,
+    [DMA2_Stream3_IRQn] = DMA2_Stream3_IRQHandler,
+    [DMA2_Stream4_IRQn] = DMA2_Stream4_IRQHandler,
+    [DMA2_Stream5_IRQn] = DMA2_Stream5_IRQHandler,
+    [DMA2_Stream6_IRQn] = DMA2_Stream6_IRQHandler,
+    [DMA2_Stream7_IRQn] = DMA2_Stream7_IRQHandler,
+    [TIM2_IRQn] = TIM2_IRQHandler,
+    [TIM3_IRQn] = TIM3_IRQHandler,
+    [TIM4_IRQn] = TIM4_IRQHandler,
+    [TIM5_IRQn] = TIM5_IRQHandler,
+    [USART1_IRQn] = USART1_IRQHandler,
+    [USART2_IRQn] = USART2_IRQHandler,
+    [USART3_IRQn] = USART3_IRQHandler,
+    [UART4_IRQn] = UART4_IRQHandler,
+    [UART5_IRQn] = UART5_IRQHandler,
+    [USART6_IRQn] = USART6_IRQHandler,
+};
+
+/*******************************************************************************
+ * Function Name: host_exit()
+ ********************************************************************************
+ * Summary:
+ *   Writes the pending stdout data and ends the program, also from a signal
+ *   handler.
+ *
+ *******************************************************************************/
+static void host_exit(int status, const char *msg)
+{
+    if (0U != host_stdout_len)
+    {
+        (void)write(STDOUT_FILENO, host_stdout_buff, host_stdout_len);
+    }
+
+    if (NULL != msg)
+    {
+        (void)write(STDERR_FILENO, msg, strlen(msg));
+    }
+
+    _exit(status);
+}
+
+/*******************************************************************************
+ * Function Name: host_default_handler()
+ ********************************************************************************
+ * Summary:
+ *   Handler of the IRQs enabled without a handler in the program.
+ *
+ *******************************************************************************/
+void host_default_handler(void)
+{
+    host_exit(2, "host_model: IRQ enabled without a handler\n");
+}
+
+/*******************************************************************************
+ * Function Name: host_now_ns()
+ ********************************************************************************
+ * Summary:
+ *   Returns the time since the start of the program.
+ *
+ *******************************************************************************/
+static uint64_t host_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)(now.tv_sec - host_start_time.tv_sec) * HOST_MODEL_NSEC_PER_SEC) +
+           (uint64_t)now.tv_nsec - (uint64_t)host_start_time.tv_nsec;
+}
+
+/*******************************************************************************
+ * Function Name: host_apb_clock()
+ ********************************************************************************
+ * Summary:
+ *   Returns the APB1 or APB2 clock from the prescaler in RCC_CFGR.
+ *
+ *******************************************************************************/
+static uint32_t host_apb_clock(bool apb2)
+{
+    uint32_t ppre = (apb2) ? ((RCC->CFGR & RCC_CFGR_PPRE2_Msk) >> RCC_CFGR_PPRE2_Pos) :
+                             ((RCC->CFGR & RCC_CFGR_PPRE1_Msk) >> RCC_CFGR_PPRE1_Pos);
+
+    return (ppre < 4U) ? (HOST_MODEL_HCLK) : (HOST_MODEL_HCLK >> (ppre - 3U));
+}
+
+/*******************************************************************************
+ * Function Name: host_stdout_put()
+ ********************************************************************************
+ * Summary:
+ *   Writes a byte sent by the stdout USART to the stdout of the host.
+ *
+ *******************************************************************************/
+static void host_stdout_put(uint8_t data)
+{
+    host_stdout_buff[host_stdout_len++] = (char)data;
+
+    if (('\n' == data) || (host_stdout_len >= sizeof(host_stdout_buff)))
+    {
+        (void)write(STDOUT_FILENO, host_stdout_buff, host_stdout_len);
+        host_stdout_len = 0;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: host_cyccnt_update()
+ ********************************************************************************
+ * Summary:
+ *   Runs the DWT cycle counter at HCLK while it is enabled. A value written by
+ *   the code is counted from.
+ *
+ *******************************************************************************/
+static void host_cyccnt_update(uint64_t now)
+{
+    bool enabled = (0U != (CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk)) &&
+                   (0U != (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk));
+
+    if (!enabled)
+    {
+        host_cyc_running = false;
+        return;
+    }
+
+    if ((!host_cyc_running) || (DWT->CYCCNT != host_cyc_written))
+    {
+        host_cyc_running = true;
+        host_cyc_base = DWT->CYCCNT;
+        host_cyc_base_ns = now;
+    }
+
+    host_cyc_written = host_cyc_base + (uint32_t)(((now - host_cyc_base_ns) * (HOST_MODEL_HCLK / 1000000U)) /
+                                                  1000U);
+    DWT->CYCCNT = host_cyc_written;
+}
+
+/*******************************************************************************
+ * Function Name: host_tim_update()
+ ********************************************************************************
+ * Summary:
+ *   Runs the up counter of a timer at it's prescaled APB1 timer clock, and
+ *   sets the update flag on the wrap at ARR and the compare flags when the
+ *   counter passes CCRx. A write to CNT or the update generation of EGR
+ *   restarts the counter from the value written.
+ *
+ *******************************************************************************/
+static void host_tim_update(host_tim_st_t *tim, uint64_t now)
+{
+    TIM_TypeDef *instance = tim->instance;
+    uint64_t period = (uint64_t)instance->ARR + 1U;
+    uint64_t tclk = host_apb_clock(false);
+    uint64_t ticks = 0, hit = 0;
+    const uint32_t ccr[4] = {instance->CCR1, instance->CCR2, instance->CCR3, instance->CCR4};
+    uint32_t ch = 0;
+
+    /* Flags are cleared by writing 0 */
+    if (instance->SR != tim->sr)
+    {
+        tim->sr &= instance->SR;
+    }
+
+    if (0U == (instance->CR1 & TIM_CR1_CEN_Msk))
+    {
+        tim->running = false;
+        instance->SR = tim->sr;
+        return;
+    }
+
+    /* Timer clock is twice the APB clock if the APB prescaler is not 1 */
+    tclk = (HOST_MODEL_HCLK == tclk) ? (tclk) : (2U * tclk);
+
+    if ((!tim->running) || (instance->CNT != tim->cnt) || (instance->EGR & TIM_EGR_UG_Msk))
+    {
+        tim->base_ticks = (instance->EGR & TIM_EGR_UG_Msk) ? (0U) : (instance->CNT);
+        tim->base_ns = now;
+        tim->ticks = tim->base_ticks;
+        tim->running = true;
+        instance->EGR = 0;
+    }
+
+    ticks = tim->base_ticks + (uint64_t)(((unsigned __int128)(now - tim->base_ns) * tclk) /
+                                         (HOST_MODEL_NSEC_PER_SEC * ((uint64_t)instance->PSC + 1U)));
+
+    if ((ticks / period) != (tim->ticks / period))
+    {
+        tim->sr |= TIM_SR_UIF_Msk;
+    }
+
+    for (ch = 0; ch < 4U; ch++)
+    {
+        /* First match of CCRx after the last update */
+        hit = (tim->ticks - (tim->ticks % period)) + ccr[ch];
+        hit = (hit <= tim->ticks) ? (hit + period) : (hit);
+
+        if (hit <= ticks)
+        {
+            tim->sr |= (TIM_SR_CC1IF_Msk << ch);
+        }
+    }
+
+    tim->ticks = ticks;
+    tim->cnt = (uint32_t)(ticks % period);
+    instance->CNT = tim->cnt;
+    instance->SR = tim->sr;
+}
+
+/*******************************************************************************
+ * Function Name: host_time_update()
+ ********************************************************************************
+ * Summary:
+ *   Updates the free running counters to the current time.
+ *
+ *******************************************************************************/
+static void host_time_update(uint64_t now)
+{
+    uint32_t i = 0;
+
+    host_cyccnt_update(now);
+
+    for (i = 0; i < HOST_MODEL_TIM_NUM; i++)
+    {
+        host_tim_update(&host_tim[i], now);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: host_usart_byte_ns()
+ ********************************************************************************
+ * Summary:
+ *   Returns the time of a frame on the line, from BRR, the oversampling, the
+ *   word length and the stop bits.
+ *
+ *******************************************************************************/
+static uint64_t host_usart_byte_ns(host_usart_st_t *usart)
+{
+    USART_TypeDef *instance = usart->instance;
+    uint32_t brr = instance->BRR;
+    uint64_t div = 0, bits = 0;
+
+    /* BRR is 16 x USARTDIV, or 8 x USARTDIV with the fraction in bits 2:0 */
+    div = (instance->CR1 & USART_CR1_OVER8_Msk) ? (((brr >> 4) << 3) | (brr & 0x7U)) : (brr);
+    div = (0U == div) ? (1U) : (div);
+
+    bits = 1U + ((instance->CR1 & USART_CR1_M_Msk) ? (9U) : (8U)) +
+           ((2U == ((instance->CR2 & USART_CR2_STOP_Msk) >> USART_CR2_STOP_Pos)) ? (2U) : (1U));
+
+    return (bits * div * HOST_MODEL_NSEC_PER_SEC) / host_apb_clock(usart->apb2);
+}
+
+/*******************************************************************************
+ * Function Name: host_dma_flags_set()
+ ********************************************************************************
+ * Summary:
+ *   Sets flags of a DMA stream in DMA_xISR.
+ *
+ *******************************************************************************/
+static void host_dma_flags_set(uint32_t idx, uint32_t flags)
+{
+    DMA_TypeDef *dma = (idx < 8U) ? (DMA1) : (DMA2);
+    uint32_t stream_num = idx % 8U;
+    uint32_t bits = flags << host_dma_flag_offset[stream_num % 4U];
+
+    if (stream_num < 4U)
+    {
+        dma->LISR |= bits;
+    }
+    else
+    {
+        dma->HISR |= bits;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: host_dma_flags_get()
+ ********************************************************************************
+ * Summary:
+ *   Returns the flags of a DMA stream in DMA_xISR.
+ *
+ *******************************************************************************/
+static uint32_t host_dma_flags_get(uint32_t idx)
+{
+    DMA_TypeDef *dma = (idx < 8U) ? (DMA1) : (DMA2);
+    uint32_t stream_num = idx % 8U;
+    uint32_t isr = (stream_num < 4U) ? (dma->LISR) : (dma->HISR);
+
+    return (isr >> host_dma_flag_offset[stream_num % 4U]) & 0x3DU;
+}
+
+/*******************************************************************************
+ * Function Name: host_dma_sync()
+ ********************************************************************************
+ * Summary:
+ *   Applies the flag clear writes to DMA_xIFCR, and starts the model of the
+ *   streams enabled by the code.
+ *
+ *******************************************************************************/
+static void host_dma_sync(void)
+{
+    DMA_TypeDef *dma[2] = {DMA1, DMA2};
+    DMA_Stream_TypeDef *stream = NULL;
+    uint32_t i = 0;
+
+    for (i = 0; i < 2U; i++)
+    {
+        dma[i]->LISR &= ~(dma[i]->LIFCR);
+        dma[i]->LIFCR = 0;
+        dma[i]->HISR &= ~(dma[i]->HIFCR);
+        dma[i]->HIFCR = 0;
+    }
+
+    for (i = 0; i < HOST_MODEL_DMA_STREAM_NUM; i++)
+    {
+        stream = &host_DMA_Stream[i];
+
+        if (0U == (stream->CR & DMA_SxCR_EN_Msk))
+        {
+            host_dma[i].running = false;
+            continue;
+        }
+
+        if ((!host_dma[i].running) || (stream->NDTR != host_dma[i].ndtr))
+        {
+            if (stream->CR & (DMA_SxCR_MSIZE_Msk | DMA_SxCR_PSIZE_Msk | DMA_SxCR_DBM_Msk))
+            {
+                host_exit(2, "host_model: only byte wide single buffer DMA is modelled\n");
+            }
+
+            host_dma[i].running = true;
+            host_dma[i].count = stream->NDTR;
+            host_dma[i].ndtr = stream->NDTR;
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: host_dma_find()
+ ********************************************************************************
+ * Summary:
+ *   Returns the index of the running stream which transfers between the USART
+ *   data register and memory in the direction, -1 if none.
+ *
+ *******************************************************************************/
+static int32_t host_dma_find(host_usart_st_t *usart, uint32_t dir)
+{
+    uint32_t dr_addr = (uint32_t)(uintptr_t)&usart->instance->DR;
+    DMA_Stream_TypeDef *stream = NULL;
+    uint32_t i = 0;
+
+    for (i = 0; i < HOST_MODEL_DMA_STREAM_NUM; i++)
+    {
+        stream = &host_DMA_Stream[i];
+
+        if (host_dma[i].running && (0U != host_dma[i].ndtr) && (dr_addr == stream->PAR) &&
+            (dir == ((stream->CR & DMA_SxCR_DIR_Msk) >> DMA_SxCR_DIR_Pos)))
+        {
+            return (int32_t)i;
+        }
+    }
+
+    return -1;
+}
+
+/*******************************************************************************
+ * Function Name: host_dma_transfer()
+ ********************************************************************************
+ * Summary:
+ *   Transfers a byte of a stream, from or to the memory, and sets the half and
+ *   full transfer flags. The circular streams restart, the others stop.
+ *
+ *******************************************************************************/
+static void host_dma_transfer(uint32_t idx, uint8_t *data, bool to_memory)
+{
+    DMA_Stream_TypeDef *stream = &host_DMA_Stream[idx];
+    host_dma_stream_st_t *dma = &host_dma[idx];
+    uint8_t *mem = (uint8_t *)(uintptr_t)stream->M0AR;
+
+    mem += (stream->CR & DMA_SxCR_MINC_Msk) ? (dma->count - dma->ndtr) : (0U);
+
+    if (to_memory)
+    {
+        *mem = *data;
+    }
+    else
+    {
+        *data = *mem;
+    }
+
+    dma->ndtr--;
+
+    if ((dma->count / 2U) == dma->ndtr)
+    {
+        host_dma_flags_set(idx, HOST_MODEL_DMA_HTIF);
+    }
+
+    if (0U == dma->ndtr)
+    {
+        host_dma_flags_set(idx, HOST_MODEL_DMA_TCIF);
+
+        if (stream->CR & DMA_SxCR_CIRC_Msk)
+        {
+            dma->ndtr = dma->count;
+        }
+        else
+        {
+            dma->running = false;
+            stream->CR &= ~DMA_SxCR_EN_Msk;
+        }
+    }
+
+    stream->NDTR = dma->ndtr;
+}
+
+/*******************************************************************************
+ * Function Name: host_usart_sync()
+ ********************************************************************************
+ * Summary:
+ *   Applies the writes of the code to SR and DR of a USART, feeds the Tx data
+ *   register from DMA, loads the shift register and updates TXE.
+ *
+ *******************************************************************************/
+static void host_usart_sync(host_usart_st_t *usart)
+{
+    USART_TypeDef *instance = usart->instance;
+    int32_t dma_idx = -1;
+    uint8_t data = 0;
+    bool tx_en = ((instance->CR1 & (USART_CR1_UE_Msk | USART_CR1_TE_Msk)) ==
+                  (USART_CR1_UE_Msk | USART_CR1_TE_Msk));
+
+    if (instance->SR != usart->sr)
+    {
+        usart->sr &= (instance->SR | (~HOST_MODEL_USART_SR_RC_W0));
+    }
+
+    if (0U == (instance->CR1 & USART_CR1_UE_Msk))
+    {
+        usart->tdr_full = false;
+        usart->shift_busy = false;
+        usart->idle_ns = 0;
+    }
+
+    /* A write to DR clears TXE and TC */
+    if ((instance->DR & HOST_MODEL_DR_IDLE_MSK) != HOST_MODEL_DR_IDLE)
+    {
+        usart->tdr = (uint8_t)instance->DR;
+        usart->tdr_full = true;
+        usart->sr &= ~USART_SR_TC_Msk;
+    }
+
+    if (tx_en && (!usart->tdr_full) && (instance->CR3 & USART_CR3_DMAT_Msk))
+    {
+        dma_idx = host_dma_find(usart, 1U);
+
+        if (dma_idx >= 0)
+        {
+            host_dma_transfer((uint32_t)dma_idx, &data, false);
+            usart->tdr = data;
+            usart->tdr_full = true;
+            usart->sr &= ~USART_SR_TC_Msk;
+        }
+    }
+
+    if (tx_en && usart->tdr_full && (!usart->shift_busy))
+    {
+        usart->shift_data = usart->tdr;
+        usart->tdr_full = false;
+        usart->shift_busy = true;
+        usart->shift_end_ns = host_sim_ns + host_usart_byte_ns(usart);
+    }
+
+    usart->sr = (usart->tdr_full) ? (usart->sr & (~USART_SR_TXE_Msk)) : (usart->sr | USART_SR_TXE_Msk);
+
+    instance->SR = usart->sr;
+    instance->DR = HOST_MODEL_DR_IDLE | usart->rx_data;
+}
+
+/*******************************************************************************
+ * Function Name: host_usart_rx()
+ ********************************************************************************
+ * Summary:
+ *   Receives a byte into DR or by DMA. The byte is only received while the Rx
+ *   has a reader, the RXNE interrupt or DMA, else it is dropped.
+ *
+ *******************************************************************************/
+static void host_usart_rx(host_usart_st_t *usart, uint8_t data)
+{
+    USART_TypeDef *instance = usart->instance;
+    int32_t dma_idx = -1;
+
+    if ((instance->CR1 & (USART_CR1_UE_Msk | USART_CR1_RE_Msk)) !=
+        (USART_CR1_UE_Msk | USART_CR1_RE_Msk))
+    {
+        return;
+    }
+
+    if (instance->CR3 & USART_CR3_DMAR_Msk)
+    {
+        dma_idx = host_dma_find(usart, 0U);
+
+        if (dma_idx < 0)
+        {
+            return;
+        }
+
+        host_dma_transfer((uint32_t)dma_idx, &data, true);
+    }
+    else if (instance->CR1 & USART_CR1_RXNEIE_Msk)
+    {
+        if (usart->sr & USART_SR_RXNE_Msk)
+        {
+            usart->sr |= USART_SR_ORE_Msk;
+        }
+        else
+        {
+            usart->rx_data = data;
+            usart->sr |= USART_SR_RXNE_Msk;
+        }
+    }
+    else
+    {
+        return;
+    }
+
+    /* IDLE is only modelled for it's interrupt */
+    if (instance->CR1 & USART_CR1_IDLEIE_Msk)
+    {
+        usart->idle_ns = host_sim_ns + host_usart_byte_ns(usart);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: host_irq_pending()
+ ********************************************************************************
+ * Summary:
+ *   Returns true if the interrupt request of the IRQ is active.
+ *
+ *******************************************************************************/
+static bool host_irq_pending(uint32_t irq)
+{
+    USART_TypeDef *instance = NULL;
+    DMA_Stream_TypeDef *stream = NULL;
+    uint32_t i = 0, sr = 0, cr1 = 0, flags = 0;
+
+    if (host_nvic_pend[irq])
+    {
+        return true;
+    }
+
+    for (i = 0; i < HOST_MODEL_USART_NUM; i++)
+    {
+        if ((uint32_t)host_usart[i].irqn == irq)
+        {
+            instance = host_usart[i].instance;
+            sr = host_usart[i].sr;
+            cr1 = instance->CR1;
+
+            return ((cr1 & USART_CR1_TXEIE_Msk) && (sr & USART_SR_TXE_Msk)) ||
+                   ((cr1 & USART_CR1_TCIE_Msk) && (sr & USART_SR_TC_Msk)) ||
+                   ((cr1 & USART_CR1_RXNEIE_Msk) && (sr & (USART_SR_RXNE_Msk | USART_SR_ORE_Msk))) ||
+                   ((cr1 & USART_CR1_IDLEIE_Msk) && (sr & USART_SR_IDLE_Msk));
+        }
+    }
+
+    for (i = 0; i < HOST_MODEL_DMA_STREAM_NUM; i++)
+    {
+        if ((uint32_t)host_dma_irqn[i] == irq)
+        {
+            stream = &host_DMA_Stream[i];
+            flags = host_dma_flags_get(i);
+
+            return ((stream->CR & DMA_SxCR_TCIE_Msk) && (flags & HOST_MODEL_DMA_TCIF)) ||
+                   ((stream->CR & DMA_SxCR_HTIE_Msk) && (flags & HOST_MODEL_DMA_HTIF)) ||
+                   ((stream->CR & DMA_SxCR_TEIE_Msk) && (flags & HOST_MODEL_DMA_TEIF));
+        }
+    }
+
+    for (i = 0; i < HOST_MODEL_TIM_NUM; i++)
+    {
+        if ((uint32_t)host_tim[i].irqn == irq)
+        {
+            return (0U != (host_tim[i].sr & host_tim[i].instance->DIER & HOST_MODEL_TIM_IRQ_MSK));
+        }
+    }
+
+    return false;
+}
+
+/*******************************************************************************
+ * Function Name: host_irq_call()
+ ********************************************************************************
+ * Summary:
+ *   Calls the handler of an IRQ in the interrupt context of the model. The
+ *   USART handlers of the libs read SR followed by DR for the Rx events, the
+ *   flags cleared by that are cleared once the handler returns, unless it
+ *   left DR unread by stopping the RXNE interrupt.
+ *
+ *******************************************************************************/
+static void host_irq_call(uint32_t irq)
+{
+    host_usart_st_t *usart = NULL;
+    uint32_t primask = host_primask;
+    uint32_t i = 0;
+    bool rx_event = false;
+
+    for (i = 0; i < HOST_MODEL_USART_NUM; i++)
+    {
+        if ((uint32_t)host_usart[i].irqn == irq)
+        {
+            usart = &host_usart[i];
+            rx_event = (0U != (usart->sr & HOST_MODEL_USART_SR_RX)) &&
+                       (0U != (usart->instance->CR1 & (USART_CR1_RXNEIE_Msk | USART_CR1_IDLEIE_Msk)));
+        }
+    }
+
+    host_nvic_pend[irq] = false;
+    host_primask = 0;
+    host_ipsr = irq + 16U;
+
+    host_vector[irq]();
+
+    host_ipsr = 0;
+    host_primask = primask;
+
+    if ((NULL != usart) && rx_event &&
+        ((0U != (usart->instance->CR1 & USART_CR1_RXNEIE_Msk)) ||
+         (0U == (usart->sr & USART_SR_RXNE_Msk))))
+    {
+        usart->sr &= ~HOST_MODEL_USART_SR_RX;
+        usart->instance->SR = usart->sr;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: host_settle()
+ ********************************************************************************
+ * Summary:
+ *   Applies the register writes of the code and calls the handlers of the
+ *   active IRQs, in the order of the IRQ number, till no IRQ is active.
+ *
+ *******************************************************************************/
+static void host_settle(void)
+{
+    static uint32_t storm = 0;
+    uint32_t i = 0, irq = 0;
+    bool called = true;
+
+    while (called)
+    {
+        called = false;
+
+        host_dma_sync();
+
+        for (i = 0; i < HOST_MODEL_USART_NUM; i++)
+        {
+            host_usart_sync(&host_usart[i]);
+        }
+
+        for (i = 0; i < HOST_MODEL_TIM_NUM; i++)
+        {
+            if (host_tim[i].instance->SR != host_tim[i].sr)
+            {
+                host_tim[i].sr &= host_tim[i].instance->SR;
+                host_tim[i].instance->SR = host_tim[i].sr;
+            }
+        }
+
+        for (irq = 0; irq < HOST_MODEL_IRQ_NUM; irq++)
+        {
+            if (host_nvic_en[irq] && (NULL != host_vector[irq]) && host_irq_pending(irq))
+            {
+                if (++storm > HOST_MODEL_IRQ_STORM)
+                {
+                    host_exit(2, "host_model: IRQ storm, a handler does not clear it's flag\n");
+                }
+
+                host_irq_call(irq);
+                called = true;
+                break;
+            }
+        }
+    }
+
+    storm = 0;
+}
+
+/*******************************************************************************
+ * Function Name: host_usart_event()
+ ********************************************************************************
+ * Summary:
+ *   Runs the USART event due at the time, the end of a byte on the line or the
+ *   Rx line turning idle. Returns false if none is due.
+ *
+ *******************************************************************************/
+static bool host_usart_event(uint64_t now)
+{
+    host_usart_st_t *usart = NULL, *next = NULL;
+    uint64_t next_ns = UINT64_MAX;
+    uint32_t i = 0;
+
+    for (i = 0; i < HOST_MODEL_USART_NUM; i++)
+    {
+        usart = &host_usart[i];
+
+        if (usart->shift_busy && (usart->shift_end_ns < next_ns))
+        {
+            next_ns = usart->shift_end_ns;
+            next = usart;
+        }
+
+        if ((0U != usart->idle_ns) && (usart->idle_ns < next_ns))
+        {
+            next_ns = usart->idle_ns;
+            next = usart;
+        }
+    }
+
+    if ((NULL == next) || (next_ns > now))
+    {
+        return false;
+    }
+
+    usart = next;
+    host_sim_ns = next_ns;
+
+    if (usart->shift_busy && (usart->shift_end_ns == next_ns))
+    {
+        usart->shift_busy = false;
+        usart->sr |= (usart->tdr_full) ? (0U) : (USART_SR_TC_Msk);
+        host_last_tx_ns = next_ns;
+        host_tx_seen = true;
+
+        if (HOST_MODEL_STDOUT_USART == usart->instance)
+        {
+            host_stdout_put(usart->shift_data);
+        }
+        else
+        {
+            host_usart_rx(usart, usart->shift_data);
+        }
+    }
+    else
+    {
+        usart->idle_ns = 0;
+        usart->sr |= USART_SR_IDLE_Msk;
+    }
+
+    usart->instance->SR = usart->sr;
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: host_irq_signal_handler()
+ ********************************************************************************
+ * Summary:
+ *   Step of the model in the interrupt context, runs the USART events due by
+ *   now in order, with the interrupts of each.
+ *
+ *******************************************************************************/
+static void host_irq_signal_handler(int sig)
+{
+    uint64_t now = host_now_ns();
+
+    (void)sig;
+
+    host_time_update(now);
+
+    while (host_usart_event(now))
+    {
+        host_settle();
+    }
+
+    host_sim_ns = now;
+    host_settle();
+}
+
+/*******************************************************************************
+ * Function Name: host_tick_signal_handler()
+ ********************************************************************************
+ * Summary:
+ *   Tick of the model, runs the counters, ends the program once it is idle,
+ *   and raises the interrupt step.
+ *
+ *******************************************************************************/
+static void host_tick_signal_handler(int sig)
+{
+    uint64_t now = host_now_ns();
+
+    (void)sig;
+
+    host_time_update(now);
+
+    if (host_tx_seen && (now > host_last_tx_ns) &&
+        ((now - host_last_tx_ns) > ((uint64_t)HOST_MODEL_IDLE_EXIT_MS * 1000000U)))
+    {
+        host_exit(0, NULL);
+    }
+
+    if (now > ((uint64_t)HOST_MODEL_RUN_MAX_MS * 1000000U))
+    {
+        host_exit(1, "host_model: run time over\n");
+    }
+
+    raise(SIGUSR1);
+}
+
+/*******************************************************************************
+ * Function Name: host_stdout_write()
+ ********************************************************************************
+ * Summary:
+ *   Write function of the stdout of the program, passes the data to fputc()
+ *   of the retarget lib, like the Arm C library does.
+ *
+ *******************************************************************************/
+static ssize_t host_stdout_write(void *cookie, const char *buff, size_t size)
+{
+    size_t i = 0;
+
+    (void)cookie;
+
+    for (i = 0; i < size; i++)
+    {
+        fputc((unsigned char)buff[i], &__stdout);
+    }
+
+    return (ssize_t)size;
+}
+
+/*******************************************************************************
+ * Function Name: host_model_init()
+ ********************************************************************************
+ * Summary:
+ *   Sets the reset state of the peripherals and the clock tree of SystemInit(),
+ *   re-targets the stdout of the program to the retarget lib, and starts the
+ *   model tick. Runs before main().
+ *
+ *******************************************************************************/
+static void __attribute__((constructor)) host_model_init(void)
+{
+    cookie_io_functions_t stdout_funcs = {.write = host_stdout_write};
+    struct sigaction action;
+    struct itimerval tick;
+    uint32_t i = 0;
+
+    /* DMA addresses are 32-bit, the program must be linked with -no-pie */
+    if ((uintptr_t)&host_USART1 > UINT32_MAX)
+    {
+        host_exit(2, "host_model: data above 4 GB, link with -no-pie\n");
+    }
+
+    RCC->CR = HOST_MODEL_RCC_CR;
+    RCC->PLLCFGR = HOST_MODEL_RCC_PLLCFGR;
+    RCC->CFGR = HOST_MODEL_RCC_CFGR;
+
+    for (i = 0; i < HOST_MODEL_USART_NUM; i++)
+    {
+        host_usart[i].sr = USART_SR_TXE_Msk | USART_SR_TC_Msk;
+        host_usart[i].instance->SR = host_usart[i].sr;
+        host_usart[i].instance->DR = HOST_MODEL_DR_IDLE;
+    }
+
+    for (i = 0; i < HOST_MODEL_TIM_NUM; i++)
+    {
+        host_tim[i].instance->ARR = 0xFFFFU;
+    }
+
+    /* TIM2 and TIM5 have a 32-bit counter */
+    TIM2->ARR = 0xFFFFFFFFU;
+    TIM5->ARR = 0xFFFFFFFFU;
+
+    clock_gettime(CLOCK_MONOTONIC, &host_start_time);
+
+    stdout = fopencookie(NULL, "w", stdout_funcs);
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    sigemptyset(&host_irq_sigset);
+    sigaddset(&host_irq_sigset, SIGUSR1);
+
+    /* The steps are not re-entered by the tick or by themselves */
+    memset(&action, 0, sizeof(action));
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaddset(&action.sa_mask, SIGALRM);
+    sigaddset(&action.sa_mask, SIGUSR1);
+    action.sa_handler = host_irq_signal_handler;
+    sigaction(SIGUSR1, &action, NULL);
+    action.sa_handler = host_tick_signal_handler;
+    sigaction(SIGALRM, &action, NULL);
+
+    tick.it_interval.tv_sec = 0;
+    tick.it_interval.tv_usec = HOST_MODEL_TICK_US;
+    tick.it_value = tick.it_interval;
+    setitimer(ITIMER_REAL, &tick, NULL);
+}
+
+/*******************************************************************************
+ * Core intrinsics, PRIMASK blocks the interrupt step of the model. In the
+ * interrupt context the signal mask is restored by the return of the step.
+ *******************************************************************************/
+void __disable_irq(void)
+{
+    host_primask = 1U;
+
+    if (0U == host_ipsr)
+    {
+        sigprocmask(SIG_BLOCK, &host_irq_sigset, NULL);
+    }
+}
+
+void __enable_irq(void)
+{
+    host_primask = 0U;
+
+    if (0U == host_ipsr)
+    {
+        sigprocmask(SIG_UNBLOCK, &host_irq_sigset, NULL);
+    }
+}
+
+uint32_t __get_PRIMASK(void)
+{
+    return host_primask;
+}
+
+void __set_PRIMASK(uint32_t primask)
+{
+    (0U != (primask & 1U)) ? (__disable_irq()) : (__enable_irq());
+}
+
+uint32_t __get_IPSR(void)
+{
+    return host_ipsr;
+}
+
+uint32_t __get_MSP(void)
+{
+    return 0U;
+}
+
+/* Sleeps till the next signal, at most a tick */
+void __WFI(void)
+{
+    pause();
+}
+
+void __WFE(void)
+{
+    pause();
+}
+
+void __SEV(void)
+{
+}
+
+void __NOP(void)
+{
+}
+
+void __DSB(void)
+{
+    __sync_synchronize();
+}
+
+void __DMB(void)
+{
+    __sync_synchronize();
+}
+
+void __ISB(void)
+{
+    __sync_synchronize();
+}
+
+uint32_t __CLZ(uint32_t value)
+{
+    return (0U == value) ? (32U) : ((uint32_t)__builtin_clz(value));
+}
+
+uint32_t __RBIT(uint32_t value)
+{
+    uint32_t result = 0, i = 0;
+
+    for (i = 0; i < 32U; i++)
+    {
+        result = (result << 1) | ((value >> i) & 1U);
+    }
+
+    return result;
+}
+
+/*******************************************************************************
+ * NVIC, the priorities are not modelled, the active IRQs are served in the
+ * order of the IRQ number and do not nest.
+ *******************************************************************************/
+void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    host_nvic_en[IRQn] = true;
+    raise(SIGUSR1);
+}
+
+void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    host_nvic_en[IRQn] = false;
+}
+
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+    (void)IRQn;
+    (void)priority;
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+    host_nvic_pend[IRQn] = true;
+    raise(SIGUSR1);
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+    host_nvic_pend[IRQn] = false;
+}
+
+uint32_t NVIC_GetPendingIRQ(IRQn_Type IRQn)
+{
+    return (host_nvic_pend[IRQn] || host_irq_pending((uint32_t)IRQn)) ? (1U) : (0U);
+}
+
+void NVIC_SystemReset(void)
+{
+    host_exit(2, "host_model: system reset\n");
+}
+
+/* End of File */
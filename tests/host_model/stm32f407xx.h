@@ -0,0 +1,586 @@
+/*******************************************************************************
+ * File Name: stm32f407xx.h
+ *
+ * Description:
+ * Host (Linux) stand-in of the STM32F407 device header, for the host build of
+ * the device libs and apps. Only the peripherals and bits used by the libs
+ * are declared. The peripherals are plain RAM objects defined in
+ * host_model.c, which models the behaviour of USART, DMA, TIM2-5 and DWT.
+ *
+ *******************************************************************************/
+#ifndef __STM32F407xx_H
+#define __STM32F407xx_H
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Interrupt numbers
+ *******************************************************************************/
+typedef enum
+{
+    NonMaskableInt_IRQn = -14,
+    SysTick_IRQn = -1,
+    WWDG_IRQn = 0,
+    DMA1_Stream0_IRQn = 11,
+    DMA1_Stream1_IRQn = 12,
+    DMA1_Stream2_IRQn = 13,
+    DMA1_Stream3_IRQn = 14,
+    DMA1_Stream4_IRQn = 15,
+    DMA1_Stream5_IRQn = 16,
+    DMA1_Stream6_IRQn = 17,
+    TIM1_CC_IRQn = 27,
+    TIM2_IRQn = 28,
+    TIM3_IRQn = 29,
+    TIM4_IRQn = 30,
+    USART1_IRQn = 37,
+    USART2_IRQn = 38,
+    USART3_IRQn = 39,
+    DMA1_Stream7_IRQn = 47,
+    TIM5_IRQn = 50,
+    UART4_IRQn = 52,
+    UART5_IRQn = 53,
+    DMA2_Stream0_IRQn = 56,
+    DMA2_Stream1_IRQn = 57,
+    DMA2_Stream2_IRQn = 58,
+    DMA2_Stream3_IRQn = 59,
+    DMA2_Stream4_IRQn = 60,
+    DMA2_Stream5_IRQn = 68,
+    DMA2_Stream6_IRQn = 69,
+    DMA2_Stream7_IRQn = 70,
+    USART6_IRQn = 71,
+} IRQn_Type;
+
+#include "core_cm4.h"
+
+/*******************************************************************************
+ * Peripheral registers
+ *******************************************************************************/
+typedef struct
+{
+    __IO uint32_t SR, DR, BRR, CR1, CR2, CR3, GTPR;
+} USART_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t MODER, OTYPER, OSPEEDR, PUPDR, IDR, ODR, BSRR, LCKR, AFR[2];
+} GPIO_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CR1, CR2, SMCR, DIER, SR, EGR, CCMR1, CCMR2, CCER, CNT, PSC, ARR, RCR,
+                  CCR1, CCR2, CCR3, CCR4, BDTR, DCR, DMAR, OR;
+} TIM_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CR, PLLCFGR, CFGR, CIR, AHB1RSTR, AHB2RSTR, AHB3RSTR, RESERVED0, APB1RSTR,
+                  APB2RSTR, RESERVED1[2], AHB1ENR, AHB2ENR, AHB3ENR, RESERVED2, APB1ENR,
+                  APB2ENR;
+} RCC_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CR, NDTR, PAR, M0AR, M1AR, FCR;
+} DMA_Stream_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t LISR, HISR, LIFCR, HIFCR;
+} DMA_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CR, CSR;
+} PWR_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t ACR;
+} FLASH_TypeDef;
+
+extern USART_TypeDef host_USART1, host_USART2, host_USART3, host_UART4, host_UART5, host_USART6;
+extern GPIO_TypeDef host_GPIOA, host_GPIOB, host_GPIOC, host_GPIOD;
+extern TIM_TypeDef host_TIM[14];
+extern RCC_TypeDef host_RCC;
+extern DMA_TypeDef host_DMA1, host_DMA2;
+/* DMA1 streams 0-7 followed by DMA2 streams 0-7, in order like on the device */
+extern DMA_Stream_TypeDef host_DMA_Stream[16];
+extern PWR_TypeDef host_PWR;
+extern FLASH_TypeDef host_FLASH;
+
+#define USART1                              (&host_USART1)
+#define USART2                              (&host_USART2)
+#define USART3                              (&host_USART3)
+#define UART4                               (&host_UART4)
+#define UART5                               (&host_UART5)
+#define USART6                              (&host_USART6)
+#define GPIOA                               (&host_GPIOA)
+#define GPIOB                               (&host_GPIOB)
+#define GPIOC                               (&host_GPIOC)
+#define GPIOD                               (&host_GPIOD)
+#define TIM1                                (&host_TIM[0])
+#define TIM2                                (&host_TIM[1])
+#define TIM3                                (&host_TIM[2])
+#define TIM4                                (&host_TIM[3])
+#define TIM5                                (&host_TIM[4])
+#define TIM6                                (&host_TIM[5])
+#define TIM7                                (&host_TIM[6])
+#define TIM8                                (&host_TIM[7])
+#define TIM9                                (&host_TIM[8])
+#define TIM10                               (&host_TIM[9])
+#define TIM11                               (&host_TIM[10])
+#define TIM12                               (&host_TIM[11])
+#define TIM13                               (&host_TIM[12])
+#define TIM14                               (&host_TIM[13])
+#define RCC                                 (&host_RCC)
+#define DMA1                                (&host_DMA1)
+#define DMA2                                (&host_DMA2)
+#define DMA1_Stream0                        (&host_DMA_Stream[0])
+#define DMA1_Stream1                        (&host_DMA_Stream[1])
+#define DMA1_Stream2                        (&host_DMA_Stream[2])
+#define DMA1_Stream3                        (&host_DMA_Stream[3])
+#define DMA1_Stream4                        (&host_DMA_Stream[4])
+#define DMA1_Stream5                        (&host_DMA_Stream[5])
+#define DMA1_Stream6                        (&host_DMA_Stream[6])
+#define DMA1_Stream7                        (&host_DMA_Stream[7])
+#define DMA2_Stream0                        (&host_DMA_Stream[8])
+#define DMA2_Stream1                        (&host_DMA_Stream[9])
+#define DMA2_Stream2                        (&host_DMA_Stream[10])
+#define DMA2_Stream3                        (&host_DMA_Stream[11])
+#define DMA2_Stream4                        (&host_DMA_Stream[12])
+#define DMA2_Stream5                        (&host_DMA_Stream[13])
+#define DMA2_Stream6                        (&host_DMA_Stream[14])
+#define DMA2_Stream7                        (&host_DMA_Stream[15])
+#define PWR                                 (&host_PWR)
+#define FLASH                               (&host_FLASH)
+
+/* Addresses of the memories, only used as numbers by the libs */
+#define FLASH_BASE                          (0x08000000UL)
+#define SRAM_BASE                           (0x20000000UL)
+#define BKPSRAM_BASE                        (0x40024000UL)
+
+/*******************************************************************************
+ * Register bits
+ *******************************************************************************/
+#define USART_SR_PE_Pos                  (0U)
+#define USART_SR_PE_Msk                  (0x1UL << USART_SR_PE_Pos)
+#define USART_SR_PE                      USART_SR_PE_Msk
+#define USART_SR_FE_Pos                  (1U)
+#define USART_SR_FE_Msk                  (0x1UL << USART_SR_FE_Pos)
+#define USART_SR_FE                      USART_SR_FE_Msk
+#define USART_SR_NE_Pos                  (2U)
+#define USART_SR_NE_Msk                  (0x1UL << USART_SR_NE_Pos)
+#define USART_SR_NE                      USART_SR_NE_Msk
+#define USART_SR_ORE_Pos                 (3U)
+#define USART_SR_ORE_Msk                 (0x1UL << USART_SR_ORE_Pos)
+#define USART_SR_ORE                     USART_SR_ORE_Msk
+#define USART_SR_IDLE_Pos                (4U)
+#define USART_SR_IDLE_Msk                (0x1UL << USART_SR_IDLE_Pos)
+#define USART_SR_IDLE                    USART_SR_IDLE_Msk
+#define USART_SR_RXNE_Pos                (5U)
+#define USART_SR_RXNE_Msk                (0x1UL << USART_SR_RXNE_Pos)
+#define USART_SR_RXNE                    USART_SR_RXNE_Msk
+#define USART_SR_TC_Pos                  (6U)
+#define USART_SR_TC_Msk                  (0x1UL << USART_SR_TC_Pos)
+#define USART_SR_TC                      USART_SR_TC_Msk
+#define USART_SR_TXE_Pos                 (7U)
+#define USART_SR_TXE_Msk                 (0x1UL << USART_SR_TXE_Pos)
+#define USART_SR_TXE                     USART_SR_TXE_Msk
+#define USART_SR_LBD_Pos                 (8U)
+#define USART_SR_LBD_Msk                 (0x1UL << USART_SR_LBD_Pos)
+#define USART_SR_LBD                     USART_SR_LBD_Msk
+#define USART_SR_CTS_Pos                 (9U)
+#define USART_SR_CTS_Msk                 (0x1UL << USART_SR_CTS_Pos)
+#define USART_SR_CTS                     USART_SR_CTS_Msk
+#define USART_CR1_SBK_Pos                (0U)
+#define USART_CR1_SBK_Msk                (0x1UL << USART_CR1_SBK_Pos)
+#define USART_CR1_SBK                    USART_CR1_SBK_Msk
+#define USART_CR1_RWU_Pos                (1U)
+#define USART_CR1_RWU_Msk                (0x1UL << USART_CR1_RWU_Pos)
+#define USART_CR1_RWU                    USART_CR1_RWU_Msk
+#define USART_CR1_RE_Pos                 (2U)
+#define USART_CR1_RE_Msk                 (0x1UL << USART_CR1_RE_Pos)
+#define USART_CR1_RE                     USART_CR1_RE_Msk
+#define USART_CR1_TE_Pos                 (3U)
+#define USART_CR1_TE_Msk                 (0x1UL << USART_CR1_TE_Pos)
+#define USART_CR1_TE                     USART_CR1_TE_Msk
+#define USART_CR1_IDLEIE_Pos             (4U)
+#define USART_CR1_IDLEIE_Msk             (0x1UL << USART_CR1_IDLEIE_Pos)
+#define USART_CR1_IDLEIE                 USART_CR1_IDLEIE_Msk
+#define USART_CR1_RXNEIE_Pos             (5U)
+#define USART_CR1_RXNEIE_Msk             (0x1UL << USART_CR1_RXNEIE_Pos)
+#define USART_CR1_RXNEIE                 USART_CR1_RXNEIE_Msk
+#define USART_CR1_TCIE_Pos               (6U)
+#define USART_CR1_TCIE_Msk               (0x1UL << USART_CR1_TCIE_Pos)
+#define USART_CR1_TCIE                   USART_CR1_TCIE_Msk
+#define USART_CR1_TXEIE_Pos              (7U)
+#define USART_CR1_TXEIE_Msk              (0x1UL << USART_CR1_TXEIE_Pos)
+#define USART_CR1_TXEIE                  USART_CR1_TXEIE_Msk
+#define USART_CR1_PEIE_Pos               (8U)
+#define USART_CR1_PEIE_Msk               (0x1UL << USART_CR1_PEIE_Pos)
+#define USART_CR1_PEIE                   USART_CR1_PEIE_Msk
+#define USART_CR1_PS_Pos                 (9U)
+#define USART_CR1_PS_Msk                 (0x1UL << USART_CR1_PS_Pos)
+#define USART_CR1_PS                     USART_CR1_PS_Msk
+#define USART_CR1_PCE_Pos                (10U)
+#define USART_CR1_PCE_Msk                (0x1UL << USART_CR1_PCE_Pos)
+#define USART_CR1_PCE                    USART_CR1_PCE_Msk
+#define USART_CR1_WAKE_Pos               (11U)
+#define USART_CR1_WAKE_Msk               (0x1UL << USART_CR1_WAKE_Pos)
+#define USART_CR1_WAKE                   USART_CR1_WAKE_Msk
+#define USART_CR1_M_Pos                  (12U)
+#define USART_CR1_M_Msk                  (0x1UL << USART_CR1_M_Pos)
+#define USART_CR1_M                      USART_CR1_M_Msk
+#define USART_CR1_UE_Pos                 (13U)
+#define USART_CR1_UE_Msk                 (0x1UL << USART_CR1_UE_Pos)
+#define USART_CR1_UE                     USART_CR1_UE_Msk
+#define USART_CR1_OVER8_Pos              (15U)
+#define USART_CR1_OVER8_Msk              (0x1UL << USART_CR1_OVER8_Pos)
+#define USART_CR1_OVER8                  USART_CR1_OVER8_Msk
+#define USART_CR2_STOP_Pos               (12U)
+#define USART_CR2_STOP_Msk               (0x3UL << USART_CR2_STOP_Pos)
+#define USART_CR2_STOP                   USART_CR2_STOP_Msk
+#define USART_CR3_EIE_Pos                (0U)
+#define USART_CR3_EIE_Msk                (0x1UL << USART_CR3_EIE_Pos)
+#define USART_CR3_EIE                    USART_CR3_EIE_Msk
+#define USART_CR3_IREN_Pos               (1U)
+#define USART_CR3_IREN_Msk               (0x1UL << USART_CR3_IREN_Pos)
+#define USART_CR3_IREN                   USART_CR3_IREN_Msk
+#define USART_CR3_HDSEL_Pos              (3U)
+#define USART_CR3_HDSEL_Msk              (0x1UL << USART_CR3_HDSEL_Pos)
+#define USART_CR3_HDSEL                  USART_CR3_HDSEL_Msk
+#define USART_CR3_DMAR_Pos               (6U)
+#define USART_CR3_DMAR_Msk               (0x1UL << USART_CR3_DMAR_Pos)
+#define USART_CR3_DMAR                   USART_CR3_DMAR_Msk
+#define USART_CR3_DMAT_Pos               (7U)
+#define USART_CR3_DMAT_Msk               (0x1UL << USART_CR3_DMAT_Pos)
+#define USART_CR3_DMAT                   USART_CR3_DMAT_Msk
+#define USART_CR3_RTSE_Pos               (8U)
+#define USART_CR3_RTSE_Msk               (0x1UL << USART_CR3_RTSE_Pos)
+#define USART_CR3_RTSE                   USART_CR3_RTSE_Msk
+#define USART_CR3_CTSE_Pos               (9U)
+#define USART_CR3_CTSE_Msk               (0x1UL << USART_CR3_CTSE_Pos)
+#define USART_CR3_CTSE                   USART_CR3_CTSE_Msk
+#define USART_CR3_CTSIE_Pos              (10U)
+#define USART_CR3_CTSIE_Msk              (0x1UL << USART_CR3_CTSIE_Pos)
+#define USART_CR3_CTSIE                  USART_CR3_CTSIE_Msk
+#define USART_CR3_ONEBIT_Pos             (11U)
+#define USART_CR3_ONEBIT_Msk             (0x1UL << USART_CR3_ONEBIT_Pos)
+#define USART_CR3_ONEBIT                 USART_CR3_ONEBIT_Msk
+#define USART_BRR_DIV_Fraction_Pos       (0U)
+#define USART_BRR_DIV_Fraction_Msk       (0xFUL << USART_BRR_DIV_Fraction_Pos)
+#define USART_BRR_DIV_Fraction           USART_BRR_DIV_Fraction_Msk
+#define USART_BRR_DIV_Mantissa_Pos       (4U)
+#define USART_BRR_DIV_Mantissa_Msk       (0xFFFUL << USART_BRR_DIV_Mantissa_Pos)
+#define USART_BRR_DIV_Mantissa           USART_BRR_DIV_Mantissa_Msk
+
+#define DMA_SxCR_EN_Pos                  (0U)
+#define DMA_SxCR_EN_Msk                  (0x1UL << DMA_SxCR_EN_Pos)
+#define DMA_SxCR_EN                      DMA_SxCR_EN_Msk
+#define DMA_SxCR_DMEIE_Pos               (1U)
+#define DMA_SxCR_DMEIE_Msk               (0x1UL << DMA_SxCR_DMEIE_Pos)
+#define DMA_SxCR_DMEIE                   DMA_SxCR_DMEIE_Msk
+#define DMA_SxCR_TEIE_Pos                (2U)
+#define DMA_SxCR_TEIE_Msk                (0x1UL << DMA_SxCR_TEIE_Pos)
+#define DMA_SxCR_TEIE                    DMA_SxCR_TEIE_Msk
+#define DMA_SxCR_HTIE_Pos                (3U)
+#define DMA_SxCR_HTIE_Msk                (0x1UL << DMA_SxCR_HTIE_Pos)
+#define DMA_SxCR_HTIE                    DMA_SxCR_HTIE_Msk
+#define DMA_SxCR_TCIE_Pos                (4U)
+#define DMA_SxCR_TCIE_Msk                (0x1UL << DMA_SxCR_TCIE_Pos)
+#define DMA_SxCR_TCIE                    DMA_SxCR_TCIE_Msk
+#define DMA_SxCR_PFCTRL_Pos              (5U)
+#define DMA_SxCR_PFCTRL_Msk              (0x1UL << DMA_SxCR_PFCTRL_Pos)
+#define DMA_SxCR_PFCTRL                  DMA_SxCR_PFCTRL_Msk
+#define DMA_SxCR_DIR_Pos                 (6U)
+#define DMA_SxCR_DIR_Msk                 (0x3UL << DMA_SxCR_DIR_Pos)
+#define DMA_SxCR_DIR                     DMA_SxCR_DIR_Msk
+#define DMA_SxCR_CIRC_Pos                (8U)
+#define DMA_SxCR_CIRC_Msk                (0x1UL << DMA_SxCR_CIRC_Pos)
+#define DMA_SxCR_CIRC                    DMA_SxCR_CIRC_Msk
+#define DMA_SxCR_PINC_Pos                (9U)
+#define DMA_SxCR_PINC_Msk                (0x1UL << DMA_SxCR_PINC_Pos)
+#define DMA_SxCR_PINC                    DMA_SxCR_PINC_Msk
+#define DMA_SxCR_MINC_Pos                (10U)
+#define DMA_SxCR_MINC_Msk                (0x1UL << DMA_SxCR_MINC_Pos)
+#define DMA_SxCR_MINC                    DMA_SxCR_MINC_Msk
+#define DMA_SxCR_PSIZE_Pos               (11U)
+#define DMA_SxCR_PSIZE_Msk               (0x3UL << DMA_SxCR_PSIZE_Pos)
+#define DMA_SxCR_PSIZE                   DMA_SxCR_PSIZE_Msk
+#define DMA_SxCR_MSIZE_Pos               (13U)
+#define DMA_SxCR_MSIZE_Msk               (0x3UL << DMA_SxCR_MSIZE_Pos)
+#define DMA_SxCR_MSIZE                   DMA_SxCR_MSIZE_Msk
+#define DMA_SxCR_PINCOS_Pos              (15U)
+#define DMA_SxCR_PINCOS_Msk              (0x1UL << DMA_SxCR_PINCOS_Pos)
+#define DMA_SxCR_PINCOS                  DMA_SxCR_PINCOS_Msk
+#define DMA_SxCR_PL_Pos                  (16U)
+#define DMA_SxCR_PL_Msk                  (0x3UL << DMA_SxCR_PL_Pos)
+#define DMA_SxCR_PL                      DMA_SxCR_PL_Msk
+#define DMA_SxCR_DBM_Pos                 (18U)
+#define DMA_SxCR_DBM_Msk                 (0x1UL << DMA_SxCR_DBM_Pos)
+#define DMA_SxCR_DBM                     DMA_SxCR_DBM_Msk
+#define DMA_SxCR_CT_Pos                  (19U)
+#define DMA_SxCR_CT_Msk                  (0x1UL << DMA_SxCR_CT_Pos)
+#define DMA_SxCR_CT                      DMA_SxCR_CT_Msk
+#define DMA_SxCR_PBURST_Pos              (21U)
+#define DMA_SxCR_PBURST_Msk              (0x3UL << DMA_SxCR_PBURST_Pos)
+#define DMA_SxCR_PBURST                  DMA_SxCR_PBURST_Msk
+#define DMA_SxCR_MBURST_Pos              (23U)
+#define DMA_SxCR_MBURST_Msk              (0x3UL << DMA_SxCR_MBURST_Pos)
+#define DMA_SxCR_MBURST                  DMA_SxCR_MBURST_Msk
+#define DMA_SxCR_CHSEL_Pos               (25U)
+#define DMA_SxCR_CHSEL_Msk               (0x7UL << DMA_SxCR_CHSEL_Pos)
+#define DMA_SxCR_CHSEL                   DMA_SxCR_CHSEL_Msk
+#define DMA_SxFCR_FTH_Pos                (0U)
+#define DMA_SxFCR_FTH_Msk                (0x3UL << DMA_SxFCR_FTH_Pos)
+#define DMA_SxFCR_FTH                    DMA_SxFCR_FTH_Msk
+#define DMA_SxFCR_DMDIS_Pos              (2U)
+#define DMA_SxFCR_DMDIS_Msk              (0x1UL << DMA_SxFCR_DMDIS_Pos)
+#define DMA_SxFCR_DMDIS                  DMA_SxFCR_DMDIS_Msk
+#define DMA_SxFCR_FEIE_Pos               (7U)
+#define DMA_SxFCR_FEIE_Msk               (0x1UL << DMA_SxFCR_FEIE_Pos)
+#define DMA_SxFCR_FEIE                   DMA_SxFCR_FEIE_Msk
+
+#define TIM_CR1_CEN_Pos                  (0U)
+#define TIM_CR1_CEN_Msk                  (0x1UL << TIM_CR1_CEN_Pos)
+#define TIM_CR1_CEN                      TIM_CR1_CEN_Msk
+#define TIM_CR1_UDIS_Pos                 (1U)
+#define TIM_CR1_UDIS_Msk                 (0x1UL << TIM_CR1_UDIS_Pos)
+#define TIM_CR1_UDIS                     TIM_CR1_UDIS_Msk
+#define TIM_CR1_URS_Pos                  (2U)
+#define TIM_CR1_URS_Msk                  (0x1UL << TIM_CR1_URS_Pos)
+#define TIM_CR1_URS                      TIM_CR1_URS_Msk
+#define TIM_CR1_OPM_Pos                  (3U)
+#define TIM_CR1_OPM_Msk                  (0x1UL << TIM_CR1_OPM_Pos)
+#define TIM_CR1_OPM                      TIM_CR1_OPM_Msk
+#define TIM_CR1_DIR_Pos                  (4U)
+#define TIM_CR1_DIR_Msk                  (0x1UL << TIM_CR1_DIR_Pos)
+#define TIM_CR1_DIR                      TIM_CR1_DIR_Msk
+#define TIM_CR1_ARPE_Pos                 (7U)
+#define TIM_CR1_ARPE_Msk                 (0x1UL << TIM_CR1_ARPE_Pos)
+#define TIM_CR1_ARPE                     TIM_CR1_ARPE_Msk
+#define TIM_CR1_CKD_Pos                  (8U)
+#define TIM_CR1_CKD_Msk                  (0x3UL << TIM_CR1_CKD_Pos)
+#define TIM_CR1_CKD                      TIM_CR1_CKD_Msk
+#define TIM_DIER_UIE_Pos                 (0U)
+#define TIM_DIER_UIE_Msk                 (0x1UL << TIM_DIER_UIE_Pos)
+#define TIM_DIER_UIE                     TIM_DIER_UIE_Msk
+#define TIM_DIER_CC1IE_Pos               (1U)
+#define TIM_DIER_CC1IE_Msk               (0x1UL << TIM_DIER_CC1IE_Pos)
+#define TIM_DIER_CC1IE                   TIM_DIER_CC1IE_Msk
+#define TIM_DIER_CC2IE_Pos               (2U)
+#define TIM_DIER_CC2IE_Msk               (0x1UL << TIM_DIER_CC2IE_Pos)
+#define TIM_DIER_CC2IE                   TIM_DIER_CC2IE_Msk
+#define TIM_DIER_CC3IE_Pos               (3U)
+#define TIM_DIER_CC3IE_Msk               (0x1UL << TIM_DIER_CC3IE_Pos)
+#define TIM_DIER_CC3IE                   TIM_DIER_CC3IE_Msk
+#define TIM_DIER_CC4IE_Pos               (4U)
+#define TIM_DIER_CC4IE_Msk               (0x1UL << TIM_DIER_CC4IE_Pos)
+#define TIM_DIER_CC4IE                   TIM_DIER_CC4IE_Msk
+#define TIM_SR_UIF_Pos                   (0U)
+#define TIM_SR_UIF_Msk                   (0x1UL << TIM_SR_UIF_Pos)
+#define TIM_SR_UIF                       TIM_SR_UIF_Msk
+#define TIM_SR_CC1IF_Pos                 (1U)
+#define TIM_SR_CC1IF_Msk                 (0x1UL << TIM_SR_CC1IF_Pos)
+#define TIM_SR_CC1IF                     TIM_SR_CC1IF_Msk
+#define TIM_SR_CC2IF_Pos                 (2U)
+#define TIM_SR_CC2IF_Msk                 (0x1UL << TIM_SR_CC2IF_Pos)
+#define TIM_SR_CC2IF                     TIM_SR_CC2IF_Msk
+#define TIM_SR_CC3IF_Pos                 (3U)
+#define TIM_SR_CC3IF_Msk                 (0x1UL << TIM_SR_CC3IF_Pos)
+#define TIM_SR_CC3IF                     TIM_SR_CC3IF_Msk
+#define TIM_SR_CC4IF_Pos                 (4U)
+#define TIM_SR_CC4IF_Msk                 (0x1UL << TIM_SR_CC4IF_Pos)
+#define TIM_SR_CC4IF                     TIM_SR_CC4IF_Msk
+#define TIM_SR_CC1OF_Pos                 (9U)
+#define TIM_SR_CC1OF_Msk                 (0x1UL << TIM_SR_CC1OF_Pos)
+#define TIM_SR_CC1OF                     TIM_SR_CC1OF_Msk
+#define TIM_SR_CC2OF_Pos                 (10U)
+#define TIM_SR_CC2OF_Msk                 (0x1UL << TIM_SR_CC2OF_Pos)
+#define TIM_SR_CC2OF                     TIM_SR_CC2OF_Msk
+#define TIM_SR_CC3OF_Pos                 (11U)
+#define TIM_SR_CC3OF_Msk                 (0x1UL << TIM_SR_CC3OF_Pos)
+#define TIM_SR_CC3OF                     TIM_SR_CC3OF_Msk
+#define TIM_SR_CC4OF_Pos                 (12U)
+#define TIM_SR_CC4OF_Msk                 (0x1UL << TIM_SR_CC4OF_Pos)
+#define TIM_SR_CC4OF                     TIM_SR_CC4OF_Msk
+#define TIM_EGR_UG_Pos                   (0U)
+#define TIM_EGR_UG_Msk                   (0x1UL << TIM_EGR_UG_Pos)
+#define TIM_EGR_UG                       TIM_EGR_UG_Msk
+#define TIM_CCMR1_CC1S_Pos               (0U)
+#define TIM_CCMR1_CC1S_Msk               (0x3UL << TIM_CCMR1_CC1S_Pos)
+#define TIM_CCMR1_CC1S                   TIM_CCMR1_CC1S_Msk
+#define TIM_CCMR1_IC1F_Pos               (4U)
+#define TIM_CCMR1_IC1F_Msk               (0xFUL << TIM_CCMR1_IC1F_Pos)
+#define TIM_CCMR1_IC1F                   TIM_CCMR1_IC1F_Msk
+#define TIM_CCMR1_OC1M_Pos               (4U)
+#define TIM_CCMR1_OC1M_Msk               (0x7UL << TIM_CCMR1_OC1M_Pos)
+#define TIM_CCMR1_OC1M                   TIM_CCMR1_OC1M_Msk
+#define TIM_CCMR1_CC2S_Pos               (8U)
+#define TIM_CCMR1_CC2S_Msk               (0x3UL << TIM_CCMR1_CC2S_Pos)
+#define TIM_CCMR1_CC2S                   TIM_CCMR1_CC2S_Msk
+#define TIM_CCMR1_OC2M_Pos               (12U)
+#define TIM_CCMR1_OC2M_Msk               (0x7UL << TIM_CCMR1_OC2M_Pos)
+#define TIM_CCMR1_OC2M                   TIM_CCMR1_OC2M_Msk
+#define TIM_CCMR1_IC2F_Pos               (12U)
+#define TIM_CCMR1_IC2F_Msk               (0xFUL << TIM_CCMR1_IC2F_Pos)
+#define TIM_CCMR1_IC2F                   TIM_CCMR1_IC2F_Msk
+#define TIM_CCMR1_IC1PSC_Pos             (2U)
+#define TIM_CCMR1_IC1PSC_Msk             (0x3UL << TIM_CCMR1_IC1PSC_Pos)
+#define TIM_CCMR1_IC1PSC                 TIM_CCMR1_IC1PSC_Msk
+#define TIM_CCER_CC1E_Pos                (0U)
+#define TIM_CCER_CC1E_Msk                (0x1UL << TIM_CCER_CC1E_Pos)
+#define TIM_CCER_CC1E                    TIM_CCER_CC1E_Msk
+#define TIM_CCER_CC1P_Pos                (1U)
+#define TIM_CCER_CC1P_Msk                (0x1UL << TIM_CCER_CC1P_Pos)
+#define TIM_CCER_CC1P                    TIM_CCER_CC1P_Msk
+#define TIM_CCER_CC1NP_Pos               (3U)
+#define TIM_CCER_CC1NP_Msk               (0x1UL << TIM_CCER_CC1NP_Pos)
+#define TIM_CCER_CC1NP                   TIM_CCER_CC1NP_Msk
+#define TIM_EGR_CC1G_Pos                 (1U)
+#define TIM_EGR_CC1G_Msk                 (0x1UL << TIM_EGR_CC1G_Pos)
+#define TIM_EGR_CC1G                     TIM_EGR_CC1G_Msk
+#define TIM_EGR_CC2G_Pos                 (2U)
+#define TIM_EGR_CC2G_Msk                 (0x1UL << TIM_EGR_CC2G_Pos)
+#define TIM_EGR_CC2G                     TIM_EGR_CC2G_Msk
+
+#define RCC_CR_HSION_Pos                 (0U)
+#define RCC_CR_HSION_Msk                 (0x1UL << RCC_CR_HSION_Pos)
+#define RCC_CR_HSION                     RCC_CR_HSION_Msk
+#define RCC_CR_HSIRDY_Pos                (1U)
+#define RCC_CR_HSIRDY_Msk                (0x1UL << RCC_CR_HSIRDY_Pos)
+#define RCC_CR_HSIRDY                    RCC_CR_HSIRDY_Msk
+#define RCC_CR_HSEON_Pos                 (16U)
+#define RCC_CR_HSEON_Msk                 (0x1UL << RCC_CR_HSEON_Pos)
+#define RCC_CR_HSEON                     RCC_CR_HSEON_Msk
+#define RCC_CR_HSERDY_Pos                (17U)
+#define RCC_CR_HSERDY_Msk                (0x1UL << RCC_CR_HSERDY_Pos)
+#define RCC_CR_HSERDY                    RCC_CR_HSERDY_Msk
+#define RCC_CR_PLLON_Pos                 (24U)
+#define RCC_CR_PLLON_Msk                 (0x1UL << RCC_CR_PLLON_Pos)
+#define RCC_CR_PLLON                     RCC_CR_PLLON_Msk
+#define RCC_CR_PLLRDY_Pos                (25U)
+#define RCC_CR_PLLRDY_Msk                (0x1UL << RCC_CR_PLLRDY_Pos)
+#define RCC_CR_PLLRDY                    RCC_CR_PLLRDY_Msk
+#define RCC_CFGR_SW_Pos                  (0U)
+#define RCC_CFGR_SW_Msk                  (0x3UL << RCC_CFGR_SW_Pos)
+#define RCC_CFGR_SW                      RCC_CFGR_SW_Msk
+#define RCC_CFGR_SWS_Pos                 (2U)
+#define RCC_CFGR_SWS_Msk                 (0x3UL << RCC_CFGR_SWS_Pos)
+#define RCC_CFGR_SWS                     RCC_CFGR_SWS_Msk
+#define RCC_CFGR_HPRE_Pos                (4U)
+#define RCC_CFGR_HPRE_Msk                (0xFUL << RCC_CFGR_HPRE_Pos)
+#define RCC_CFGR_HPRE                    RCC_CFGR_HPRE_Msk
+#define RCC_CFGR_PPRE1_Pos               (10U)
+#define RCC_CFGR_PPRE1_Msk               (0x7UL << RCC_CFGR_PPRE1_Pos)
+#define RCC_CFGR_PPRE1                   RCC_CFGR_PPRE1_Msk
+#define RCC_CFGR_PPRE2_Pos               (13U)
+#define RCC_CFGR_PPRE2_Msk               (0x7UL << RCC_CFGR_PPRE2_Pos)
+#define RCC_CFGR_PPRE2                   RCC_CFGR_PPRE2_Msk
+#define RCC_CFGR_RTCPRE_Pos              (16U)
+#define RCC_CFGR_RTCPRE_Msk              (0x1FUL << RCC_CFGR_RTCPRE_Pos)
+#define RCC_CFGR_RTCPRE                  RCC_CFGR_RTCPRE_Msk
+#define RCC_CFGR_MCO1_Pos                (21U)
+#define RCC_CFGR_MCO1_Msk                (0x3UL << RCC_CFGR_MCO1_Pos)
+#define RCC_CFGR_MCO1                    RCC_CFGR_MCO1_Msk
+#define RCC_CFGR_MCO1PRE_Pos             (24U)
+#define RCC_CFGR_MCO1PRE_Msk             (0x7UL << RCC_CFGR_MCO1PRE_Pos)
+#define RCC_CFGR_MCO1PRE                 RCC_CFGR_MCO1PRE_Msk
+#define RCC_CFGR_MCO2PRE_Pos             (27U)
+#define RCC_CFGR_MCO2PRE_Msk             (0x7UL << RCC_CFGR_MCO2PRE_Pos)
+#define RCC_CFGR_MCO2PRE                 RCC_CFGR_MCO2PRE_Msk
+#define RCC_CFGR_MCO2_Pos                (30U)
+#define RCC_CFGR_MCO2_Msk                (0x3UL << RCC_CFGR_MCO2_Pos)
+#define RCC_CFGR_MCO2                    RCC_CFGR_MCO2_Msk
+#define RCC_PLLCFGR_PLLM_Pos             (0U)
+#define RCC_PLLCFGR_PLLM_Msk             (0x3FUL << RCC_PLLCFGR_PLLM_Pos)
+#define RCC_PLLCFGR_PLLM                 RCC_PLLCFGR_PLLM_Msk
+#define RCC_PLLCFGR_PLLN_Pos             (6U)
+#define RCC_PLLCFGR_PLLN_Msk             (0x1FFUL << RCC_PLLCFGR_PLLN_Pos)
+#define RCC_PLLCFGR_PLLN                 RCC_PLLCFGR_PLLN_Msk
+#define RCC_PLLCFGR_PLLP_Pos             (16U)
+#define RCC_PLLCFGR_PLLP_Msk             (0x3UL << RCC_PLLCFGR_PLLP_Pos)
+#define RCC_PLLCFGR_PLLP                 RCC_PLLCFGR_PLLP_Msk
+#define RCC_PLLCFGR_PLLSRC_Pos           (22U)
+#define RCC_PLLCFGR_PLLSRC_Msk           (0x1UL << RCC_PLLCFGR_PLLSRC_Pos)
+#define RCC_PLLCFGR_PLLSRC               RCC_PLLCFGR_PLLSRC_Msk
+#define RCC_PLLCFGR_PLLQ_Pos             (24U)
+#define RCC_PLLCFGR_PLLQ_Msk             (0xFUL << RCC_PLLCFGR_PLLQ_Pos)
+#define RCC_PLLCFGR_PLLQ                 RCC_PLLCFGR_PLLQ_Msk
+#define RCC_AHB1ENR_GPIOAEN_Pos          (0U)
+#define RCC_AHB1ENR_GPIOAEN_Msk          (0x1UL << RCC_AHB1ENR_GPIOAEN_Pos)
+#define RCC_AHB1ENR_GPIOAEN              RCC_AHB1ENR_GPIOAEN_Msk
+#define RCC_AHB1ENR_GPIOCEN_Pos          (2U)
+#define RCC_AHB1ENR_GPIOCEN_Msk          (0x1UL << RCC_AHB1ENR_GPIOCEN_Pos)
+#define RCC_AHB1ENR_GPIOCEN              RCC_AHB1ENR_GPIOCEN_Msk
+#define RCC_AHB1ENR_BKPSRAMEN_Pos        (18U)
+#define RCC_AHB1ENR_BKPSRAMEN_Msk        (0x1UL << RCC_AHB1ENR_BKPSRAMEN_Pos)
+#define RCC_AHB1ENR_BKPSRAMEN            RCC_AHB1ENR_BKPSRAMEN_Msk
+#define RCC_AHB1ENR_DMA1EN_Pos           (21U)
+#define RCC_AHB1ENR_DMA1EN_Msk           (0x1UL << RCC_AHB1ENR_DMA1EN_Pos)
+#define RCC_AHB1ENR_DMA1EN               RCC_AHB1ENR_DMA1EN_Msk
+#define RCC_AHB1ENR_DMA2EN_Pos           (22U)
+#define RCC_AHB1ENR_DMA2EN_Msk           (0x1UL << RCC_AHB1ENR_DMA2EN_Pos)
+#define RCC_AHB1ENR_DMA2EN               RCC_AHB1ENR_DMA2EN_Msk
+#define RCC_APB1ENR_TIM2EN_Pos           (0U)
+#define RCC_APB1ENR_TIM2EN_Msk           (0x1UL << RCC_APB1ENR_TIM2EN_Pos)
+#define RCC_APB1ENR_TIM2EN               RCC_APB1ENR_TIM2EN_Msk
+#define RCC_APB1ENR_TIM5EN_Pos           (3U)
+#define RCC_APB1ENR_TIM5EN_Msk           (0x1UL << RCC_APB1ENR_TIM5EN_Pos)
+#define RCC_APB1ENR_TIM5EN               RCC_APB1ENR_TIM5EN_Msk
+#define RCC_APB1ENR_USART2EN_Pos         (17U)
+#define RCC_APB1ENR_USART2EN_Msk         (0x1UL << RCC_APB1ENR_USART2EN_Pos)
+#define RCC_APB1ENR_USART2EN             RCC_APB1ENR_USART2EN_Msk
+#define RCC_APB1ENR_PWREN_Pos            (28U)
+#define RCC_APB1ENR_PWREN_Msk            (0x1UL << RCC_APB1ENR_PWREN_Pos)
+#define RCC_APB1ENR_PWREN                RCC_APB1ENR_PWREN_Msk
+#define RCC_APB2ENR_TIM1EN_Pos           (0U)
+#define RCC_APB2ENR_TIM1EN_Msk           (0x1UL << RCC_APB2ENR_TIM1EN_Pos)
+#define RCC_APB2ENR_TIM1EN               RCC_APB2ENR_TIM1EN_Msk
+#define RCC_APB2ENR_USART1EN_Pos         (4U)
+#define RCC_APB2ENR_USART1EN_Msk         (0x1UL << RCC_APB2ENR_USART1EN_Pos)
+#define RCC_APB2ENR_USART1EN             RCC_APB2ENR_USART1EN_Msk
+#define RCC_APB2ENR_USART6EN_Pos         (5U)
+#define RCC_APB2ENR_USART6EN_Msk         (0x1UL << RCC_APB2ENR_USART6EN_Pos)
+#define RCC_APB2ENR_USART6EN             RCC_APB2ENR_USART6EN_Msk
+#define RCC_APB2ENR_TIM9EN_Pos           (16U)
+#define RCC_APB2ENR_TIM9EN_Msk           (0x1UL << RCC_APB2ENR_TIM9EN_Pos)
+#define RCC_APB2ENR_TIM9EN               RCC_APB2ENR_TIM9EN_Msk
+
+#define PWR_CR_DBP_Pos                   (8U)
+#define PWR_CR_DBP_Msk                   (0x1UL << PWR_CR_DBP_Pos)
+#define PWR_CR_DBP                       PWR_CR_DBP_Msk
+#define PWR_CSR_BRE_Pos                  (9U)
+#define PWR_CSR_BRE_Msk                  (0x1UL << PWR_CSR_BRE_Pos)
+#define PWR_CSR_BRE                      PWR_CSR_BRE_Msk
+#define PWR_CSR_BRR_Pos                  (3U)
+#define PWR_CSR_BRR_Msk                  (0x1UL << PWR_CSR_BRR_Pos)
+#define PWR_CSR_BRR                      PWR_CSR_BRR_Msk
+
+#define GPIO_MODER_MODER8_Pos            (16U)
+#define GPIO_MODER_MODER8_Msk            (0x3UL << GPIO_MODER_MODER8_Pos)
+#define GPIO_MODER_MODER8                GPIO_MODER_MODER8_Msk
+#define GPIO_MODER_MODER9_Pos            (18U)
+#define GPIO_MODER_MODER9_Msk            (0x3UL << GPIO_MODER_MODER9_Pos)
+#define GPIO_MODER_MODER9                GPIO_MODER_MODER9_Msk
+#define GPIO_OSPEEDR_OSPEED8_Pos         (16U)
+#define GPIO_OSPEEDR_OSPEED8_Msk         (0x3UL << GPIO_OSPEEDR_OSPEED8_Pos)
+#define GPIO_OSPEEDR_OSPEED8             GPIO_OSPEEDR_OSPEED8_Msk
+#define GPIO_OSPEEDR_OSPEED9_Pos         (18U)
+#define GPIO_OSPEEDR_OSPEED9_Msk         (0x3UL << GPIO_OSPEEDR_OSPEED9_Pos)
+#define GPIO_OSPEEDR_OSPEED9             GPIO_OSPEEDR_OSPEED9_Msk
+
+#define FLASH_ACR_LATENCY_Pos            (0U)
+#define FLASH_ACR_LATENCY_Msk            (0x7UL << FLASH_ACR_LATENCY_Pos)
+#define FLASH_ACR_LATENCY                FLASH_ACR_LATENCY_Msk
+#define FLASH_ACR_PRFTEN_Pos             (8U)
+#define FLASH_ACR_PRFTEN_Msk             (0x1UL << FLASH_ACR_PRFTEN_Pos)
+#define FLASH_ACR_PRFTEN                 FLASH_ACR_PRFTEN_Msk
+#define FLASH_ACR_ICEN_Pos               (9U)
+#define FLASH_ACR_ICEN_Msk               (0x1UL << FLASH_ACR_ICEN_Pos)
+#define FLASH_ACR_ICEN                   FLASH_ACR_ICEN_Msk
+#define FLASH_ACR_DCEN_Pos               (10U)
+#define FLASH_ACR_DCEN_Msk               (0x1UL << FLASH_ACR_DCEN_Pos)
+#define FLASH_ACR_DCEN                   FLASH_ACR_DCEN_Msk
+
+#endif /* __STM32F407xx_H */
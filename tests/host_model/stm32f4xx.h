@@ -0,0 +1,13 @@
+/*******************************************************************************
+ * File Name: stm32f4xx.h
+ *
+ * Description:
+ * Host (Linux) stand-in of the STM32F4xx device header, see host_model.c.
+ *
+ *******************************************************************************/
+#ifndef HOST_MODEL_STM32F4XX_H
+#define HOST_MODEL_STM32F4XX_H
+
+#include "stm32f407xx.h"
+
+#endif /* HOST_MODEL_STM32F4XX_H */
@@ -0,0 +1,290 @@
+/*******************************************************************************
+ * File Name: timer_wheel_host_test.c
+ *
+ * Description:
+ * Host test (Linux) of the timer wheel core of libs/timer_wheel_stm32f407_lib,
+ * on a simulated clock. Random starts, stops and advances are checked against
+ * a brute force model of the timers:
+ *  - a timer never expires before its expiry, nor is missed by an advance
+ *  - the timers expire in the order of expiry within an advance
+ *  - timer_wheel_next() is never later than the earliest expiry
+ *  - driven from timer_wheel_next() like a compare interrupt, each timer
+ *    expires exactly at its expiry
+ *  - a callback can restart its own timer
+ * The rounds run at random wheel times, including near the end of the 64-bit
+ * range.
+ *
+ * Related Document: See README.md
+ *
+ *******************************************************************************/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "timer_wheel_aj_stm32f4.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+#define TEST_TIMER_CNT                      (64U)
+#define TEST_ROUNDS                         (200U)
+#define TEST_STEPS                          (5000U)
+
+/* Period of the timers which restart themselves from the callback */
+#define TEST_PERIODIC_TICKS                 (1000U)
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+/* Model of a timer, next to the timer of the wheel */
+typedef struct test_timer_st
+{
+    timer_wheel_timer_st_t tmr;
+    uint64_t expiry;
+    int running;
+    int periodic;
+} test_timer_st_t;
+
+static timer_wheel_st_t test_wheel;
+static test_timer_st_t test_timers[TEST_TIMER_CNT];
+
+/* Simulated clock, the time the wheel is advanced to */
+static uint64_t test_now = 0;
+/* Expiry of the last callback in the current advance */
+static uint64_t test_last_expiry = 0;
+/* 1 when the clock is driven by timer_wheel_next(), the expiry must be exact */
+static int test_exact = 0;
+
+static uint32_t fail_cnt = 0;
+static uint32_t expire_cnt = 0;
+
+/*******************************************************************************
+ * Function Name: check()
+ ********************************************************************************
+ * Summary:
+ *   Counts and reports a failed check, only the first few are printed.
+ *
+ *******************************************************************************/
+static void check(int cond, const char *what, uint32_t idx)
+{
+    if (!cond)
+    {
+        if (fail_cnt < 10U)
+        {
+            printf("FAIL: %s, timer %u, now %llu\n", what, (unsigned int)idx,
+                   (unsigned long long)test_now);
+        }
+        fail_cnt++;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: rand64()
+ ********************************************************************************
+ * Summary:
+ *   Returns a 64-bit pseudo random value.
+ *
+ *******************************************************************************/
+static uint64_t rand64(void)
+{
+    return ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+}
+
+/*******************************************************************************
+ * Function Name: rand_delay()
+ ********************************************************************************
+ * Summary:
+ *   Returns a delay from the current time, mostly short, at times up to 2^40
+ *   ticks, which does not run past the end of the 64-bit time.
+ *
+ *******************************************************************************/
+static uint64_t rand_delay(void)
+{
+    uint64_t delay = 0;
+
+    switch (rand() % 4)
+    {
+    case 0:
+        delay = (uint64_t)(rand() % 70);
+        break;
+    case 1:
+        delay = (uint64_t)(rand() % 5000);
+        break;
+    case 2:
+        delay = rand64() % ((uint64_t)1 << (rand() % 40));
+        break;
+    default:
+        delay = 0;
+        break;
+    }
+
+    return ((test_now + delay) < test_now) ? (0U) : (delay);
+}
+
+/*******************************************************************************
+ * Function Name: test_cb()
+ ********************************************************************************
+ * Summary:
+ *   Expiry callback, checks the expiry against the model, and restarts the
+ *   periodic timers.
+ *
+ *******************************************************************************/
+static void test_cb(timer_wheel_timer_st_t *tmr, void *cb_arg)
+{
+    uint32_t idx = (uint32_t)(uintptr_t)cb_arg;
+    test_timer_st_t *t = &test_timers[idx];
+
+    check(&t->tmr == tmr, "callback of another timer", idx);
+    check(t->running, "stopped timer expired", idx);
+    check(t->expiry <= test_now, "expired early", idx);
+    check(!test_exact || (t->expiry == test_now), "expiry not exact", idx);
+    check(t->expiry >= test_last_expiry, "expired out of order", idx);
+    check(!timer_wheel_is_running(tmr), "running in its callback", idx);
+
+    test_last_expiry = t->expiry;
+    t->running = 0;
+    expire_cnt++;
+
+    if (t->periodic && ((test_now + TEST_PERIODIC_TICKS) > test_now))
+    {
+        t->expiry = test_now + TEST_PERIODIC_TICKS;
+        t->running = 1;
+        timer_wheel_start(&test_wheel, tmr, t->expiry);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: test_advance()
+ ********************************************************************************
+ * Summary:
+ *   Checks timer_wheel_next() against the model, advances the wheel and checks
+ *   that no timer due is left running.
+ *
+ *******************************************************************************/
+static void test_advance(uint64_t target)
+{
+    uint64_t next = 0, earliest = UINT64_MAX;
+    int any = 0;
+    uint32_t i = 0;
+
+    for (i = 0; i < TEST_TIMER_CNT; i++)
+    {
+        if (test_timers[i].running)
+        {
+            any = 1;
+            earliest = (test_timers[i].expiry < earliest) ? (test_timers[i].expiry) : (earliest);
+        }
+    }
+
+    check(timer_wheel_next(&test_wheel, &next) == (any != 0), "next with no timer", 0);
+    check(!any || (next <= earliest), "next later than the earliest expiry", 0);
+
+    test_now = target;
+    test_last_expiry = 0;
+    timer_wheel_advance(&test_wheel, target);
+
+    for (i = 0; i < TEST_TIMER_CNT; i++)
+    {
+        if (test_timers[i].running && (test_timers[i].expiry <= test_now))
+        {
+            check(0, "expiry missed", i);
+            test_timers[i].running = 0;
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: test_round()
+ ********************************************************************************
+ * Summary:
+ *   Runs random operations on a new wheel at the specified time. In the exact
+ *   mode the clock only moves to the time of timer_wheel_next().
+ *
+ *******************************************************************************/
+static void test_round(uint64_t base, int exact)
+{
+    uint64_t next = 0, delay = 0;
+    uint32_t step = 0, i = 0;
+
+    timer_wheel_init(&test_wheel, base);
+    test_now = base;
+    test_exact = exact;
+
+    for (i = 0; i < TEST_TIMER_CNT; i++)
+    {
+        timer_wheel_timer_init(&test_timers[i].tmr, test_cb, (void *)(uintptr_t)i);
+        test_timers[i].running = 0;
+        test_timers[i].periodic = (0U == (i % 8U));
+    }
+
+    for (step = 0; step < TEST_STEPS; step++)
+    {
+        i = (uint32_t)rand() % TEST_TIMER_CNT;
+
+        switch (rand() % 4)
+        {
+        case 0:
+            test_timers[i].expiry = test_now + rand_delay();
+            test_timers[i].running = 1;
+            timer_wheel_start(&test_wheel, &test_timers[i].tmr, test_timers[i].expiry);
+            break;
+        case 1:
+            timer_wheel_stop(&test_wheel, &test_timers[i].tmr);
+            test_timers[i].running = 0;
+            break;
+        default:
+            if (exact)
+            {
+                if (timer_wheel_next(&test_wheel, &next))
+                {
+                    test_advance((next > test_now) ? (next) : (test_now));
+                }
+            }
+            else
+            {
+                delay = (0 == (rand() % 4)) ? (rand64() % ((uint64_t)1 << (rand() % 36))) :
+                                              ((uint64_t)(rand() % 200));
+                test_advance(((test_now + delay) < test_now) ? (test_now) : (test_now + delay));
+            }
+            break;
+        }
+
+        for (i = 0; i < TEST_TIMER_CNT; i++)
+        {
+            check(timer_wheel_is_running(&test_timers[i].tmr) == test_timers[i].running,
+                  "running state", i);
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: main()
+ ********************************************************************************
+ * Summary:
+ *   Runs the rounds, a third of them near the end of the 64-bit time.
+ *
+ *******************************************************************************/
+int main(void)
+{
+    uint64_t base = 0;
+    uint32_t round = 0;
+
+    srand(1);
+
+    for (round = 0; round < TEST_ROUNDS; round++)
+    {
+        base = (0U == (round % 3U)) ? (UINT64_MAX - (rand64() % 1000000U) - 5000000U) :
+                                      (rand64() >> (rand() % 64));
+
+        test_round(base, (int)(round % 2U));
+    }
+
+    check(0U != expire_cnt, "no timer expired", 0);
+
+    printf("timer_wheel_host_test: %u expiries, %s\n", (unsigned int)expire_cnt,
+           (0U == fail_cnt) ? ("PASS") : ("FAIL"));
+
+    return (0U == fail_cnt) ? (0) : (1);
+}
+
+/* End of File */
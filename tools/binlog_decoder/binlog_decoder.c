@@ -0,0 +1,416 @@
+/*******************************************************************************
+ * File Name: binlog_decoder.c
+ *
+ * Description:
+ * Host tool (Linux) for the deferred binary log of libs/retarget_stdio. Reads
+ * the COBS framed records captured from the UART, looks up the format string
+ * of each record in the ELF image (.axf) of the application and prints the
+ * formatted text.
+ *
+ * Usage: binlog_decoder <app.axf> [capture.bin]
+ *        the records are read from stdin if no capture file is given.
+ *
+ * Related Document: See README.md
+ *
+ *******************************************************************************/
+#include <elf.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cobs_aj_stm32f4.h"
+
+/*******************************************************************************
+ * Macros
+ *******************************************************************************/
+/* Max size of a decoded record, larger than any record of the target */
+#define BINLOG_RECORD_BUFF_SIZE             (256U)
+/* Max size of a single conversion specification, ex: "%-08.3f" */
+#define BINLOG_SPEC_MAX_SIZE                (32U)
+
+/*******************************************************************************
+ * Global Variables
+ *******************************************************************************/
+/* Loadable section of the ELF image, with data in the file */
+typedef struct elf_section_st
+{
+    uint32_t addr;
+    uint32_t size;
+    const uint8_t *data;
+} elf_section_st_t;
+
+static uint8_t *elf_image = NULL;
+static elf_section_st_t *elf_sections = NULL;
+static uint32_t elf_section_cnt = 0;
+
+static uint32_t bad_record_cnt = 0;
+
+/*******************************************************************************
+ * Function Name: file_read_all()
+ ********************************************************************************
+ * Summary:
+ *   Reads a whole file into a heap buffer.
+ *
+ * Parameters:
+ *   path:           Path of the file
+ *   size:           Returns the size of the file
+ *
+ * Return :
+ *   uint8_t *:      File data, NULL on failure
+ *
+ *******************************************************************************/
+static uint8_t *file_read_all(const char *path, size_t *size)
+{
+    FILE *fp = fopen(path, "rb");
+    uint8_t *data = NULL;
+    long len = 0;
+
+    if (NULL == fp)
+    {
+        return NULL;
+    }
+
+    if ((0 == fseek(fp, 0, SEEK_END)) && ((len = ftell(fp)) > 0) && (0 == fseek(fp, 0, SEEK_SET)))
+    {
+        data = malloc((size_t)len);
+        if ((NULL != data) && (fread(data, 1, (size_t)len, fp) != (size_t)len))
+        {
+            free(data);
+            data = NULL;
+        }
+    }
+
+    fclose(fp);
+    *size = (size_t)len;
+
+    return data;
+}
+
+/*******************************************************************************
+ * Function Name: elf_load()
+ ********************************************************************************
+ * Summary:
+ *   Loads the ELF image and builds the table of the loadable sections which
+ *   hold data, the format strings are looked up in these by address.
+ *
+ * Parameters:
+ *   path:           Path of the ELF image
+ *
+ * Return :
+ *   int:            0 on success
+ *
+ *******************************************************************************/
+static int elf_load(const char *path)
+{
+    size_t size = 0;
+    const Elf32_Ehdr *ehdr = NULL;
+    const Elf32_Shdr *shdr = NULL;
+    uint32_t i = 0;
+
+    elf_image = file_read_all(path, &size);
+    if (NULL == elf_image)
+    {
+        fprintf(stderr, "binlog_decoder: can't read %s\n", path);
+        return -1;
+    }
+
+    ehdr = (const Elf32_Ehdr *)elf_image;
+
+    if ((size < sizeof(Elf32_Ehdr)) || (0 != memcmp(ehdr->e_ident, ELFMAG, SELFMAG)) ||
+        (ELFCLASS32 != ehdr->e_ident[EI_CLASS]) || (ELFDATA2LSB != ehdr->e_ident[EI_DATA]) ||
+        (ehdr->e_shoff + ((size_t)ehdr->e_shnum * sizeof(Elf32_Shdr)) > size))
+    {
+        fprintf(stderr, "binlog_decoder: %s is not a 32-bit little endian ELF\n", path);
+        return -1;
+    }
+
+    elf_sections = calloc(ehdr->e_shnum, sizeof(elf_section_st_t));
+    if (NULL == elf_sections)
+    {
+        return -1;
+    }
+
+    shdr = (const Elf32_Shdr *)(elf_image + ehdr->e_shoff);
+
+    for (i = 0; i < ehdr->e_shnum; i++)
+    {
+        if ((SHT_PROGBITS == shdr[i].sh_type) && (shdr[i].sh_flags & SHF_ALLOC) &&
+            ((size_t)shdr[i].sh_offset + shdr[i].sh_size <= size))
+        {
+            elf_sections[elf_section_cnt].addr = shdr[i].sh_addr;
+            elf_sections[elf_section_cnt].size = shdr[i].sh_size;
+            elf_sections[elf_section_cnt].data = elf_image + shdr[i].sh_offset;
+            elf_section_cnt++;
+        }
+    }
+
+    return 0;
+}
+
+/*******************************************************************************
+ * Function Name: elf_string_at()
+ ********************************************************************************
+ * Summary:
+ *   Returns the string at a target address, if it is inside a loadable section
+ *   of the ELF image and terminated inside the section.
+ *
+ * Parameters:
+ *   addr:           Target address of the string
+ *
+ * Return :
+ *   const char *:   The string, NULL if not found
+ *
+ *******************************************************************************/
+static const char *elf_string_at(uint32_t addr)
+{
+    uint32_t i = 0, offset = 0;
+
+    for (i = 0; i < elf_section_cnt; i++)
+    {
+        if ((addr >= elf_sections[i].addr) && ((addr - elf_sections[i].addr) < elf_sections[i].size))
+        {
+            offset = addr - elf_sections[i].addr;
+
+            if (NULL != memchr(&elf_sections[i].data[offset], '\0', elf_sections[i].size - offset))
+            {
+                return (const char *)&elf_sections[i].data[offset];
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+ * Function Name: print_arg()
+ ********************************************************************************
+ * Summary:
+ *   Prints one argument word with a conversion specification of the format
+ *   string. The length modifiers are dropped as all arguments are 32-bit words.
+ *
+ * Parameters:
+ *   spec:           Conversion specification without length modifiers
+ *   conv:           Conversion character
+ *   arg:            Argument word
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void print_arg(const char *spec, char conv, uint32_t arg)
+{
+    union
+    {
+        uint32_t u;
+        float f;
+    } conv_f;
+    const char *str = NULL;
+
+    switch (conv)
+    {
+    case 'd':
+    case 'i':
+    case 'c':
+        printf(spec, (int)(int32_t)arg);
+        break;
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+        printf(spec, (unsigned int)arg);
+        break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+        conv_f.u = arg;
+        printf(spec, (double)conv_f.f);
+        break;
+    case 's':
+        str = elf_string_at(arg);
+        if (NULL != str)
+        {
+            printf(spec, str);
+        }
+        else
+        {
+            printf("<str@0x%08x>", (unsigned int)arg);
+        }
+        break;
+    case 'p':
+        printf("0x%08x", (unsigned int)arg);
+        break;
+    default:
+        printf("<%%%c?>", conv);
+        break;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: print_record()
+ ********************************************************************************
+ * Summary:
+ *   Formats a record, each conversion of the format string consumes one
+ *   argument word of the record.
+ *
+ * Parameters:
+ *   fmt:            Format string of the record
+ *   args:           Argument words
+ *   argc:           Number of argument words
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void print_record(const char *fmt, const uint32_t *args, uint32_t argc)
+{
+    char spec[BINLOG_SPEC_MAX_SIZE];
+    uint32_t arg_idx = 0, len = 0;
+
+    while ('\0' != *fmt)
+    {
+        if ('%' != *fmt)
+        {
+            putchar(*fmt++);
+            continue;
+        }
+
+        if ('%' == fmt[1])
+        {
+            putchar('%');
+            fmt += 2;
+            continue;
+        }
+
+        /* Copy flags, width and precision, skip the length modifiers */
+        len = 0;
+        spec[len++] = *fmt++;
+        while (('\0' != *fmt) && (NULL != strchr("-+ #0123456789.", *fmt)) &&
+               (len < (BINLOG_SPEC_MAX_SIZE - 2U)))
+        {
+            spec[len++] = *fmt++;
+        }
+        while (('\0' != *fmt) && (NULL != strchr("hlLqjzt", *fmt)))
+        {
+            fmt++;
+        }
+
+        if ('\0' == *fmt)
+        {
+            break;
+        }
+
+        spec[len++] = *fmt;
+        spec[len] = '\0';
+
+        if (arg_idx < argc)
+        {
+            print_arg(spec, *fmt, args[arg_idx++]);
+        }
+        else
+        {
+            printf("<missing>");
+        }
+
+        fmt++;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: record_cb()
+ ********************************************************************************
+ * Summary:
+ *   Called by the COBS decoder with each record.
+ *
+ * Parameters:
+ *   cb_arg:         Not used
+ *   frame:          Decoded record
+ *   frame_size:     Size of the record
+ *
+ * Return :
+ *   void
+ *
+ *******************************************************************************/
+static void record_cb(void *cb_arg, uint8_t *frame, uint16_t frame_size)
+{
+    uint32_t words[BINLOG_RECORD_BUFF_SIZE / 4U];
+    uint32_t word_cnt = frame_size / 4U, i = 0;
+    const char *fmt = NULL;
+
+    (void)cb_arg;
+
+    if ((0U == word_cnt) || (0U != (frame_size % 4U)))
+    {
+        bad_record_cnt++;
+        return;
+    }
+
+    /* Records are little endian, independent of the host */
+    for (i = 0; i < word_cnt; i++)
+    {
+        words[i] = (uint32_t)frame[4U * i] | ((uint32_t)frame[4U * i + 1U] << 8) |
+                   ((uint32_t)frame[4U * i + 2U] << 16) | ((uint32_t)frame[4U * i + 3U] << 24);
+    }
+
+    fmt = elf_string_at(words[0]);
+    if (NULL == fmt)
+    {
+        printf("<unknown format 0x%08x>\n", (unsigned int)words[0]);
+        return;
+    }
+
+    print_record(fmt, &words[1], word_cnt - 1U);
+    fflush(stdout);
+}
+
+/*******************************************************************************
+ * Function Name: main()
+ ********************************************************************************
+ * Summary:
+ *   Decodes the records from the capture file or stdin till the end of input.
+ *
+ *******************************************************************************/
+int main(int argc, char **argv)
+{
+    static uint8_t record_buff[BINLOG_RECORD_BUFF_SIZE];
+    cobs_decoder_st_t dec;
+    FILE *in = stdin;
+    int ch = 0;
+
+    if ((argc < 2) || (argc > 3))
+    {
+        fprintf(stderr, "usage: %s <app.axf> [capture.bin]\n", argv[0]);
+        return 2;
+    }
+
+    if (0 != elf_load(argv[1]))
+    {
+        return 1;
+    }
+
+    if ((3 == argc) && (NULL == (in = fopen(argv[2], "rb"))))
+    {
+        fprintf(stderr, "binlog_decoder: can't open %s\n", argv[2]);
+        return 1;
+    }
+
+    cobs_decoder_init(&dec, record_buff, sizeof(record_buff), record_cb, NULL);
+
+    while (EOF != (ch = fgetc(in)))
+    {
+        cobs_decode_byte(&dec, (uint8_t)ch);
+    }
+
+    if ((0U != dec.err_cnt) || (0U != bad_record_cnt))
+    {
+        fprintf(stderr, "binlog_decoder: %u bad frames, %u bad records\n",
+                (unsigned int)dec.err_cnt, (unsigned int)bad_record_cnt);
+    }
+
+    return 0;
+}
+
+/* End of File */